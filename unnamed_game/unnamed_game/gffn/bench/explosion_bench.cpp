@@ -0,0 +1,129 @@
+// Explosion benchmark: 100 explosions in the same tick over a crowd of 20k goblins.
+// Runs GFFN_ExplosionSystem (grid cells + vectorized falloff) against a brute force pass over every NPC, which is what
+// resolving an explosion without the grid would cost.
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_explosions.h>
+#include <gffn_frame_arena.h>
+#include <gffn_game_object.h>
+#include <gffn_game_world_objects.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int NUM_NPCS = 20000;
+constexpr int NUM_EXPLOSIONS = 100;
+constexpr int NUM_ROUNDS = 50;
+constexpr int BLAST_RADIUS = 250;
+constexpr double CROWD_MIN = 1000;
+constexpr double CROWD_MAX = 9000;
+
+// Same falloff as GFFN_ExplosionSystem, one NPC at a time, over everything.
+std::size_t brute_force_explosion(std::vector<gffn::GFFN_NPC*> const& npcs, gffn::events::ExplosionEvent& explosion) {
+	std::size_t num_hits = 0;
+	for (gffn::GFFN_NPC* npc : npcs) {
+		gffn::WorldCoordinate coords = npc->get_floor_coords();
+		double dx = coords.x - explosion.coordinates.x;
+		double dy = coords.y - explosion.coordinates.y;
+		double distance = std::sqrt(dx * dx + dy * dy);
+		if (distance > explosion.blast_radius) {
+			continue;
+		}
+		double t = 1.0 - distance / explosion.blast_radius;
+		int damage = explosion.min_damage + (int)((explosion.power - explosion.min_damage) * t);
+		npc->change_hp(-damage);
+		explosion.objects_hit.push_back(gffn::events::ExplosionHit{ npc->get_object_id(), npc->get_object_type(), damage, npc->is_dead() });
+		num_hits++;
+	}
+	return num_hits;
+}
+
+std::vector<gffn::events::ExplosionEvent> make_explosions(std::mt19937& gen) {
+	std::uniform_real_distribution<> coord(CROWD_MIN, CROWD_MAX);
+	std::vector<gffn::events::ExplosionEvent> explosions;
+	for (int i = 0; i < NUM_EXPLOSIONS; i++) {
+		// Power 0 so nobody dies and every round hits the same crowd.
+		explosions.push_back(gffn::events::ExplosionEvent{ gffn::WorldCoordinate(coord(gen), coord(gen), 0), 0, BLAST_RADIUS, 0, {} });
+	}
+	return explosions;
+}
+
+} // end anonymous namespace
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+	SDL_Surface* target_surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA8888);
+	SDL_Renderer* renderer = SDL_CreateSoftwareRenderer(target_surface);
+	if (renderer == nullptr) {
+		std::printf("Error creating software renderer : %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	SDL_Texture* goblin_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	SDL_Texture* shadow_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<> crowd_coord(CROWD_MIN, CROWD_MAX);
+	gffn::GameWorldObjects objects;
+	std::vector<gffn::GFFN_NPC*> npcs;
+	for (int i = 0; i < NUM_NPCS; i++) {
+		gffn::NPC_info npc_info;
+		npc_info.floor_coords = gffn::WorldCoordinate(crowd_coord(gen), crowd_coord(gen), 0);
+		npc_info.animation_texture = goblin_texture;
+		npc_info.shadow_texture = shadow_texture;
+		gffn::GFFN_PooledPtr<gffn::GFFN_NPC> npc = gffn::make_pooled_object<gffn::GFFN_NPC>(npc_info);
+		// Just the grid part of the tick, to put it in world_grid.
+		npc->gffn::GFFN_GridObject::tick(1.0 / 60.0);
+		npcs.push_back(npc.get());
+		objects.add_object(std::move(npc));
+	}
+
+	gffn::GFFN_ExplosionSystem explosion_system;
+	double grid_ms = 0;
+	double brute_force_ms = 0;
+	std::size_t grid_hits = 0;
+	std::size_t brute_force_hits = 0;
+	std::size_t num_candidates = 0;
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		std::vector<gffn::events::ExplosionEvent> explosions = make_explosions(gen);
+		std::vector<gffn::events::ExplosionEvent> brute_force_explosions = explosions;
+
+		explosion_system.begin_frame();
+		auto start_time = std::chrono::high_resolution_clock::now();
+		for (gffn::events::ExplosionEvent& explosion : explosions) {
+			explosion_system.process(explosion);
+		}
+		auto end_time = std::chrono::high_resolution_clock::now();
+		grid_ms += std::chrono::duration<double, std::milli>(end_time - start_time).count();
+		grid_hits += explosion_system.get_num_hits_last_frame();
+		num_candidates += explosion_system.get_num_candidates_last_frame();
+
+		start_time = std::chrono::high_resolution_clock::now();
+		for (gffn::events::ExplosionEvent& explosion : brute_force_explosions) {
+			brute_force_hits += brute_force_explosion(npcs, explosion);
+		}
+		end_time = std::chrono::high_resolution_clock::now();
+		brute_force_ms += std::chrono::duration<double, std::milli>(end_time - start_time).count();
+
+		explosions.clear();
+		brute_force_explosions.clear();
+		gffn::frame_arena.reset();
+	}
+
+	std::printf("%d explosions (radius %d) over %d NPCs, %d rounds\n", NUM_EXPLOSIONS, BLAST_RADIUS, NUM_NPCS, NUM_ROUNDS);
+	std::printf("explosion system: %.3f ms per tick, %.1f candidates and %.1f hits per explosion\n", grid_ms / NUM_ROUNDS,
+		(double)num_candidates / (NUM_ROUNDS * NUM_EXPLOSIONS), (double)grid_hits / (NUM_ROUNDS * NUM_EXPLOSIONS));
+	std::printf("brute force:      %.3f ms per tick, %.1f hits per explosion\n", brute_force_ms / NUM_ROUNDS,
+		(double)brute_force_hits / (NUM_ROUNDS * NUM_EXPLOSIONS));
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(target_surface);
+	// Both have to find the same NPCs.
+	return grid_hits == brute_force_hits ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+// Level loading benchmark. Writes a level with a lot of trees, some NPCs and a ground tile in every cell, then fills a
+// headless world twice: once the way main used to (an RNG call, texture lookups by name and add_object per object) and
+// once from the level file with GFFN_GameWorld::load_level.
+//
+//   gffn_level_bench [--objects <n>] [--npcs <n>] [--file <level path>]
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_game_world.h>
+#include <gffn_level.h>
+#include <gffn_random.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace {
+
+constexpr double MAP_MIN = 100;
+constexpr double MAP_MAX = gffn::WORLD_GRID_WIDTH * 99.0;
+
+const std::string TREE_TEXTURE = "textures/alexs_pine_tree.png";
+const std::string SMALL_SHADOW_TEXTURE = "textures/small_shadow.png";
+const std::string GOBLIN_TEXTURE = "textures/goblin/goblin_1.png";
+const std::string CHARACTER_SHADOW_TEXTURE = "textures/character_shadow.png";
+const std::string GROUND_TEXTURE = "textures/ground_yellow_flowers.png";
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void write_level(std::string const& filename, int num_static_objects, int num_npcs) {
+	gffn::GFFN_LevelWriter writer;
+	std::uint16_t tree = writer.add_texture(TREE_TEXTURE);
+	std::uint16_t small_shadow = writer.add_texture(SMALL_SHADOW_TEXTURE);
+	std::uint16_t goblin = writer.add_texture(GOBLIN_TEXTURE);
+	std::uint16_t character_shadow = writer.add_texture(CHARACTER_SHADOW_TEXTURE);
+	std::uint16_t ground = writer.add_texture(GROUND_TEXTURE);
+	for (int i = 0; i < num_static_objects; i++) {
+		writer.add_static_object(gffn::WorldCoordinate(gffn::random::range(MAP_MIN, MAP_MAX), gffn::random::range(MAP_MIN, MAP_MAX), 0),
+			tree, small_shadow);
+	}
+	for (int i = 0; i < num_npcs; i++) {
+		writer.add_npc(gffn::WorldCoordinate(gffn::random::range(MAP_MIN, MAP_MAX), gffn::random::range(MAP_MIN, MAP_MAX), 0),
+			goblin, character_shadow, gffn::GFFN_CharacterType::GFFN_GOBLIN_1);
+	}
+	for (int x = 0; x < gffn::WORLD_GRID_WIDTH; x++) {
+		for (int y = 0; y < gffn::WORLD_GRID_HEIGHT; y++) {
+			writer.add_ground_tile(x, y, ground);
+		}
+	}
+	if (!writer.write(filename)) {
+		std::printf("Couldn't write %s\n", filename.c_str());
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+// What main did before levels: everything placed and added one at a time.
+double populate_one_by_one(gffn::GFFN_GameWorld& world, gffn::GFFN_Renderer& renderer, int num_static_objects, int num_npcs) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_static_objects; i++) {
+		double x = gffn::random::range(MAP_MIN, MAP_MAX);
+		double y = gffn::random::range(MAP_MIN, MAP_MAX);
+		gffn::GFFN_ObjectPtr tree = gffn::make_pooled_object<gffn::GFFN_EnvironmentalObject>(gffn::WorldCoordinate(x, y, 0),
+			renderer.get_texture(TREE_TEXTURE), renderer.get_texture(SMALL_SHADOW_TEXTURE));
+		world.add_object(tree);
+	}
+	for (int i = 0; i < num_npcs; i++) {
+		gffn::NPC_info npc_info;
+		npc_info.floor_coords = gffn::WorldCoordinate(gffn::random::range(MAP_MIN, MAP_MAX), gffn::random::range(MAP_MIN, MAP_MAX), 0);
+		npc_info.animation_texture = renderer.get_texture(GOBLIN_TEXTURE);
+		npc_info.shadow_texture = renderer.get_texture(CHARACTER_SHADOW_TEXTURE);
+		npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
+		gffn::GFFN_ObjectPtr npc = gffn::make_pooled_object<gffn::GFFN_NPC>(npc_info);
+		world.add_object(npc);
+	}
+	return ms_since(start);
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+	int num_objects = 1000000;
+	int num_npcs = 10000;
+	std::string filename = "gffn_bench_level.bin";
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		if (std::strcmp(argv[i], "--objects") == 0 && has_value) {
+			num_objects = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--npcs") == 0 && has_value) {
+			num_npcs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--file") == 0 && has_value) {
+			filename = argv[++i];
+		}
+		else {
+			std::printf("Usage: %s [--objects <n>] [--npcs <n>] [--file <level path>]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	num_npcs = std::min(num_npcs, num_objects);
+	int num_static_objects = num_objects - num_npcs;
+
+	gffn::random::set_master_seed(1);
+	auto write_start = std::chrono::steady_clock::now();
+	write_level(filename, num_static_objects, num_npcs);
+	double write_ms = ms_since(write_start);
+
+	gffn::GFFN_Renderer renderer(std::string("gffn_level_bench"), true);
+	double one_by_one_ms;
+	{
+		gffn::GFFN_GameWorld world(renderer);
+		one_by_one_ms = populate_one_by_one(world, renderer, num_static_objects, num_npcs);
+	}
+
+	double map_ms;
+	double load_level_ms;
+	std::size_t num_loaded;
+	std::size_t file_size;
+	{
+		gffn::GFFN_GameWorld world(renderer);
+		auto map_start = std::chrono::steady_clock::now();
+		gffn::GFFN_Level level;
+		if (!level.load(filename)) {
+			std::printf("Couldn't open %s\n", filename.c_str());
+			return EXIT_FAILURE;
+		}
+		map_ms = ms_since(map_start);
+		auto load_start = std::chrono::steady_clock::now();
+		num_loaded = world.load_level(level);
+		load_level_ms = ms_since(load_start);
+		file_size = level.get_file_size();
+		if (world.num_environmental_objects != num_static_objects || world.num_npcs != num_npcs) {
+			std::printf("Loaded %d static objects and %d NPCs, expected %d and %d\n", world.num_environmental_objects, world.num_npcs,
+				num_static_objects, num_npcs);
+			return EXIT_FAILURE;
+		}
+	}
+	std::remove(filename.c_str());
+
+	std::printf("level: %d static objects, %d NPCs, %d ground tiles, %.1f MB, written in %.1f ms\n", num_static_objects, num_npcs,
+		gffn::WORLD_GRID_WIDTH * gffn::WORLD_GRID_HEIGHT, file_size / (1024.0 * 1024.0), write_ms);
+	std::printf("one by one:  %9.1f ms, %6.1f ns per object\n", one_by_one_ms, one_by_one_ms * 1e6 / num_objects);
+	std::printf("level file:  %9.1f ms (map and check %.1f ms, load_level %.1f ms), %6.1f ns per object\n", map_ms + load_level_ms,
+		map_ms, load_level_ms, (map_ms + load_level_ms) * 1e6 / std::max<std::size_t>(num_loaded, 1));
+	return EXIT_SUCCESS;
+}
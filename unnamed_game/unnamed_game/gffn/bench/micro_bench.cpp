@@ -0,0 +1,310 @@
+// Microbenchmarks for the small things the sim does thousands of times a tick: vector math, distance checks,
+// physics controller ticks, world_grid bookkeeping and adding/removing objects from GameWorldObjects.
+// Sizes are about what a busy scene has: 2000 movers spread over the middle of the map, a few per grid cell.
+//
+//   gffn_microbench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--json]
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include "microbench.h"
+
+#include <gffn_game_object.h>
+#include <gffn_game_world_objects.h>
+#include <gffn_physics.h>
+#include <gffn_pool.h>
+#include <gffn_utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using gffn::microbench::State;
+using gffn::microbench::do_not_optimize;
+
+constexpr int NUM_OBJECTS = 2000;
+constexpr int CROWDED_CELL_OBJECTS = 64;
+constexpr double DELTA_TIME_SECONDS = 1.0 / 60.0;
+
+SDL_Texture* tree_texture = nullptr;
+SDL_Texture* shadow_texture = nullptr;
+
+// The grid bookkeeping is protected, this opens it up for the benches.
+class BenchGridObject : public gffn::GFFN_EnvironmentalObject {
+public:
+	using GFFN_EnvironmentalObject::GFFN_EnvironmentalObject;
+	using GFFN_GridObject::update_grid_location_from_floor_coords;
+	using GFFN_GameObject::remove_from_curr_grid_location;
+	void set_physics_controller(gffn::physics::ObjectPhysicsController const& controller) {
+		physics_controller = controller;
+	}
+	std::pair<int, int> get_cell() const { return grid_location; }
+};
+
+std::vector<gffn::WorldCoordinate> make_coordinates(int count, unsigned seed) {
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<> coord(2000, 8000);
+	std::vector<gffn::WorldCoordinate> coordinates;
+	coordinates.reserve(count);
+	for (int i = 0; i < count; i++) {
+		coordinates.emplace_back(coord(gen), coord(gen), 0);
+	}
+	return coordinates;
+}
+
+} // end anonymous namespace
+
+GFFN_MICROBENCH(vector3d_from_coordinates) {
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> ends = make_coordinates(NUM_OBJECTS, 2);
+	for ([[maybe_unused]] auto _ : state) {
+		gffn::physics::Vector3D sum;
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			sum = sum + gffn::physics::Vector3D(starts[i], ends[i]);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+GFFN_MICROBENCH(normalized_vector3d_from_vector) {
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> ends = make_coordinates(NUM_OBJECTS, 2);
+	std::vector<gffn::physics::Vector3D> vectors;
+	for (int i = 0; i < NUM_OBJECTS; i++) {
+		vectors.emplace_back(starts[i], ends[i]);
+	}
+	for ([[maybe_unused]] auto _ : state) {
+		gffn::physics::Vector3D sum;
+		for (gffn::physics::Vector3D const& vector : vectors) {
+			sum = sum + gffn::physics::NormalizedVector3D(vector);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// What NPCs do every tick to face their target.
+GFFN_MICROBENCH(normalized_vector3d_from_coordinates) {
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> ends = make_coordinates(NUM_OBJECTS, 2);
+	for ([[maybe_unused]] auto _ : state) {
+		gffn::physics::Vector3D sum;
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			sum = sum + gffn::physics::NormalizedVector3D(starts[i], ends[i]);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+GFFN_MICROBENCH(world_coordinate_distance_from) {
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> ends = make_coordinates(NUM_OBJECTS, 2);
+	for ([[maybe_unused]] auto _ : state) {
+		double sum = 0;
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			sum += starts[i].distance_from(ends[i]);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+GFFN_MICROBENCH(world_coordinate_distance_from_squared_xy) {
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> ends = make_coordinates(NUM_OBJECTS, 2);
+	for ([[maybe_unused]] auto _ : state) {
+		double sum = 0;
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			sum += starts[i].distance_from_squared_xy(ends[i]);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// Every controller gets pushed every tick like a walking NPC, so none of them fall asleep.
+GFFN_MICROBENCH(physics_controller_tick) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::WorldCoordinate> targets = make_coordinates(NUM_OBJECTS, 2);
+	std::vector<gffn::physics::ObjectPhysicsController> controllers;
+	std::vector<gffn::physics::Vector3D> forces;
+	controllers.reserve(NUM_OBJECTS);
+	for (int i = 0; i < NUM_OBJECTS; i++) {
+		controllers.emplace_back(coordinates[i], 7);
+		forces.push_back(gffn::physics::NormalizedVector3D(coordinates[i], targets[i]) * 2000.0);
+	}
+	for ([[maybe_unused]] auto _ : state) {
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			controllers[i].add_force(forces[i]);
+			controllers[i].tick(DELTA_TIME_SECONDS);
+		}
+		gffn::microbench::clobber_memory();
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// The common case: the object moved but stayed in its cell.
+GFFN_MICROBENCH(grid_update_same_cell) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::GFFN_PooledPtr<BenchGridObject>> objects;
+	for (gffn::WorldCoordinate const& coordinate : coordinates) {
+		objects.push_back(gffn::make_pooled_object<BenchGridObject>(coordinate, tree_texture, shadow_texture));
+	}
+	for ([[maybe_unused]] auto _ : state) {
+		for (auto& object : objects) {
+			object->update_grid_location_from_floor_coords();
+		}
+		gffn::microbench::clobber_memory();
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// Every object hops back and forth between two neighbouring cells, so every update is a remove and a push_back.
+GFFN_MICROBENCH(grid_update_cell_change) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	std::vector<gffn::GFFN_PooledPtr<BenchGridObject>> objects;
+	std::vector<gffn::physics::ObjectPhysicsController> here;
+	std::vector<gffn::physics::ObjectPhysicsController> next_door;
+	for (gffn::WorldCoordinate const& coordinate : coordinates) {
+		objects.push_back(gffn::make_pooled_object<BenchGridObject>(coordinate, tree_texture, shadow_texture));
+		here.emplace_back(coordinate, 7);
+		next_door.emplace_back(gffn::WorldCoordinate(coordinate.x + 100, coordinate.y, 0), 7);
+	}
+	bool moved = false;
+	for ([[maybe_unused]] auto _ : state) {
+		moved = !moved;
+		std::vector<gffn::physics::ObjectPhysicsController> const& controllers = moved ? next_door : here;
+		for (int i = 0; i < NUM_OBJECTS; i++) {
+			objects[i]->set_physics_controller(controllers[i]);
+			objects[i]->update_grid_location_from_floor_coords();
+		}
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// Taking one object out of a packed cell (a crowd standing on one spot) and putting it back at the end.
+GFFN_MICROBENCH(grid_remove_from_crowded_cell) {
+	std::vector<gffn::GFFN_PooledPtr<BenchGridObject>> objects;
+	for (int i = 0; i < CROWDED_CELL_OBJECTS; i++) {
+		objects.push_back(gffn::make_pooled_object<BenchGridObject>(gffn::WorldCoordinate(5050 + (i % 8), 5050 + (i / 8), 0),
+			tree_texture, shadow_texture));
+	}
+	std::pair<int, int> cell = objects[0]->get_cell();
+	std::size_t next = 0;
+	for ([[maybe_unused]] auto _ : state) {
+		// Oldest first, so on average it's found halfway down the cell.
+		BenchGridObject* object = objects[next].get();
+		object->remove_from_curr_grid_location();
+		gffn::world_grid[cell.first][cell.second].push_back(object);
+		next = (next + 1) % objects.size();
+	}
+	state.set_items_processed(state.get_iterations());
+}
+
+namespace {
+
+std::vector<gffn::GFFN_ObjectPtr> spawn_objects(std::vector<gffn::WorldCoordinate> const& coordinates) {
+	std::vector<gffn::GFFN_ObjectPtr> spawned;
+	spawned.reserve(coordinates.size());
+	for (gffn::WorldCoordinate const& coordinate : coordinates) {
+		spawned.push_back(gffn::make_pooled_object<gffn::GFFN_EnvironmentalObject>(coordinate, tree_texture, shadow_texture));
+	}
+	return spawned;
+}
+
+} // end anonymous namespace
+
+// Object construction and removal are paused, only add_object is timed.
+GFFN_MICROBENCH(world_objects_add) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	gffn::GameWorldObjects objects;
+	std::vector<gffn::object_id_t> ids;
+	for ([[maybe_unused]] auto _ : state) {
+		state.pause_timing();
+		std::vector<gffn::GFFN_ObjectPtr> spawned = spawn_objects(coordinates);
+		ids.clear();
+		for (gffn::GFFN_ObjectPtr const& object : spawned) {
+			ids.push_back(object->get_object_id());
+		}
+		state.resume_timing();
+		for (gffn::GFFN_ObjectPtr& object : spawned) {
+			objects.add_object(std::move(object));
+		}
+		state.pause_timing();
+		for (gffn::object_id_t id : ids) {
+			objects.remove_object(id);
+		}
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// Removal by id in a random order, the way kills and expiring projectiles come in. Includes destroying the object.
+GFFN_MICROBENCH(world_objects_remove_by_id) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	gffn::GameWorldObjects objects;
+	std::vector<gffn::object_id_t> ids;
+	std::mt19937 gen(3);
+	for ([[maybe_unused]] auto _ : state) {
+		state.pause_timing();
+		ids.clear();
+		for (gffn::GFFN_ObjectPtr& object : spawn_objects(coordinates)) {
+			ids.push_back(object->get_object_id());
+			objects.add_object(std::move(object));
+		}
+		std::shuffle(ids.begin(), ids.end(), gen);
+		state.resume_timing();
+		for (gffn::object_id_t id : ids) {
+			objects.remove_object(id);
+		}
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS);
+}
+
+// Removal while walking the objects, the way tick_objects drops dead ones. Every other object goes.
+GFFN_MICROBENCH(world_objects_remove_by_iterator) {
+	std::vector<gffn::WorldCoordinate> coordinates = make_coordinates(NUM_OBJECTS, 1);
+	gffn::GameWorldObjects objects;
+	for ([[maybe_unused]] auto _ : state) {
+		state.pause_timing();
+		for (gffn::GFFN_ObjectPtr& object : spawn_objects(coordinates)) {
+			objects.add_object(std::move(object));
+		}
+		state.resume_timing();
+		bool remove = true;
+		for (auto it = objects.begin(); it != objects.end();) {
+			it = remove ? objects.remove_object(it) : it + 1;
+			remove = !remove;
+		}
+		state.pause_timing();
+		while (objects.begin() != objects.end()) {
+			objects.remove_object(objects.begin());
+		}
+		state.resume_timing();
+	}
+	state.set_items_processed(state.get_iterations() * NUM_OBJECTS / 2);
+}
+
+int main(int argc, char* argv[]) {
+	// No window, the textures only need to exist so the constructors can query their sizes.
+	SDL_Surface* target_surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA8888);
+	SDL_Renderer* renderer = SDL_CreateSoftwareRenderer(target_surface);
+	if (renderer == nullptr) {
+		std::printf("Error creating software renderer : %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	tree_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 40, 60);
+	shadow_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+
+	int result = gffn::microbench::run_main(argc, argv);
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(target_surface);
+	return result;
+}
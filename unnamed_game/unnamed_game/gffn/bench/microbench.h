@@ -0,0 +1,208 @@
+#pragma once
+
+// A tiny microbenchmark harness, just enough of the Google Benchmark shape that the benches read the same:
+//
+//	GFFN_MICROBENCH(vector_add) {
+//		for ([[maybe_unused]] auto _ : state) { ... }
+//		state.set_items_processed(state.get_iterations() * NUM_ITEMS);
+//	}
+//
+// Each bench is run with more and more iterations until one run takes at least min_time, then that count is
+// repeated a few times and the median is reported, so a stray context switch doesn't end up in the numbers.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace gffn { namespace microbench {
+
+// Makes the compiler think value is read, so the work that produced it can't be thrown away.
+template <class T>
+inline void do_not_optimize(T const& value) {
+#if defined(_MSC_VER)
+	static volatile const void* sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Makes the compiler forget what it knows about memory, so stores before it have to happen.
+inline void clobber_memory() {
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : : "memory");
+#endif
+}
+
+class State {
+	std::uint64_t iterations;
+	std::uint64_t items_processed = 0;
+	std::chrono::steady_clock::time_point start_time;
+	std::chrono::steady_clock::duration paused_time{};
+	std::chrono::steady_clock::time_point pause_start;
+	std::chrono::steady_clock::duration elapsed{};
+public:
+	explicit State(std::uint64_t iterations) : iterations(iterations) {}
+
+	// for ([[maybe_unused]] auto _ : state) runs the body get_iterations() times, timing only the loop.
+	struct Iterator {
+		std::uint64_t remaining;
+		State* state;
+		bool operator!=(Iterator const&) const {
+			if (remaining != 0) {
+				return true;
+			}
+			state->finish();
+			return false;
+		}
+		void operator++() { remaining--; }
+		int operator*() const { return 0; }
+	};
+	Iterator begin() {
+		start_time = std::chrono::steady_clock::now();
+		return Iterator{ iterations, this };
+	}
+	Iterator end() { return Iterator{ 0, this }; }
+
+	// For setup inside the loop that shouldn't be counted. Costs two clock reads, so keep it out of tiny loops.
+	void pause_timing() { pause_start = std::chrono::steady_clock::now(); }
+	void resume_timing() { paused_time += std::chrono::steady_clock::now() - pause_start; }
+
+	void finish() { elapsed = std::chrono::steady_clock::now() - start_time - paused_time; }
+
+	std::uint64_t get_iterations() const { return iterations; }
+	void set_items_processed(std::uint64_t items) { items_processed = items; }
+	std::uint64_t get_items_processed() const { return items_processed; }
+	double get_elapsed_ns() const { return std::chrono::duration<double, std::nano>(elapsed).count(); }
+};
+
+typedef void (*bench_function_t)(State&);
+
+typedef struct Bench {
+	const char* name;
+	bench_function_t function;
+} Bench;
+
+inline std::vector<Bench>& get_benches() {
+	static std::vector<Bench> benches;
+	return benches;
+}
+
+struct Registrar {
+	Registrar(const char* name, bench_function_t function) { get_benches().push_back(Bench{ name, function }); }
+};
+
+typedef struct Result {
+	std::string name;
+	std::uint64_t iterations;
+	double ns_per_iteration; // median of the repetitions
+	double min_ns_per_iteration;
+	double ns_per_item; // 0 if the bench doesn't set items
+} Result;
+
+typedef struct Options {
+	double min_time_seconds = 0.2;
+	int repetitions = 5;
+	std::string filter; // only benches with this in their name
+	bool json = false;
+} Options;
+
+inline Result run_bench(Bench const& bench, Options const& options) {
+	// Grow the iteration count until a run is long enough to time.
+	std::uint64_t iterations = 1;
+	double min_ns = options.min_time_seconds * 1e9;
+	for (;;) {
+		State state(iterations);
+		bench.function(state);
+		double ns = state.get_elapsed_ns();
+		if (ns >= min_ns || iterations >= (1ull << 40)) {
+			break;
+		}
+		// Aim a bit past min_time so the next run is usually the last, but never grow more than 10x at once.
+		double multiplier = ns > 0 ? std::min(10.0, min_ns * 1.4 / ns) : 10.0;
+		iterations = std::max(iterations + 1, (std::uint64_t)(iterations * multiplier));
+	}
+
+	std::vector<double> ns_per_iteration;
+	std::uint64_t items = 0;
+	for (int i = 0; i < std::max(1, options.repetitions); i++) {
+		State state(iterations);
+		bench.function(state);
+		ns_per_iteration.push_back(state.get_elapsed_ns() / (double)iterations);
+		items = state.get_items_processed();
+	}
+	std::sort(ns_per_iteration.begin(), ns_per_iteration.end());
+
+	Result result;
+	result.name = bench.name;
+	result.iterations = iterations;
+	result.ns_per_iteration = ns_per_iteration[ns_per_iteration.size() / 2];
+	result.min_ns_per_iteration = ns_per_iteration.front();
+	result.ns_per_item = items > 0 ? result.ns_per_iteration * (double)iterations / (double)items : 0;
+	return result;
+}
+
+// --filter <text>, --min-time <seconds>, --repetitions <n>, --json
+inline int run_main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			options.filter = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			options.min_time_seconds = std::atof(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+			options.repetitions = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--json") == 0) {
+			options.json = true;
+		}
+		else {
+			std::printf("Usage: %s [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--json]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<Result> results;
+	if (!options.json) {
+		std::printf("%-40s %14s %14s %14s %12s\n", "bench", "ns/iter", "min ns/iter", "ns/item", "iterations");
+	}
+	for (Bench const& bench : get_benches()) {
+		if (!options.filter.empty() && std::string(bench.name).find(options.filter) == std::string::npos) {
+			continue;
+		}
+		Result result = run_bench(bench, options);
+		if (!options.json) {
+			std::printf("%-40s %14.2f %14.2f %14.2f %12llu\n", result.name.c_str(), result.ns_per_iteration,
+				result.min_ns_per_iteration, result.ns_per_item, (unsigned long long)result.iterations);
+		}
+		results.push_back(result);
+	}
+	if (options.json) {
+		std::printf("{ \"benches\": [\n");
+		for (std::size_t i = 0; i < results.size(); i++) {
+			Result const& result = results[i];
+			std::printf("  { \"name\": \"%s\", \"ns_per_iteration\": %.3f, \"min_ns_per_iteration\": %.3f, \"ns_per_item\": %.3f, \"iterations\": %llu }%s\n",
+				result.name.c_str(), result.ns_per_iteration, result.min_ns_per_iteration, result.ns_per_item,
+				(unsigned long long)result.iterations, i + 1 < results.size() ? "," : "");
+		}
+		std::printf("] }\n");
+	}
+	return results.empty() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+}} // end namespace gffn::microbench
+
+#define GFFN_MICROBENCH(name) \
+	static void microbench_##name(gffn::microbench::State& state); \
+	static gffn::microbench::Registrar microbench_registrar_##name(#name, microbench_##name); \
+	static void microbench_##name(gffn::microbench::State& state)
@@ -0,0 +1,152 @@
+// PID benchmark. First checks that PIDBank (4 lanes at a time with SSE for float, plain loop for the leftovers and for
+// double) comes out the same as one PIDController per lane, over random gains, targets, feedbacks, delta times and
+// resets. Then times a tick of a lot of separate controllers against one bank step.
+//
+//   gffn_pid_bench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--json]
+
+#include "microbench.h"
+
+#include <PID.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using gffn::microbench::State;
+using gffn::microbench::do_not_optimize;
+
+constexpr int NUM_PARITY_TRIALS = 200;
+constexpr int NUM_PARITY_TICKS = 120;
+constexpr std::size_t NUM_CONTROLLERS = 10000;
+constexpr float DELTA_TIME_SECONDS = 1.0f / 60.0f;
+// The bank does the same operations in the same order as the controller, so this should come out exactly 0. The
+// tolerance is only there for a compiler that fuses a multiply and add in one and not the other.
+constexpr double FLOAT_TOLERANCE = 1e-6;
+constexpr double DOUBLE_TOLERANCE = 1e-12;
+
+template <class T>
+gffn::PIDGains<T> random_gains(std::mt19937& gen) {
+	std::uniform_real_distribution<T> gain(0, 5);
+	std::uniform_real_distribution<T> max_integral(10, 1000);
+	gffn::PIDGains<T> gains(gain(gen), gain(gen) * (T)0.4, gain(gen) * (T)0.2);
+	gains.max_integral = max_integral(gen);
+	// Half the trials clamp the output.
+	if (gen() % 2 == 0) {
+		gains.min_output = -max_integral(gen);
+		gains.max_output = max_integral(gen);
+	}
+	return gains;
+}
+
+// Largest difference between a bank lane and its controller, relative to the size of the output.
+template <class T>
+double check_parity(unsigned seed) {
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<T> value(-500, 500);
+	std::uniform_real_distribution<T> delta_time((T)1 / 240, (T)1 / 20);
+	double max_error = 0;
+	for (int trial = 0; trial < NUM_PARITY_TRIALS; trial++) {
+		gffn::PIDGains<T> gains = random_gains<T>(gen);
+		// Never a multiple of 4, so the SSE part and the leftover loop both get checked.
+		std::size_t num_lanes = 4 * (1 + gen() % 8) + 1 + gen() % 3;
+		gffn::PIDBank<T> bank(gains);
+		std::vector<gffn::PIDController<T>> controllers(num_lanes, gffn::PIDController<T>(gains));
+		for (std::size_t lane = 0; lane < num_lanes; lane++) {
+			bank.add();
+		}
+		for (int tick = 0; tick < NUM_PARITY_TICKS; tick++) {
+			T dt = delta_time(gen);
+			std::vector<T> outputs(num_lanes);
+			for (std::size_t lane = 0; lane < num_lanes; lane++) {
+				if (gen() % 50 == 0) {
+					bank.reset(lane);
+					controllers[lane].reset();
+				}
+				T target = value(gen);
+				T feedback = value(gen);
+				bank.set_target(lane, target);
+				bank.set_feedback(lane, feedback);
+				outputs[lane] = controllers[lane].tick(target, feedback, dt);
+			}
+			bank.step(dt);
+			for (std::size_t lane = 0; lane < num_lanes; lane++) {
+				double expected = outputs[lane];
+				double error = std::abs((double)bank.get_output(lane) - expected) / std::max(1.0, std::abs(expected));
+				max_error = std::max(max_error, error);
+			}
+		}
+	}
+	return max_error;
+}
+
+template <class T>
+std::vector<T> random_values(std::size_t count, unsigned seed) {
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<T> value(-500, 500);
+	std::vector<T> values(count);
+	for (T& v : values) {
+		v = value(gen);
+	}
+	return values;
+}
+
+template <class T>
+void controllers_tick(State& state) {
+	std::vector<gffn::PIDController<T>> controllers(NUM_CONTROLLERS, gffn::PIDController<T>(gffn::PIDGains<T>(2, (T)0.1, (T)0.5)));
+	std::vector<T> targets = random_values<T>(NUM_CONTROLLERS, 1);
+	std::vector<T> feedbacks = random_values<T>(NUM_CONTROLLERS, 2);
+	for ([[maybe_unused]] auto _ : state) {
+		T sum = 0;
+		for (std::size_t i = 0; i < NUM_CONTROLLERS; i++) {
+			sum += controllers[i].tick(targets[i], feedbacks[i], (T)DELTA_TIME_SECONDS);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_CONTROLLERS);
+}
+
+template <class T>
+void bank_step(State& state) {
+	gffn::PIDBank<T> bank(gffn::PIDGains<T>(2, (T)0.1, (T)0.5));
+	std::vector<T> targets = random_values<T>(NUM_CONTROLLERS, 1);
+	std::vector<T> feedbacks = random_values<T>(NUM_CONTROLLERS, 2);
+	for (std::size_t i = 0; i < NUM_CONTROLLERS; i++) {
+		bank.add(targets[i], feedbacks[i]);
+	}
+	for ([[maybe_unused]] auto _ : state) {
+		bank.step((T)DELTA_TIME_SECONDS);
+		do_not_optimize(bank.get_outputs()[NUM_CONTROLLERS - 1]);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_CONTROLLERS);
+}
+
+} // end anonymous namespace
+
+GFFN_MICROBENCH(pid_controllers_tick_float) { controllers_tick<float>(state); }
+GFFN_MICROBENCH(pid_bank_step_float) { bank_step<float>(state); }
+GFFN_MICROBENCH(pid_controllers_tick_double) { controllers_tick<double>(state); }
+GFFN_MICROBENCH(pid_bank_step_double) { bank_step<double>(state); }
+
+int main(int argc, char* argv[]) {
+	bool json = false;
+	for (int i = 1; i < argc; i++) {
+		json = json || std::strcmp(argv[i], "--json") == 0;
+	}
+	double float_error = check_parity<float>(1);
+	double double_error = check_parity<double>(2);
+	bool parity = float_error <= FLOAT_TOLERANCE && double_error <= DOUBLE_TOLERANCE;
+	if (!json || !parity) {
+		std::printf("PIDBank vs PIDController, %d trials of %d ticks: max relative difference float %.3g (allowed %.0e), double %.3g (allowed %.0e)%s\n\n",
+			NUM_PARITY_TRIALS, NUM_PARITY_TICKS, float_error, FLOAT_TOLERANCE, double_error, DOUBLE_TOLERANCE, parity ? "" : ", MISMATCH");
+	}
+	if (!parity) {
+		return EXIT_FAILURE;
+	}
+	return gffn::microbench::run_main(argc, argv);
+}
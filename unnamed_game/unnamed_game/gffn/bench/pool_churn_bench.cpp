@@ -0,0 +1,204 @@
+// Spawn/despawn churn benchmark for the object pools.
+// Runs the same churn twice, once with std::make_unique and once with make_pooled_object, and counts how many times
+// the general heap (operator new) gets hit once everything is warmed up. The pooled run should come out at zero.
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_game_object.h>
+#include <gffn_game_world_objects.h>
+#include <gffn_pool.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <vector>
+
+static std::size_t num_heap_allocations = 0;
+
+// Every replaceable operator new and delete goes through these two, so the whole set is replaced together and each
+// delete frees the way its new allocated. They're kept out of line so GCC doesn't see malloc/free meet the builtin
+// operator new/delete after inlining and warn about a mismatch (-Wmismatched-new-delete).
+[[gnu::noinline]] static void* counted_allocate(std::size_t size, std::size_t alignment) noexcept {
+	num_heap_allocations++;
+	if (alignment <= alignof(std::max_align_t)) {
+		return std::malloc(size == 0 ? 1 : size);
+	}
+	size = ((size + alignment - 1) / alignment) * alignment;
+#if defined(_WIN32)
+	return _aligned_malloc(size == 0 ? alignment : size, alignment);
+#else
+	return std::aligned_alloc(alignment, size == 0 ? alignment : size);
+#endif
+}
+[[gnu::noinline]] static void counted_free(void* memory, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+	if (alignment > alignof(std::max_align_t)) {
+		_aligned_free(memory);
+		return;
+	}
+#endif
+	(void)alignment;
+	std::free(memory);
+}
+static void* counted_allocate_or_throw(std::size_t size, std::size_t alignment) {
+	if (void* memory = counted_allocate(size, alignment)) {
+		return memory;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return counted_allocate_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return counted_allocate_or_throw(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align) { return counted_allocate_or_throw(size, (std::size_t)align); }
+void* operator new[](std::size_t size, std::align_val_t align) { return counted_allocate_or_throw(size, (std::size_t)align); }
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept { return counted_allocate(size, 0); }
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept { return counted_allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept { return counted_allocate(size, (std::size_t)align); }
+void* operator new[](std::size_t size, std::align_val_t align, std::nothrow_t const&) noexcept { return counted_allocate(size, (std::size_t)align); }
+void operator delete(void* memory) noexcept { counted_free(memory, 0); }
+void operator delete[](void* memory) noexcept { counted_free(memory, 0); }
+void operator delete(void* memory, std::size_t) noexcept { counted_free(memory, 0); }
+void operator delete[](void* memory, std::size_t) noexcept { counted_free(memory, 0); }
+void operator delete(void* memory, std::align_val_t align) noexcept { counted_free(memory, (std::size_t)align); }
+void operator delete[](void* memory, std::align_val_t align) noexcept { counted_free(memory, (std::size_t)align); }
+void operator delete(void* memory, std::size_t, std::align_val_t align) noexcept { counted_free(memory, (std::size_t)align); }
+void operator delete[](void* memory, std::size_t, std::align_val_t align) noexcept { counted_free(memory, (std::size_t)align); }
+void operator delete(void* memory, std::nothrow_t const&) noexcept { counted_free(memory, 0); }
+void operator delete[](void* memory, std::nothrow_t const&) noexcept { counted_free(memory, 0); }
+void operator delete(void* memory, std::align_val_t align, std::nothrow_t const&) noexcept { counted_free(memory, (std::size_t)align); }
+void operator delete[](void* memory, std::align_val_t align, std::nothrow_t const&) noexcept { counted_free(memory, (std::size_t)align); }
+
+namespace {
+
+constexpr int OBJECTS_PER_KIND = 500;
+constexpr int WARMUP_CYCLES = 5;
+constexpr int MEASURED_CYCLES = 50;
+
+struct BenchTextures {
+	SDL_Texture* goblin;
+	SDL_Texture* shadow;
+	SDL_Texture* tree;
+	SDL_Texture* projectile;
+	SDL_Texture* limbs;
+};
+
+struct ChurnResult {
+	std::size_t heap_allocations;
+	double ns_per_object;
+};
+
+// Same shape as main's spawns: goblins, trees, projectiles and body parts. The RNG is reseeded every cycle so every
+// cycle puts the same objects in the same grid cells.
+template <bool pooled>
+ChurnResult run_churn(BenchTextures const& textures) {
+	gffn::GameWorldObjects objects;
+	std::vector<gffn::object_id_t> ids;
+	ids.reserve(OBJECTS_PER_KIND * 4);
+	SDL_Rect limb_source_rect{ 0, 0, 25, 25 };
+
+	auto make = [](auto tag, auto&&... args) -> gffn::GFFN_ObjectPtr {
+		typedef typename decltype(tag)::type T;
+		if constexpr (pooled) {
+			return gffn::make_pooled_object<T>(std::forward<decltype(args)>(args)...);
+		}
+		else {
+			return std::make_unique<T>(std::forward<decltype(args)>(args)...);
+		}
+	};
+
+	std::size_t allocations_before = 0;
+	std::chrono::high_resolution_clock::time_point start_time;
+	for (int cycle = 0; cycle < WARMUP_CYCLES + MEASURED_CYCLES; cycle++) {
+		if (cycle == WARMUP_CYCLES) {
+			allocations_before = num_heap_allocations;
+			start_time = std::chrono::high_resolution_clock::now();
+		}
+		std::mt19937 gen(1234);
+		std::uniform_real_distribution<> crowd_coord(1000, 3000);
+		// Projectiles are kept away from the goblins so none of them hit anything and push events.
+		std::uniform_real_distribution<> projectile_coord(6000, 9000);
+
+		for (int i = 0; i < OBJECTS_PER_KIND; i++) {
+			gffn::NPC_info npc_info;
+			npc_info.floor_coords = gffn::WorldCoordinate(crowd_coord(gen), crowd_coord(gen), 0);
+			npc_info.animation_texture = textures.goblin;
+			npc_info.shadow_texture = textures.shadow;
+			gffn::GFFN_ObjectPtr npc = make(std::type_identity<gffn::GFFN_NPC>{}, npc_info);
+
+			gffn::GFFN_ObjectPtr tree = make(std::type_identity<gffn::GFFN_EnvironmentalObject>{},
+				gffn::WorldCoordinate(crowd_coord(gen), crowd_coord(gen), 0), textures.tree, textures.shadow);
+
+			gffn::GFFN_ObjectPtr projectile = make(std::type_identity<gffn::GFFN_StraightProjectile>{},
+				gffn::WorldCoordinate(projectile_coord(gen), projectile_coord(gen), 0), gffn::physics::NormalizedVector3D(),
+				5000.0, 2.0, textures.projectile, textures.shadow);
+
+			gffn::GFFN_ObjectPtr part = make(std::type_identity<gffn::GFFN_DismemberedBodyPart>{},
+				gffn::WorldCoordinate(crowd_coord(gen), crowd_coord(gen), 0), textures.limbs, textures.shadow, &limb_source_rect);
+
+			for (gffn::GFFN_ObjectPtr* object : { &npc, &tree, &projectile, &part }) {
+				ids.push_back((*object)->get_object_id());
+				objects.add_object(std::move(*object));
+			}
+		}
+		// One tick so everything lands in world_grid and the animation rects get set.
+		for (auto it = objects.begin(); it != objects.end(); ++it) {
+			(*it)->tick(1.0 / 60.0);
+		}
+		for (auto it = ids.rbegin(); it != ids.rend(); ++it) {
+			objects.remove_object(*it);
+		}
+		ids.clear();
+	}
+	auto end_time = std::chrono::high_resolution_clock::now();
+
+	ChurnResult result;
+	result.heap_allocations = num_heap_allocations - allocations_before;
+	double total_ns = std::chrono::duration<double, std::nano>(end_time - start_time).count();
+	result.ns_per_object = total_ns / ((double)MEASURED_CYCLES * OBJECTS_PER_KIND * 4);
+	return result;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--huge-pages") == 0) {
+			gffn::GFFN_FixedPool::default_use_huge_pages = true;
+		}
+	}
+	// No window, the textures only need to exist so the constructors can query their sizes.
+	SDL_Surface* target_surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA8888);
+	SDL_Renderer* renderer = SDL_CreateSoftwareRenderer(target_surface);
+	if (renderer == nullptr) {
+		std::printf("Error creating software renderer : %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+	BenchTextures textures;
+	textures.goblin = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	textures.shadow = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+	textures.tree = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 40, 60);
+	textures.projectile = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+	textures.limbs = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 150, 25);
+
+	ChurnResult unpooled = run_churn<false>(textures);
+	ChurnResult pooled = run_churn<true>(textures);
+
+	std::printf("churn: %d cycles x %d objects\n", MEASURED_CYCLES, OBJECTS_PER_KIND * 4);
+	std::printf("make_unique:        %zu heap allocations, %.1f ns per spawn+despawn\n", unpooled.heap_allocations, unpooled.ns_per_object);
+	std::printf("make_pooled_object: %zu heap allocations, %.1f ns per spawn+despawn\n", pooled.heap_allocations, pooled.ns_per_object);
+	std::printf("bytes per object: NPC %zu (budget %zu), projectile %zu, body part %zu, environmental %zu\n",
+		sizeof(gffn::GFFN_NPC), gffn::NPC_SIZE_BUDGET_BYTES, sizeof(gffn::GFFN_StraightProjectile),
+		sizeof(gffn::GFFN_DismemberedBodyPart), sizeof(gffn::GFFN_EnvironmentalObject));
+	std::printf("NPC pool: %zu blocks of %zu bytes in %zu chunks (%zu on huge pages)\n",
+		gffn::get_pool<gffn::GFFN_NPC>().get_capacity(), gffn::get_pool<gffn::GFFN_NPC>().get_block_size(),
+		gffn::get_pool<gffn::GFFN_NPC>().get_num_chunks(), gffn::get_pool<gffn::GFFN_NPC>().get_num_huge_page_chunks());
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(target_surface);
+	return pooled.heap_allocations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,178 @@
+// Double vs float math types. Prints how far float drifts from double on what the sim does with positions (integrating
+// movers for a long time, normalizing directions, the smallest step left at the far edge of the map), then times the
+// same loops with the double types and with the 16 byte float4 ones.
+//
+//   gffn_scalar_bench [--filter <text>] [--min-time <seconds>] [--repetitions <n>] [--json]
+
+#include "microbench.h"
+
+#include <gffn_physics.h>
+#include <gffn_random.h>
+#include <gffn_utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+using gffn::microbench::State;
+using gffn::microbench::do_not_optimize;
+
+constexpr int NUM_MOVERS = 100000;
+constexpr int NUM_PRECISION_MOVERS = 1000;
+constexpr int PRECISION_TICKS = 60 * 60 * 10; // ten minutes at 60 ticks a second
+constexpr double DELTA_TIME_SECONDS = 1.0 / 60.0;
+constexpr double GROUND_COEF_FRICTION = 7;
+
+template <typename T>
+using Coordinate = gffn::BasicWorldCoordinate<T>;
+template <typename T>
+using Vector = gffn::physics::BasicVector3D<T>;
+template <typename T>
+using Direction = gffn::physics::BasicNormalizedVector3D<T>;
+
+std::vector<gffn::WorldCoordinate> make_coordinates(int count, unsigned seed) {
+	gffn::GFFN_Rng rng(seed);
+	std::vector<gffn::WorldCoordinate> coordinates;
+	coordinates.reserve(count);
+	for (int i = 0; i < count; i++) {
+		double x = rng.range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
+		double y = rng.range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
+		coordinates.emplace_back(x, y, 0);
+	}
+	return coordinates;
+}
+
+template <typename T>
+std::vector<Coordinate<T>> convert(std::vector<gffn::WorldCoordinate> const& coordinates) {
+	std::vector<Coordinate<T>> converted;
+	converted.reserve(coordinates.size());
+	for (gffn::WorldCoordinate const& coordinate : coordinates) {
+		converted.emplace_back(coordinate);
+	}
+	return converted;
+}
+
+// A goblin walking towards a target that moves every few seconds, pushed and slowed down the way
+// ObjectPhysicsController::tick does it. Both scalars see the exact same targets.
+template <typename T>
+Coordinate<T> walk(Coordinate<T> position, std::vector<gffn::WorldCoordinate> const& targets) {
+	Vector<T> velocity;
+	const T delta_time = (T)DELTA_TIME_SECONDS;
+	for (int tick = 0; tick < PRECISION_TICKS; tick++) {
+		Coordinate<T> target(targets[(tick / 180) % targets.size()]);
+		Vector<T> force = velocity * (T)(-GROUND_COEF_FRICTION * 100);
+		if (position.distance_from_squared_xy(target) > 1) {
+			force = force + Direction<T>(position, target) * (T)100000;
+		}
+		velocity = velocity + force / (T)100 * delta_time;
+		position.x += velocity.x * delta_time;
+		position.y += velocity.y * delta_time;
+	}
+	return position;
+}
+
+void report_precision() {
+	double edge = gffn::WORLD_GRID_WIDTH * 100.0;
+	std::printf("smallest step at x = %.0f: double %.3g px, float %.3g px\n", edge,
+		std::nextafter(edge, std::numeric_limits<double>::infinity()) - edge,
+		(double)(std::nextafter((float)edge, std::numeric_limits<float>::infinity()) - (float)edge));
+
+	std::vector<gffn::WorldCoordinate> starts = make_coordinates(NUM_PRECISION_MOVERS, 1);
+	std::vector<gffn::WorldCoordinate> targets = make_coordinates(NUM_PRECISION_MOVERS, 2);
+	double max_direction_error = 0;
+	for (int i = 0; i < NUM_PRECISION_MOVERS; i++) {
+		gffn::physics::NormalizedVector3D in_double(starts[i], targets[i]);
+		gffn::physics::NormalizedVector3Df in_float(gffn::WorldCoordinatef(starts[i]), gffn::WorldCoordinatef(targets[i]));
+		max_direction_error = std::max({ max_direction_error, std::abs(in_double.x - in_float.x), std::abs(in_double.y - in_float.y) });
+	}
+	std::printf("normalized direction: max error %.3g\n", max_direction_error);
+
+	double max_drift = 0;
+	double total_drift = 0;
+	for (int i = 0; i < NUM_PRECISION_MOVERS; i++) {
+		// Every mover gets its own slice of targets so they don't all walk the same path.
+		std::vector<gffn::WorldCoordinate> own_targets(targets.begin() + (i % 100), targets.begin() + (i % 100) + 10);
+		gffn::WorldCoordinate in_double = walk<double>(starts[i], own_targets);
+		gffn::WorldCoordinate in_float(walk<float>(gffn::WorldCoordinatef(starts[i]), own_targets));
+		double drift = in_double.distance_from(in_float);
+		max_drift = std::max(max_drift, drift);
+		total_drift += drift;
+	}
+	std::printf("%d movers walking for %d ticks: float ends up %.3g px from double on average, %.3g px at most\n\n",
+		NUM_PRECISION_MOVERS, PRECISION_TICKS, total_drift / NUM_PRECISION_MOVERS, max_drift);
+}
+
+// position += velocity * dt over a lot of movers, about the only thing the tick does to every position.
+template <typename T>
+void integrate(State& state) {
+	std::vector<Coordinate<T>> positions = convert<T>(make_coordinates(NUM_MOVERS, 1));
+	std::vector<Vector<T>> velocities;
+	for (Coordinate<T> const& target : convert<T>(make_coordinates(NUM_MOVERS, 2))) {
+		velocities.push_back(Direction<T>(positions[velocities.size()], target) * (T)200);
+	}
+	const T delta_time = (T)DELTA_TIME_SECONDS;
+	for ([[maybe_unused]] auto _ : state) {
+		for (int i = 0; i < NUM_MOVERS; i++) {
+			positions[i].x += velocities[i].x * delta_time;
+			positions[i].y += velocities[i].y * delta_time;
+			positions[i].z += velocities[i].z * delta_time;
+		}
+		gffn::microbench::clobber_memory();
+	}
+	state.set_items_processed(state.get_iterations() * NUM_MOVERS);
+}
+
+// Counting who's in range, what the explosion and chase checks boil down to.
+template <typename T>
+void count_in_range(State& state) {
+	std::vector<Coordinate<T>> positions = convert<T>(make_coordinates(NUM_MOVERS, 1));
+	const Coordinate<T> center((T)5000, (T)5000, (T)0);
+	const T range_squared = (T)(1500 * 1500);
+	for ([[maybe_unused]] auto _ : state) {
+		int num_in_range = 0;
+		for (Coordinate<T> const& position : positions) {
+			num_in_range += center.distance_from_squared_xy(position) < range_squared;
+		}
+		do_not_optimize(num_in_range);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_MOVERS);
+}
+
+template <typename T>
+void normalize(State& state) {
+	std::vector<Coordinate<T>> starts = convert<T>(make_coordinates(NUM_MOVERS, 1));
+	std::vector<Coordinate<T>> ends = convert<T>(make_coordinates(NUM_MOVERS, 2));
+	for ([[maybe_unused]] auto _ : state) {
+		Vector<T> sum;
+		for (int i = 0; i < NUM_MOVERS; i++) {
+			sum = sum + Direction<T>(starts[i], ends[i]);
+		}
+		do_not_optimize(sum);
+	}
+	state.set_items_processed(state.get_iterations() * NUM_MOVERS);
+}
+
+} // end anonymous namespace
+
+GFFN_MICROBENCH(integrate_double) { integrate<double>(state); }
+GFFN_MICROBENCH(integrate_float4) { integrate<float>(state); }
+GFFN_MICROBENCH(count_in_range_double) { count_in_range<double>(state); }
+GFFN_MICROBENCH(count_in_range_float4) { count_in_range<float>(state); }
+GFFN_MICROBENCH(normalize_double) { normalize<double>(state); }
+GFFN_MICROBENCH(normalize_float4) { normalize<float>(state); }
+
+int main(int argc, char* argv[]) {
+	bool json = false;
+	for (int i = 1; i < argc; i++) {
+		json = json || std::strcmp(argv[i], "--json") == 0;
+	}
+	if (!json) {
+		report_precision();
+	}
+	return gffn::microbench::run_main(argc, argv);
+}
@@ -0,0 +1,496 @@
+// Headless scenario benchmark. Runs a real GFFN_GameWorld on a headless renderer (no window) through a handful of
+// scenes and reports ms per tick for every tick phase, with percentiles, as text and as JSON. Pass the JSON of an
+// earlier run as --baseline to see what got faster or slower.
+//
+//   gffn_bench [--scenario <name>] [--npcs <n>] [--ticks <n>] [--warmup <n>] [--seed <n>]
+//              [--json <out.json>] [--baseline <old.json>] [--max-regression <percent>]
+//
+// Every scenario starts from a fresh world with main's 1000 trees and the player in the middle of the map, reseeds the
+// RNG and ticks at a fixed 60 Hz, so two runs of the same build do the same work.
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_game_world.h>
+#include <gffn_random.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double DELTA_TIME_SECONDS = 1.0 / 60.0;
+constexpr int NUM_TREES = 1000;
+constexpr double MAP_MIN = 100;
+constexpr double MAP_MAX = gffn::WORLD_GRID_WIDTH * 99.0;
+constexpr double MAP_CENTER = gffn::WORLD_GRID_WIDTH * 50.0;
+
+typedef struct BenchConfig {
+	int num_npcs = 2000;
+	int num_ticks = 600;
+	int num_warmup_ticks = 60;
+	std::uint64_t seed = 1;
+} BenchConfig;
+
+typedef struct BenchTextures {
+	SDL_Texture* goblin;
+	SDL_Texture* character;
+	SDL_Texture* shadow;
+	SDL_Texture* tree;
+	SDL_Texture* projectile;
+} BenchTextures;
+
+// What a scenario gets to work with. The world is rebuilt for every scenario.
+typedef struct Scene {
+	BenchConfig const& config;
+	BenchTextures const& textures;
+	gffn::GFFN_Renderer& renderer;
+	std::unique_ptr<gffn::GFFN_GameWorld> world;
+	gffn::GFFN_Character* player = nullptr;
+} Scene;
+
+long unsigned int spawn_npc(Scene& scene, gffn::WorldCoordinate coords) {
+	gffn::NPC_info npc_info;
+	npc_info.floor_coords = coords;
+	npc_info.animation_texture = scene.textures.goblin;
+	npc_info.shadow_texture = scene.textures.shadow;
+	npc_info.animation_fps = 5;
+	npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
+	gffn::GFFN_ObjectPtr npc = gffn::make_pooled_object<gffn::GFFN_NPC>(npc_info);
+	return scene.world->add_object(npc);
+}
+
+void spawn_npcs_in_square(Scene& scene, int num_npcs, double center_x, double center_y, double half_size) {
+	for (int i = 0; i < num_npcs; i++) {
+		spawn_npc(scene, gffn::WorldCoordinate(gffn::random::range(center_x - half_size, center_x + half_size),
+			gffn::random::range(center_y - half_size, center_y + half_size), 0));
+	}
+}
+
+void spawn_projectile(Scene& scene, gffn::physics::NormalizedVector3D direction, double propulsion, double life_time_seconds) {
+	gffn::WorldCoordinate start_coords = scene.player->get_floor_coords();
+	start_coords.x += direction.x * 50;
+	start_coords.y += direction.y * 50;
+	gffn::GFFN_PooledPtr<gffn::GFFN_StraightProjectile> projectile = gffn::make_pooled_object<gffn::GFFN_StraightProjectile>(
+		start_coords, direction, propulsion, life_time_seconds, scene.textures.projectile, scene.textures.shadow);
+	projectile->get_physics_controller().set_height(scene.player->get_physics_controller().get_floor_coords().z + 100);
+	gffn::GFFN_ObjectPtr projectile_ptr = std::move(projectile);
+	scene.world->add_object(projectile_ptr);
+}
+
+void build_scene(Scene& scene) {
+	scene.world = std::make_unique<gffn::GFFN_GameWorld>(scene.renderer);
+	scene.world->phase_timing = true;
+	scene.world->camera.zoom(1.5);
+	for (int i = 0; i < NUM_TREES; i++) {
+		gffn::GFFN_ObjectPtr tree = gffn::make_pooled_object<gffn::GFFN_EnvironmentalObject>(
+			gffn::WorldCoordinate(gffn::random::range(MAP_MIN, MAP_MAX), gffn::random::range(MAP_MIN, MAP_MAX), 0),
+			scene.textures.tree, scene.textures.shadow);
+		scene.world->add_object(tree);
+	}
+	gffn::GFFN_ObjectPtr player = gffn::make_pooled_object<gffn::GFFN_Character>(gffn::GFFN_ObjectType::GFFN_OBJECT_TYPE_CHARACTER,
+		scene.textures.character, scene.textures.shadow, 5, gffn::WorldCoordinate(MAP_CENTER, MAP_CENTER, 0));
+	scene.player = static_cast<gffn::GFFN_Character*>(player.get());
+	scene.world->add_object(player);
+}
+
+// N NPCs spread over the whole map with nobody to chase, mostly far away and simulated at a lower LOD.
+void setup_idle_npcs(Scene& scene) {
+	spawn_npcs_in_square(scene, scene.config.num_npcs, MAP_CENTER, MAP_CENTER, MAP_CENTER - MAP_MIN);
+}
+void tick_idle_npcs(Scene& scene, [[maybe_unused]] int tick) {
+	scene.world->camera.move_to_position(scene.player->get_center_coords());
+}
+
+// N NPCs patrolling in one dense, on screen clump. Crowd separation and the grid get the worst of it.
+void setup_patrol_cluster(Scene& scene) {
+	spawn_npcs_in_square(scene, scene.config.num_npcs, MAP_CENTER + 800, MAP_CENTER, 600);
+}
+void tick_patrol_cluster(Scene& scene, [[maybe_unused]] int tick) {
+	scene.world->camera.move_to_position(scene.player->get_center_coords());
+}
+
+// N NPCs chasing the player, who sprays a projectile every tick across a 90 degree arc, like holding the left button.
+void setup_projectile_stream(Scene& scene) {
+	spawn_npcs_in_square(scene, scene.config.num_npcs, MAP_CENTER, MAP_CENTER, 1500);
+	scene.world->set_chase_target(scene.player->get_object_id());
+}
+void tick_projectile_stream(Scene& scene, int tick) {
+	scene.world->camera.move_to_position(scene.player->get_center_coords());
+	gffn::physics::NormalizedVector3D direction(gffn::physics::Vector3D(1, 0, 0));
+	direction.rotate_xy(std::fmod(tick * 1.5, 90.0) - 45.0 + gffn::random::range(-14.0, 14.0));
+	spawn_projectile(scene, direction, 5000, 2.0);
+}
+
+// A clump of N NPCs that gets blown up every half second and topped back up to N, so there's always a pile of limbs
+// flying around, landing and getting baked into the ground.
+void setup_mass_death(Scene& scene) {
+	spawn_npcs_in_square(scene, scene.config.num_npcs, MAP_CENTER + 800, MAP_CENTER, 600);
+}
+void tick_mass_death(Scene& scene, int tick) {
+	scene.world->camera.move_to_position(gffn::WorldCoordinate(MAP_CENTER + 800, MAP_CENTER, 0));
+	if (tick % 30 != 0) {
+		return;
+	}
+	for (int i = 0; i < 20; i++) {
+		gffn::events::ExplosionEvent explosion{ gffn::WorldCoordinate(gffn::random::range(MAP_CENTER + 200, MAP_CENTER + 1400),
+			gffn::random::range(MAP_CENTER - 600, MAP_CENTER + 600), 0), 200, 250, 150, {} };
+		gffn::events::event_bus.push(explosion);
+	}
+	int num_missing = scene.config.num_npcs - scene.world->num_npcs;
+	if (num_missing > 0) {
+		spawn_npcs_in_square(scene, num_missing, MAP_CENTER + 800, MAP_CENTER, 600);
+	}
+}
+
+// Max zoom out, panning around the map in a circle over N spread out NPCs. Mostly render prep.
+void setup_camera_pan(Scene& scene) {
+	scene.world->camera.zoom(5.0);
+	spawn_npcs_in_square(scene, scene.config.num_npcs, MAP_CENTER, MAP_CENTER, MAP_CENTER - MAP_MIN);
+}
+void tick_camera_pan(Scene& scene, int tick) {
+	double angle = tick * DELTA_TIME_SECONDS * 0.5;
+	scene.world->camera.move_to_position(gffn::WorldCoordinate(MAP_CENTER + std::cos(angle) * 2500, MAP_CENTER + std::sin(angle) * 2500, 0));
+}
+
+typedef struct Scenario {
+	const char* name;
+	void (*setup)(Scene& scene);
+	void (*tick)(Scene& scene, int tick);
+} Scenario;
+
+const Scenario SCENARIOS[] = {
+	{ "idle_npcs", setup_idle_npcs, tick_idle_npcs },
+	{ "patrol_cluster", setup_patrol_cluster, tick_patrol_cluster },
+	{ "projectile_stream", setup_projectile_stream, tick_projectile_stream },
+	{ "mass_death", setup_mass_death, tick_mass_death },
+	{ "camera_pan", setup_camera_pan, tick_camera_pan },
+};
+
+typedef struct Percentiles {
+	double mean;
+	double p50;
+	double p90;
+	double p99;
+	double max;
+} Percentiles;
+
+Percentiles get_percentiles(std::vector<double> samples) {
+	Percentiles result{};
+	if (samples.empty()) {
+		return result;
+	}
+	std::sort(samples.begin(), samples.end());
+	double total = 0;
+	for (double sample : samples) {
+		total += sample;
+	}
+	auto at = [&samples](double fraction) { return samples[(std::size_t)(fraction * (samples.size() - 1) + 0.5)]; };
+	result.mean = total / samples.size();
+	result.p50 = at(0.50);
+	result.p90 = at(0.90);
+	result.p99 = at(0.99);
+	result.max = samples.back();
+	return result;
+}
+
+// "total" first, then one per GFFN_TickPhase.
+constexpr int NUM_REPORTED_PHASES = gffn::GFFN_TICK_PHASE_END + 1;
+const char* get_reported_phase_name(int index) {
+	return index == 0 ? "total" : gffn::get_tick_phase_name((gffn::GFFN_TickPhase)(index - 1));
+}
+
+typedef struct ScenarioResult {
+	const char* name;
+	int num_objects_at_end;
+	std::array<Percentiles, NUM_REPORTED_PHASES> phases;
+} ScenarioResult;
+
+ScenarioResult run_scenario(Scenario const& scenario, BenchConfig const& config, BenchTextures const& textures, gffn::GFFN_Renderer& renderer) {
+	gffn::random::set_master_seed(config.seed);
+	Scene scene{ config, textures, renderer, nullptr, nullptr };
+	build_scene(scene);
+	scenario.setup(scene);
+
+	std::array<std::vector<double>, NUM_REPORTED_PHASES> samples;
+	for (std::vector<double>& phase_samples : samples) {
+		phase_samples.reserve(config.num_ticks);
+	}
+	for (int tick = 0; tick < config.num_warmup_ticks + config.num_ticks; tick++) {
+		scenario.tick(scene, tick);
+		auto start_time = std::chrono::steady_clock::now();
+		scene.world->tick(renderer, DELTA_TIME_SECONDS);
+		double tick_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+		if (tick < config.num_warmup_ticks) {
+			continue;
+		}
+		samples[0].push_back(tick_ms);
+		for (int phase = 0; phase < gffn::GFFN_TICK_PHASE_END; phase++) {
+			samples[phase + 1].push_back(scene.world->last_tick_phase_ms[phase]);
+		}
+	}
+
+	gffn::GFFN_GameWorld const& world = *scene.world;
+	int num_objects = world.num_characters + world.num_npcs + world.num_dismembered_body_parts + world.num_environmental_objects
+		+ world.num_straight_projectiles;
+	ScenarioResult result{ scenario.name, num_objects, {} };
+	for (int phase = 0; phase < NUM_REPORTED_PHASES; phase++) {
+		result.phases[phase] = get_percentiles(samples[phase]);
+	}
+	// Hand out whatever the last tick pushed while the handlers still exist.
+	scene.world->event_handler();
+	scene.world.reset();
+	return result;
+}
+
+std::string to_json(BenchConfig const& config, std::vector<ScenarioResult> const& results) {
+	std::string json = "{\n";
+	json += std::format("  \"config\": {{ \"npcs\": {}, \"ticks\": {}, \"warmup\": {}, \"seed\": {} }},\n",
+		config.num_npcs, config.num_ticks, config.num_warmup_ticks, config.seed);
+	json += "  \"scenarios\": {";
+	for (std::size_t i = 0; i < results.size(); i++) {
+		ScenarioResult const& result = results[i];
+		json += std::format("{}\n    \"{}\": {{\n      \"objects_at_end\": {}", i == 0 ? "" : ",", result.name, result.num_objects_at_end);
+		for (int phase = 0; phase < NUM_REPORTED_PHASES; phase++) {
+			Percentiles const& p = result.phases[phase];
+			json += std::format(",\n      \"{}\": {{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}",
+				get_reported_phase_name(phase), p.mean, p.p50, p.p90, p.p99, p.max);
+		}
+		json += "\n    }";
+	}
+	json += "\n  }\n}\n";
+	return json;
+}
+
+// Just enough JSON to read back what to_json wrote. Numbers end up in values under their dotted path, like
+// "scenarios.idle_npcs.total.p50". Strings, bools and arrays are skipped.
+class BaselineReader {
+	std::string const& text;
+	std::size_t pos = 0;
+
+	void skip_whitespace() {
+		while (pos < text.size() && std::isspace((unsigned char)text[pos])) {
+			pos++;
+		}
+	}
+	bool expect(char c) {
+		skip_whitespace();
+		if (pos < text.size() && text[pos] == c) {
+			pos++;
+			return true;
+		}
+		return false;
+	}
+	std::string read_string() {
+		std::string result;
+		pos++; // opening quote
+		while (pos < text.size() && text[pos] != '"') {
+			if (text[pos] == '\\') {
+				pos++;
+			}
+			if (pos < text.size()) {
+				result += text[pos++];
+			}
+		}
+		pos++;
+		return result;
+	}
+	bool read_value(std::string const& path) {
+		skip_whitespace();
+		if (pos >= text.size()) {
+			return false;
+		}
+		char c = text[pos];
+		if (c == '{') {
+			pos++;
+			if (expect('}')) {
+				return true;
+			}
+			do {
+				skip_whitespace();
+				if (pos >= text.size() || text[pos] != '"') {
+					return false;
+				}
+				std::string key = read_string();
+				if (!expect(':') || !read_value(path.empty() ? key : path + "." + key)) {
+					return false;
+				}
+			} while (expect(','));
+			return expect('}');
+		}
+		if (c == '[') {
+			pos++;
+			if (expect(']')) {
+				return true;
+			}
+			do {
+				if (!read_value(path)) {
+					return false;
+				}
+			} while (expect(','));
+			return expect(']');
+		}
+		if (c == '"') {
+			read_string();
+			return true;
+		}
+		char* end = nullptr;
+		double number = std::strtod(text.c_str() + pos, &end);
+		if (end != text.c_str() + pos) {
+			values[path] = number;
+			pos = end - text.c_str();
+			return true;
+		}
+		// true, false, null
+		while (pos < text.size() && std::isalpha((unsigned char)text[pos])) {
+			pos++;
+		}
+		return true;
+	}
+public:
+	std::map<std::string, double> values;
+
+	explicit BaselineReader(std::string const& text) : text(text) {}
+	bool read() { return read_value(""); }
+};
+
+void print_results(std::vector<ScenarioResult> const& results, std::map<std::string, double> const* baseline) {
+	std::printf("%-18s %-12s %9s %9s %9s %9s %9s%s\n", "scenario", "phase", "mean", "p50", "p90", "p99", "max",
+		baseline != nullptr ? "   p50 vs baseline" : "");
+	for (ScenarioResult const& result : results) {
+		for (int phase = 0; phase < NUM_REPORTED_PHASES; phase++) {
+			Percentiles const& p = result.phases[phase];
+			std::printf("%-18s %-12s %9.3f %9.3f %9.3f %9.3f %9.3f", phase == 0 ? result.name : "", get_reported_phase_name(phase),
+				p.mean, p.p50, p.p90, p.p99, p.max);
+			if (baseline != nullptr) {
+				auto it = baseline->find(std::format("scenarios.{}.{}.p50", result.name, get_reported_phase_name(phase)));
+				if (it != baseline->end() && it->second > 0) {
+					std::printf("   %+7.1f%%", (p.p50 - it->second) / it->second * 100.0);
+				}
+			}
+			std::printf("\n");
+		}
+	}
+	std::printf("(ms per tick, %s)\n", results.empty() ? "no scenarios ran" : "after warmup");
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+	BenchConfig config;
+	std::string only_scenario;
+	std::string json_filename;
+	std::string baseline_filename;
+	double max_regression_percent = -1;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--scenario" && has_value) {
+			only_scenario = argv[++i];
+		}
+		else if (arg == "--npcs" && has_value) {
+			config.num_npcs = std::atoi(argv[++i]);
+		}
+		else if (arg == "--ticks" && has_value) {
+			config.num_ticks = std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "--warmup" && has_value) {
+			config.num_warmup_ticks = std::max(0, std::atoi(argv[++i]));
+		}
+		else if (arg == "--seed" && has_value) {
+			config.seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--json" && has_value) {
+			json_filename = argv[++i];
+		}
+		else if (arg == "--baseline" && has_value) {
+			baseline_filename = argv[++i];
+		}
+		else if (arg == "--max-regression" && has_value) {
+			max_regression_percent = std::atof(argv[++i]);
+		}
+		else {
+			std::printf("Unknown or incomplete argument %s\n", argv[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::map<std::string, double> baseline;
+	if (!baseline_filename.empty()) {
+		std::ifstream file(baseline_filename);
+		std::stringstream text;
+		text << file.rdbuf();
+		std::string baseline_text = text.str();
+		BaselineReader reader(baseline_text);
+		if (!file || !reader.read()) {
+			std::printf("Couldn't read baseline %s\n", baseline_filename.c_str());
+			return EXIT_FAILURE;
+		}
+		baseline = std::move(reader.values);
+	}
+
+	gffn::GFFN_Renderer renderer(std::string("gffn_bench"), true);
+	SDL_Renderer* sdl_renderer = renderer.get_sdl_renderer();
+	// Same sizes as the real sprite sheets, so animations slice them the same way.
+	BenchTextures textures;
+	textures.goblin = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	textures.character = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	textures.shadow = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+	textures.tree = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 40, 60);
+	textures.projectile = SDL_CreateTexture(sdl_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+
+	std::vector<ScenarioResult> results;
+	for (Scenario const& scenario : SCENARIOS) {
+		if (!only_scenario.empty() && only_scenario != scenario.name) {
+			continue;
+		}
+		std::printf("running %s...\n", scenario.name);
+		std::fflush(stdout);
+		results.push_back(run_scenario(scenario, config, textures, renderer));
+	}
+	if (results.empty()) {
+		std::printf("No scenario called %s\n", only_scenario.c_str());
+		return EXIT_FAILURE;
+	}
+	print_results(results, baseline_filename.empty() ? nullptr : &baseline);
+
+	if (!json_filename.empty()) {
+		std::ofstream file(json_filename);
+		file << to_json(config, results);
+		if (!file.good()) {
+			std::printf("Couldn't write %s\n", json_filename.c_str());
+			return EXIT_FAILURE;
+		}
+		std::printf("Wrote %s\n", json_filename.c_str());
+	}
+
+	for (SDL_Texture* texture : { textures.goblin, textures.character, textures.shadow, textures.tree, textures.projectile }) {
+		SDL_DestroyTexture(texture);
+	}
+
+	// Fails when a scenario's median tick got slower than the baseline by more than the allowed percentage.
+	if (max_regression_percent >= 0 && !baseline.empty()) {
+		bool regressed = false;
+		for (ScenarioResult const& result : results) {
+			auto it = baseline.find(std::format("scenarios.{}.total.p50", result.name));
+			if (it != baseline.end() && it->second > 0 && (result.phases[0].p50 - it->second) / it->second * 100.0 > max_regression_percent) {
+				std::printf("%s regressed past %.1f%%\n", result.name, max_regression_percent);
+				regressed = true;
+			}
+		}
+		if (regressed) {
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
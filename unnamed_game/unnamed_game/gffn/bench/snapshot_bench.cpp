@@ -0,0 +1,198 @@
+// World snapshot benchmark. Fills a headless world with trees, NPCs chasing the player and a stream of projectiles, then
+// times GFFN_GameWorld::capture_snapshot and restore_snapshot: rolling back a second (goblins died and got rebuilt,
+// projectiles and limbs spawned since got destroyed) and restoring right after capturing (every object patched in place).
+// It also checks a rollback replays the same: the ticks replayed from a restored snapshot have to end in the same world
+// as the ticks the live world ran before it was rolled back. The first run's live ticks are from a world that was never
+// restored at all.
+//
+//   gffn_snapshot_bench [--npcs <n>] [--trees <n>] [--runs <n>]
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_game_world.h>
+#include <gffn_random.h>
+#include <gffn_snapshot.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double DELTA_TIME_SECONDS = 1.0 / 60.0;
+constexpr double MAP_MIN = 100;
+constexpr double MAP_MAX = gffn::WORLD_GRID_WIDTH * 99.0;
+constexpr double MAP_CENTER = gffn::WORLD_GRID_WIDTH * 50.0;
+constexpr int ROLLBACK_TICKS = 60;
+constexpr double ROLLBACK_TARGET_MS = 1.0; // has to fit in a frame next to the replayed ticks
+
+typedef struct Scene {
+	gffn::GFFN_Renderer& renderer;
+	gffn::GFFN_GameWorld& world;
+	SDL_Texture* projectile_texture;
+	SDL_Texture* shadow_texture;
+	long unsigned int player_id;
+	int tick = 0;
+} Scene;
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	return samples.empty() ? 0 : samples[samples.size() / 2];
+}
+
+// The player sprays a projectile every tick, the same way scenario_bench's projectile_stream does.
+void tick_scene(Scene& scene) {
+	gffn::GFFN_Character* player = static_cast<gffn::GFFN_Character*>(scene.world.game_world_objects.get_object(scene.player_id));
+	scene.world.camera.move_to_position(player->get_center_coords());
+	gffn::physics::NormalizedVector3D direction(gffn::physics::Vector3D(1, 0, 0));
+	direction.rotate_xy(std::fmod(scene.tick * 1.5, 360.0) + gffn::random::range(-14.0, 14.0));
+	gffn::WorldCoordinate start_coords = player->get_floor_coords();
+	start_coords.x += direction.x * 50;
+	start_coords.y += direction.y * 50;
+	gffn::GFFN_PooledPtr<gffn::GFFN_StraightProjectile> projectile = gffn::make_pooled_object<gffn::GFFN_StraightProjectile>(
+		start_coords, direction, 5000.0, 2.0, scene.projectile_texture, scene.shadow_texture);
+	projectile->get_physics_controller().set_height(100);
+	gffn::GFFN_ObjectPtr projectile_ptr = std::move(projectile);
+	scene.world.add_object(projectile_ptr);
+	scene.world.tick(scene.renderer, DELTA_TIME_SECONDS);
+	scene.tick++;
+}
+
+// How many records differ between two snapshots of what should be the same world.
+std::size_t count_differences(gffn::GFFN_WorldSnapshot const& a, gffn::GFFN_WorldSnapshot const& b) {
+	if (a.objects.size() != b.objects.size()) {
+		return std::max(a.objects.size(), b.objects.size());
+	}
+	std::size_t num_different = 0;
+	for (std::size_t i = 0; i < a.objects.size(); i++) {
+		gffn::GFFN_ObjectSnapshot const& x = a.objects[i];
+		gffn::GFFN_ObjectSnapshot const& y = b.objects[i];
+		gffn::WorldCoordinate x_coords = x.physics.get_floor_coords();
+		gffn::WorldCoordinate y_coords = y.physics.get_floor_coords();
+		gffn::physics::Vector3D x_velocity = x.physics.get_velocity();
+		gffn::physics::Vector3D y_velocity = y.physics.get_velocity();
+		bool same = x.object_id == y.object_id && x_coords.x == y_coords.x && x_coords.y == y_coords.y && x_coords.z == y_coords.z
+			&& x_velocity.x == y_velocity.x && x_velocity.y == y_velocity.y && x_velocity.z == y_velocity.z && x.hp == y.hp
+			&& x.npc_state == y.npc_state && x.patrol_state == y.patrol_state && x.timer_ms_left == y.timer_ms_left
+			&& x.grid_location == y.grid_location;
+		num_different += same ? 0 : 1;
+	}
+	return num_different;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+	int num_npcs = 8000;
+	int num_trees = 2000;
+	int num_runs = 20;
+	for (int i = 1; i < argc; i++) {
+		bool has_value = i + 1 < argc;
+		if (std::strcmp(argv[i], "--npcs") == 0 && has_value) {
+			num_npcs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--trees") == 0 && has_value) {
+			num_trees = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--runs") == 0 && has_value) {
+			num_runs = std::max(1, std::atoi(argv[++i]));
+		}
+		else {
+			std::printf("Usage: %s [--npcs <n>] [--trees <n>] [--runs <n>]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	gffn::random::set_master_seed(1);
+	gffn::GFFN_Renderer renderer(std::string("gffn_snapshot_bench"), true);
+	SDL_Texture* tree_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 50);
+	SDL_Texture* shadow_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+	SDL_Texture* character_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 100, 850);
+	SDL_Texture* goblin_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	SDL_Texture* projectile_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+
+	gffn::GFFN_GameWorld world(renderer);
+	world.camera.zoom(1.5);
+	for (int i = 0; i < num_trees; i++) {
+		gffn::GFFN_ObjectPtr tree = gffn::make_pooled_object<gffn::GFFN_EnvironmentalObject>(
+			gffn::WorldCoordinate(gffn::random::range(MAP_MIN, MAP_MAX), gffn::random::range(MAP_MIN, MAP_MAX), 0), tree_texture, shadow_texture);
+		world.add_object(tree);
+	}
+	gffn::GFFN_ObjectPtr player = gffn::make_pooled_object<gffn::GFFN_Character>(gffn::GFFN_ObjectType::GFFN_OBJECT_TYPE_CHARACTER,
+		character_texture, shadow_texture, 5, gffn::WorldCoordinate(MAP_CENTER, MAP_CENTER, 0));
+	long unsigned int player_id = world.add_object(player);
+	world.set_chase_target(player_id);
+	gffn::NPC_info npc_info;
+	npc_info.animation_texture = goblin_texture;
+	npc_info.shadow_texture = shadow_texture;
+	npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
+	std::vector<gffn::WorldCoordinate> positions;
+	for (int i = 0; i < num_npcs; i++) {
+		positions.emplace_back(gffn::random::range(MAP_CENTER - 3000, MAP_CENTER + 3000), gffn::random::range(MAP_CENTER - 3000, MAP_CENTER + 3000), 0);
+	}
+	world.spawn_npcs(npc_info, positions);
+
+	Scene scene{ renderer, world, projectile_texture, shadow_texture, player_id };
+	for (int i = 0; i < 120; i++) {
+		tick_scene(scene);
+	}
+
+	gffn::GFFN_WorldSnapshot snapshot;
+	gffn::GFFN_WorldSnapshot live_snapshot;
+	gffn::GFFN_WorldSnapshot replay_snapshot;
+	std::vector<double> capture_ms;
+	std::vector<double> restore_in_place_ms;
+	std::vector<double> rollback_ms;
+	std::size_t num_objects = 0;
+	std::size_t num_different = 0;
+	for (int run = 0; run < num_runs; run++) {
+		auto start = std::chrono::steady_clock::now();
+		world.capture_snapshot(snapshot);
+		capture_ms.push_back(ms_since(start));
+		num_objects = snapshot.objects.size();
+
+		// The live world runs on from the snapshot without being touched, that's what the replay has to match.
+		int first_tick = scene.tick;
+		for (int i = 0; i < ROLLBACK_TICKS; i++) {
+			tick_scene(scene);
+		}
+		world.capture_snapshot(live_snapshot);
+		start = std::chrono::steady_clock::now();
+		world.restore_snapshot(snapshot);
+		rollback_ms.push_back(ms_since(start));
+
+		scene.tick = first_tick;
+		for (int i = 0; i < ROLLBACK_TICKS; i++) {
+			tick_scene(scene);
+		}
+		world.capture_snapshot(replay_snapshot);
+		num_different += count_differences(replay_snapshot, live_snapshot);
+	}
+	// Separate from the rollbacks so the replay check above never starts from a world that was only just restored in place.
+	for (int run = 0; run < num_runs; run++) {
+		world.capture_snapshot(snapshot);
+		auto start = std::chrono::steady_clock::now();
+		world.restore_snapshot(snapshot);
+		restore_in_place_ms.push_back(ms_since(start));
+	}
+
+	double rollback_median_ms = median(rollback_ms);
+	std::printf("%zu objects (%d NPCs left, %d projectiles, %d body parts), %.1f MB per snapshot\n", num_objects, world.num_npcs,
+		world.num_straight_projectiles, world.num_dismembered_body_parts, snapshot.get_storage_bytes() / (1024.0 * 1024.0));
+	std::printf("capture                     %7.3f ms median\n", median(capture_ms));
+	std::printf("restore, nothing changed    %7.3f ms median\n", median(restore_in_place_ms));
+	std::printf("restore, rolling back %d ticks %5.3f ms median, target %.0f ms%s\n", ROLLBACK_TICKS, rollback_median_ms,
+		ROLLBACK_TARGET_MS, rollback_median_ms <= ROLLBACK_TARGET_MS ? "" : ", MISSED");
+	std::printf("replays that diverged from the live run: %zu objects over %d runs\n", num_different, num_runs);
+	return num_different == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,120 @@
+// Batch spawn benchmark. Fills a headless world with N goblins twice, once with add_object per NPC the way the F key
+// does it, once with GFFN_GameWorld::spawn_npcs, and times the spawn (both put every NPC on the grid), the first tick
+// and tearing the world down. Whichever runs second finds the pools and the timer wheel already grown by the
+// first, so for a fair comparison run each in its own process with --only.
+//
+//   gffn_spawn_bench [--npcs <n>] [--only <one_by_one|batch>]
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <gffn_game_world.h>
+#include <gffn_random.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef struct SpawnResult {
+	double spawn_ms;
+	double first_tick_ms;
+	double teardown_ms;
+	std::size_t num_on_grid;
+} SpawnResult;
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::size_t count_on_grid() {
+	std::size_t num_on_grid = 0;
+	for (auto const& column : gffn::world_grid) {
+		for (auto const& cell : column) {
+			num_on_grid += cell.size();
+		}
+	}
+	return num_on_grid;
+}
+
+template <bool batch>
+SpawnResult run_spawn(gffn::GFFN_Renderer& renderer, gffn::NPC_info const& npc_info, std::vector<gffn::WorldCoordinate> const& positions) {
+	SpawnResult result;
+	auto world = std::make_unique<gffn::GFFN_GameWorld>(renderer);
+	auto start = std::chrono::steady_clock::now();
+	if constexpr (batch) {
+		world->spawn_npcs(npc_info, positions);
+	}
+	else {
+		for (gffn::WorldCoordinate const& position : positions) {
+			gffn::NPC_info info = npc_info;
+			info.floor_coords = position;
+			gffn::GFFN_ObjectPtr npc = gffn::make_pooled_object<gffn::GFFN_NPC>(info);
+			world->add_object(npc);
+		}
+	}
+	result.spawn_ms = ms_since(start);
+
+	start = std::chrono::steady_clock::now();
+	world->tick(renderer, 1.0 / 60.0);
+	result.first_tick_ms = ms_since(start);
+	result.num_on_grid = count_on_grid();
+
+	start = std::chrono::steady_clock::now();
+	world.reset();
+	result.teardown_ms = ms_since(start);
+	return result;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+	int num_npcs = 100000;
+	bool run_one_by_one = true;
+	bool run_batch = true;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--npcs") == 0 && i + 1 < argc) {
+			num_npcs = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+			i++;
+			run_one_by_one = std::strcmp(argv[i], "one_by_one") == 0;
+			run_batch = std::strcmp(argv[i], "batch") == 0;
+		}
+		else {
+			std::printf("Usage: %s [--npcs <n>] [--only <one_by_one|batch>]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	gffn::GFFN_Renderer renderer(std::string("gffn_spawn_bench"), true);
+	gffn::NPC_info npc_info;
+	npc_info.animation_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 50, 400);
+	npc_info.shadow_texture = SDL_CreateTexture(renderer.get_sdl_renderer(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 25, 25);
+	npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
+
+	gffn::random::set_master_seed(1);
+	std::vector<gffn::WorldCoordinate> positions;
+	for (int i = 0; i < num_npcs; i++) {
+		positions.emplace_back(gffn::random::range(100.0, gffn::WORLD_GRID_WIDTH * 99.0), gffn::random::range(100.0, gffn::WORLD_GRID_HEIGHT * 99.0), 0);
+	}
+
+	std::printf("%d NPCs               spawn ms   first tick ms   teardown ms   on grid\n", num_npcs);
+	if (run_one_by_one) {
+		SpawnResult one_by_one = run_spawn<false>(renderer, npc_info, positions);
+		std::printf("add_object one by one %9.1f %15.1f %13.1f %9zu\n", one_by_one.spawn_ms, one_by_one.first_tick_ms, one_by_one.teardown_ms, one_by_one.num_on_grid);
+	}
+	if (run_batch) {
+		SpawnResult batch = run_spawn<true>(renderer, npc_info, positions);
+		std::printf("spawn_npcs            %9.1f %15.1f %13.1f %9zu\n", batch.spawn_ms, batch.first_tick_ms, batch.teardown_ms, batch.num_on_grid);
+		if (batch.num_on_grid != (std::size_t)num_npcs) {
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
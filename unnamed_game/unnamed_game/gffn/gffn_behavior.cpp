@@ -0,0 +1,63 @@
+#include <gffn_behavior.h>
+#include <gffn_pool.h>
+
+#include <array>
+#include <memory>
+#include <new>
+
+namespace gffn {
+
+namespace {
+// Frames are rounded up to 64 bytes. Anything past the biggest class is rare enough to go to the heap.
+constexpr std::size_t FRAME_SIZE_CLASS = 64;
+constexpr std::size_t NUM_FRAME_SIZE_CLASSES = 16;
+constexpr std::size_t FRAME_BLOCKS_PER_CHUNK = 256;
+
+std::array<std::unique_ptr<GFFN_FixedPool>, NUM_FRAME_SIZE_CLASSES>& get_frame_pools() {
+	static std::array<std::unique_ptr<GFFN_FixedPool>, NUM_FRAME_SIZE_CLASSES> frame_pools;
+	return frame_pools;
+}
+
+std::size_t get_size_class(std::size_t size) {
+	return (size + FRAME_SIZE_CLASS - 1) / FRAME_SIZE_CLASS - 1;
+}
+
+GFFN_FixedPool& get_frame_pool(std::size_t size_class) {
+	std::unique_ptr<GFFN_FixedPool>& pool = get_frame_pools()[size_class];
+	if (!pool) {
+		pool = std::make_unique<GFFN_FixedPool>((size_class + 1) * FRAME_SIZE_CLASS, alignof(std::max_align_t),
+			GFFN_MEMORY_TAG_OBJECTS, FRAME_BLOCKS_PER_CHUNK);
+	}
+	return *pool;
+}
+}
+
+void* allocate_behavior_frame(std::size_t size) {
+	std::size_t size_class = get_size_class(size);
+	if (size_class >= NUM_FRAME_SIZE_CLASSES) {
+		memory::track_alloc(GFFN_MEMORY_TAG_OBJECTS, size);
+		return ::operator new(size);
+	}
+	return get_frame_pool(size_class).allocate();
+}
+
+void reserve_behavior_frames(std::size_t size, std::size_t num_frames) {
+	std::size_t size_class = get_size_class(size);
+	if (size == 0 || size_class >= NUM_FRAME_SIZE_CLASSES) {
+		return;
+	}
+	GFFN_FixedPool& pool = get_frame_pool(size_class);
+	pool.reserve(pool.get_num_live() + num_frames);
+}
+
+void deallocate_behavior_frame(void* frame, std::size_t size) {
+	std::size_t size_class = get_size_class(size);
+	if (size_class >= NUM_FRAME_SIZE_CLASSES) {
+		memory::track_free(GFFN_MEMORY_TAG_OBJECTS, size);
+		::operator delete(frame);
+		return;
+	}
+	get_frame_pools()[size_class]->deallocate(frame);
+}
+
+} // end namespace gffn
@@ -0,0 +1,267 @@
+#include <gffn_crowd.h>
+#include <gffn_profiler.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFFN_CROWD_SSE
+#include <emmintrin.h>
+#endif
+
+namespace gffn {
+
+namespace {
+constexpr float SEPARATION_DISTANCE_SQUARED = GFFN_CrowdSeparation::SEPARATION_DISTANCE * GFFN_CrowdSeparation::SEPARATION_DISTANCE;
+// Below this two goblins are on the same spot and there's no direction to push them apart in.
+constexpr float COINCIDENT_DISTANCE_SQUARED = 0.01f;
+
+
+constexpr std::size_t NUM_COINCIDENT_DIRECTIONS = 64;
+struct CoincidentDirections {
+	float x[NUM_COINCIDENT_DIRECTIONS];
+	float y[NUM_COINCIDENT_DIRECTIONS];
+	CoincidentDirections() {
+		for (std::size_t i = 0; i < NUM_COINCIDENT_DIRECTIONS; i++) {
+			float angle = (float)i * (2.0f * (float)M_PI / NUM_COINCIDENT_DIRECTIONS);
+			x[i] = std::cos(angle);
+			y[i] = std::sin(angle);
+		}
+	}
+};
+const CoincidentDirections coincident_directions;
+} // end anonymous namespace
+
+// Two goblins on the same spot get split in a direction hashed from their ids, the same every tick for the same pair so
+// they don't jitter, and opposite for the other one of the pair.
+void GFFN_CrowdSeparation::add_coincident_force(std::uint32_t me, std::uint32_t other, float& total_x, float& total_y) const {
+	long unsigned int low_id = std::min(sorted_id[me], sorted_id[other]);
+	long unsigned int high_id = std::max(sorted_id[me], sorted_id[other]);
+	std::uint32_t hash = ((std::uint32_t)(low_id * 2654435761u) ^ (std::uint32_t)(high_id * 40503u)) >> 8;
+	std::size_t direction = hash % NUM_COINCIDENT_DIRECTIONS;
+	float force = sorted_id[me] == low_id ? MAX_PAIR_FORCE : -MAX_PAIR_FORCE;
+	total_x += coincident_directions.x[direction] * force;
+	total_y += coincident_directions.y[direction] * force;
+}
+
+GFFN_CrowdSeparation::GFFN_CrowdSeparation() :
+cells_wide((int)std::ceil(WORLD_GRID_WIDTH * 100 / SEPARATION_DISTANCE) + 1),
+cells_high((int)std::ceil(WORLD_GRID_HEIGHT * 100 / SEPARATION_DISTANCE) + 1) {
+	cell_start.resize((std::size_t)cells_wide * cells_high + 1);
+}
+
+void GFFN_CrowdSeparation::gather_agents(std::vector<GFFN_GameObject*>::iterator begin, std::vector<GFFN_GameObject*>::iterator end,
+	GFFN_SimulationLOD const& lod) {
+	agents.clear();
+	agent_x.clear();
+	agent_y.clear();
+	agent_cell.clear();
+	agent_id.clear();
+	agent_gets_pushed.clear();
+	for (auto it = begin; it != end; ++it) {
+		GFFN_ObjectType object_type = (*it)->get_object_type();
+		if (object_type != GFFN_OBJECT_TYPE_NPC && object_type != GFFN_OBJECT_TYPE_CHARACTER) {
+			continue;
+		}
+		GFFN_Character* character = static_cast<GFFN_Character*>(*it);
+		// Separation is all float, same as the positions it reads.
+		WorldCoordinatef coords = character->get_floor_coordsf();
+		int cell_x = std::clamp((int)(coords.x / SEPARATION_DISTANCE), 0, cells_wide - 1);
+		int cell_y = std::clamp((int)(coords.y / SEPARATION_DISTANCE), 0, cells_high - 1);
+		agents.push_back(character);
+		agent_x.push_back(coords.x);
+		agent_y.push_back(coords.y);
+		agent_cell.push_back(cell_y * cells_wide + cell_x);
+		agent_id.push_back(character->get_object_id());
+		agent_gets_pushed.push_back(object_type == GFFN_OBJECT_TYPE_NPC && lod.ticks_this_frame(character->get_object_id(), WorldCoordinate(coords)));
+	}
+	force_x.assign(agents.size(), 0.0f);
+	force_y.assign(agents.size(), 0.0f);
+}
+
+void GFFN_CrowdSeparation::bucket_agents() {
+	std::fill(cell_start.begin(), cell_start.end(), 0);
+	for (int cell : agent_cell) {
+		cell_start[cell + 1]++;
+	}
+	for (std::size_t cell = 1; cell < cell_start.size(); cell++) {
+		cell_start[cell] += cell_start[cell - 1];
+	}
+	// cell_start[c] is used as the write cursor for cell c, which leaves it at the start of c + 1 when done. Shifting
+	// back by one cell afterwards restores it.
+	sorted_agents.resize(agents.size());
+	for (std::uint32_t agent = 0; agent < agents.size(); agent++) {
+		sorted_agents[cell_start[agent_cell[agent]]++] = agent;
+	}
+	for (std::size_t cell = cell_start.size() - 1; cell > 0; cell--) {
+		cell_start[cell] = cell_start[cell - 1];
+	}
+	cell_start[0] = 0;
+
+	sorted_x.resize(agents.size());
+	sorted_y.resize(agents.size());
+	sorted_id.resize(agents.size());
+	sorted_cell.resize(agents.size());
+	sorted_gets_pushed.resize(agents.size());
+	for (std::size_t i = 0; i < sorted_agents.size(); i++) {
+		sorted_x[i] = agent_x[sorted_agents[i]];
+		sorted_y[i] = agent_y[sorted_agents[i]];
+		sorted_id[i] = agent_id[sorted_agents[i]];
+		sorted_cell[i] = agent_cell[sorted_agents[i]];
+		sorted_gets_pushed[i] = agent_gets_pushed[sorted_agents[i]];
+	}
+}
+
+int GFFN_CrowdSeparation::get_cell_population(int cell_x, int cell_y) const {
+	if (cell_x < 0 || cell_y < 0 || cell_x >= cells_wide || cell_y >= cells_high) {
+		return 0;
+	}
+	int cell = cell_y * cells_wide + cell_x;
+	return (int)(cell_start[cell + 1] - cell_start[cell]);
+}
+
+void GFFN_CrowdSeparation::compute_forces() {
+#ifdef GFFN_CROWD_SSE
+	const __m128 separation_distance_squared = _mm_set1_ps(SEPARATION_DISTANCE_SQUARED);
+	const __m128 coincident_distance_squared = _mm_set1_ps(COINCIDENT_DISTANCE_SQUARED);
+	const __m128 force_times_distance_squared = _mm_set1_ps(FORCE_AT_SEPARATION_DISTANCE * SEPARATION_DISTANCE_SQUARED);
+	const __m128 max_pair_force = _mm_set1_ps(MAX_PAIR_FORCE);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 three = _mm_set1_ps(3.0f);
+#endif
+	// Locals so the compiler doesn't reload the vectors after every store.
+	const float* const positions_x = sorted_x.data();
+	const float* const positions_y = sorted_y.data();
+	const std::uint32_t* const cells = cell_start.data();
+	std::size_t num_pairs = 0;
+	std::size_t num_capped = 0;
+	// Walks the agents cell by cell, so neighbouring agents (and the cells they scan) are next to each other in memory.
+	for (std::uint32_t me = 0; me < sorted_agents.size(); me++) {
+		if (!sorted_gets_pushed[me]) {
+			continue;
+		}
+		const float my_x = sorted_x[me];
+		const float my_y = sorted_y[me];
+		const int my_cell_x = sorted_cell[me] % cells_wide;
+		const int my_cell_y = sorted_cell[me] / cells_wide;
+		const int min_cell_x = std::max(my_cell_x - 1, 0);
+		const int max_cell_x = std::min(my_cell_x + 1, cells_wide - 1);
+		float total_x = 0;
+		float total_y = 0;
+		std::uint32_t num_left_to_scan = MAX_SCANNED_PER_AGENT;
+		int num_neighbors = 0;
+		bool capped = false;
+#ifdef GFFN_CROWD_SSE
+		const __m128 my_x4 = _mm_set1_ps(my_x);
+		const __m128 my_y4 = _mm_set1_ps(my_y);
+		__m128 total_x4 = _mm_setzero_ps();
+		__m128 total_y4 = _mm_setzero_ps();
+#endif
+
+		// The three cells in a row are next to each other in the sorted arrays, so each row is one range. Own row first,
+		// it has the closest neighbors.
+		static constexpr int ROW_ORDER[3] = { 0, -1, 1 };
+		for (int row : ROW_ORDER) {
+			const int cell_y = my_cell_y + row;
+			if (cell_y < 0 || cell_y >= cells_high) {
+				continue;
+			}
+			if (num_left_to_scan == 0 || num_neighbors >= MAX_NEIGHBORS_PER_AGENT) {
+				capped = true;
+				break;
+			}
+			const std::uint32_t row_start = cells[cell_y * cells_wide + min_cell_x];
+			const std::uint32_t row_end = cells[cell_y * cells_wide + max_cell_x + 1];
+			const std::uint32_t scan_end = std::min(row_end, row_start + num_left_to_scan);
+			capped |= scan_end < row_end;
+			num_left_to_scan -= scan_end - row_start;
+
+			std::uint32_t other = row_start;
+#ifdef GFFN_CROWD_SSE
+			for (; other + 4 <= scan_end; other += 4) {
+				__m128 dx = _mm_sub_ps(my_x4, _mm_loadu_ps(&positions_x[other]));
+				__m128 dy = _mm_sub_ps(my_y4, _mm_loadu_ps(&positions_y[other]));
+				__m128 distance_squared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+				__m128 coincident = _mm_cmplt_ps(distance_squared, coincident_distance_squared);
+				__m128 in_range = _mm_andnot_ps(coincident, _mm_cmplt_ps(distance_squared, separation_distance_squared));
+				num_neighbors += std::popcount((unsigned int)_mm_movemask_ps(in_range));
+				// rsqrt plus one Newton step is plenty for a push, and skips the slow divide and sqrt.
+				__m128 inverse_distance = _mm_rsqrt_ps(distance_squared);
+				inverse_distance = _mm_mul_ps(_mm_mul_ps(half, inverse_distance),
+					_mm_sub_ps(three, _mm_mul_ps(_mm_mul_ps(distance_squared, inverse_distance), inverse_distance)));
+				__m128 magnitude = _mm_min_ps(_mm_mul_ps(force_times_distance_squared, _mm_mul_ps(inverse_distance, inverse_distance)), max_pair_force);
+				magnitude = _mm_and_ps(_mm_mul_ps(magnitude, inverse_distance), in_range);
+				total_x4 = _mm_add_ps(total_x4, _mm_mul_ps(dx, magnitude));
+				total_y4 = _mm_add_ps(total_y4, _mm_mul_ps(dy, magnitude));
+				// Rare, so those go one by one. Our own entry always lands here.
+				int coincident_mask = _mm_movemask_ps(coincident);
+				for (int lane = 0; coincident_mask != 0; lane++, coincident_mask >>= 1) {
+					if ((coincident_mask & 1) && other + lane != me) {
+						add_coincident_force(me, other + lane, total_x, total_y);
+						num_neighbors++;
+					}
+				}
+			}
+#endif
+			for (; other < scan_end; other++) {
+				float dx = my_x - positions_x[other];
+				float dy = my_y - positions_y[other];
+				float distance_squared = dx * dx + dy * dy;
+				if (distance_squared < COINCIDENT_DISTANCE_SQUARED) {
+					if (other != me) {
+						add_coincident_force(me, other, total_x, total_y);
+						num_neighbors++;
+					}
+					continue;
+				}
+				if (distance_squared >= SEPARATION_DISTANCE_SQUARED) {
+					continue;
+				}
+				num_neighbors++;
+				// Same falloff as before, FORCE_AT_SEPARATION_DISTANCE * (R / d)^2, capped.
+				float inverse_distance = 1.0f / std::sqrt(distance_squared);
+				float magnitude = std::min(FORCE_AT_SEPARATION_DISTANCE * (SEPARATION_DISTANCE_SQUARED / distance_squared), MAX_PAIR_FORCE);
+				total_x += dx * inverse_distance * magnitude;
+				total_y += dy * inverse_distance * magnitude;
+			}
+		}
+#ifdef GFFN_CROWD_SSE
+		float lanes_x[4];
+		float lanes_y[4];
+		_mm_storeu_ps(lanes_x, total_x4);
+		_mm_storeu_ps(lanes_y, total_y4);
+		total_x += (lanes_x[0] + lanes_x[1]) + (lanes_x[2] + lanes_x[3]);
+		total_y += (lanes_y[0] + lanes_y[1]) + (lanes_y[2] + lanes_y[3]);
+#endif
+		num_pairs += num_neighbors;
+
+		if (capped || num_neighbors >= MAX_NEIGHBORS_PER_AGENT) {
+			// Too many to look at one by one. Push towards the emptier side instead, which is four lookups.
+			num_capped++;
+			float gradient_x = (float)(get_cell_population(my_cell_x + 1, my_cell_y) - get_cell_population(my_cell_x - 1, my_cell_y));
+			float gradient_y = (float)(get_cell_population(my_cell_x, my_cell_y + 1) - get_cell_population(my_cell_x, my_cell_y - 1));
+			total_x -= gradient_x * DENSITY_FORCE_PER_AGENT;
+			total_y -= gradient_y * DENSITY_FORCE_PER_AGENT;
+		}
+		force_x[sorted_agents[me]] = total_x;
+		force_y[sorted_agents[me]] = total_y;
+	}
+	num_pairs_last_tick = num_pairs;
+	num_capped_last_tick = num_capped;
+}
+
+void GFFN_CrowdSeparation::tick(std::vector<GFFN_GameObject*>::iterator begin, std::vector<GFFN_GameObject*>::iterator end,
+	GFFN_SimulationLOD const& lod) {
+	GFFN_PROFILE_SCOPE("crowd_separation.tick");
+	gather_agents(begin, end, lod);
+	bucket_agents();
+	compute_forces();
+	for (std::size_t agent = 0; agent < agents.size(); agent++) {
+		if (force_x[agent] != 0.0f || force_y[agent] != 0.0f) {
+			agents[agent]->get_physics_controller().add_force(physics::Vector3Df(force_x[agent], force_y[agent], 0.0f));
+		}
+	}
+}
+
+} // end namespace gffn
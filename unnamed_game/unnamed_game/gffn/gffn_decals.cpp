@@ -0,0 +1,46 @@
+#include <gffn_decals.h>
+#include <gffn_profiler.h>
+#include <gffn_render_stats.h>
+#include <gffn_frame_stats.h>
+
+#include <algorithm>
+
+namespace gffn {
+
+void GFFN_DecalQueue::flush(SDL_Renderer* renderer, SDL_Texture* target) {
+	GFFN_PROFILE_SCOPE("decal_queue.flush");
+	num_flushed_last_frame = 0;
+	if (decals.empty()) {
+		return;
+	}
+	std::size_t num_to_flush = decals.size();
+	if (budget_per_frame > 0 && num_to_flush > budget_per_frame) {
+		num_to_flush = budget_per_frame;
+	}
+	// Everything before num_to_flush is older than everything after it, so sorting just that part keeps the leftovers
+	// first in line for the next frame.
+	std::sort(decals.begin(), decals.begin() + num_to_flush, [](GFFN_Decal const& first, GFFN_Decal const& second) {
+		if (first.texture != second.texture) {
+			return first.texture < second.texture;
+		}
+		return first.sequence < second.sequence;
+	});
+
+	SDL_Texture* previous_target = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, target);
+	for (std::size_t i = 0; i < num_to_flush; i++) {
+		GFFN_Decal const& decal = decals[i];
+		SDL_RenderCopy(renderer, decal.texture, decal.has_source_rect ? &decal.source_rect : nullptr, &decal.dest_rect);
+		render_stats::count_draw(decal.texture);
+	}
+	SDL_SetRenderTarget(renderer, previous_target);
+
+	decals.erase(decals.begin(), decals.begin() + num_to_flush);
+	num_flushed_last_frame = num_to_flush;
+	frame_stats::count(GFFN_FRAME_COUNTER_DECALS_BAKED, (std::uint32_t)num_to_flush);
+	if (decals.empty()) {
+		next_sequence = 0;
+	}
+}
+
+} // end namespace gffn
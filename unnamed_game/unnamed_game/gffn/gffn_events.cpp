@@ -1,6 +1,22 @@
 #include <gffn_events.h>
+
+#include <atomic>
+#include <string>
+
 namespace gffn { namespace events {
 
-EventQueue event_queue;
+EventBus event_bus;
+
+namespace {
+std::atomic<std::size_t> num_producer_threads{ 0 };
+}
+
+std::size_t get_producer_thread_index() {
+	thread_local std::size_t thread_index = num_producer_threads.fetch_add(1);
+	if (thread_index >= MAX_PRODUCER_THREADS) {
+		throw GFFN_Exception(std::string("Too many threads pushing events, raise MAX_PRODUCER_THREADS"));
+	}
+	return thread_index;
+}
 
-}} // end namespace gffn::events
\ No newline at end of file
+}} // end namespace gffn::events
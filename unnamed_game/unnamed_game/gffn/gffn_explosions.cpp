@@ -0,0 +1,117 @@
+#include <gffn_explosions.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFFN_EXPLOSIONS_SSE
+#include <emmintrin.h>
+#endif
+
+namespace gffn {
+
+namespace {
+constexpr int GRID_CELL_SIZE = 100;
+}
+
+void GFFN_ExplosionSystem::gather_candidates(WorldCoordinatef center, float radius) {
+	candidates.clear();
+	candidate_x.clear();
+	candidate_y.clear();
+
+	int min_cell_x = std::max((int)std::floor((center.x - radius) / GRID_CELL_SIZE), 0);
+	int max_cell_x = std::min((int)std::floor((center.x + radius) / GRID_CELL_SIZE), WORLD_GRID_WIDTH - 1);
+	int min_cell_y = std::max((int)std::floor((center.y - radius) / GRID_CELL_SIZE), 0);
+	int max_cell_y = std::min((int)std::floor((center.y + radius) / GRID_CELL_SIZE), WORLD_GRID_HEIGHT - 1);
+	float radius_squared = radius * radius;
+	for (int cell_x = min_cell_x; cell_x <= max_cell_x; cell_x++) {
+		for (int cell_y = min_cell_y; cell_y <= max_cell_y; cell_y++) {
+			// Skip corner cells the circle doesn't actually reach.
+			float nearest_x = std::clamp(center.x, (float)(cell_x * GRID_CELL_SIZE), (float)((cell_x + 1) * GRID_CELL_SIZE));
+			float nearest_y = std::clamp(center.y, (float)(cell_y * GRID_CELL_SIZE), (float)((cell_y + 1) * GRID_CELL_SIZE));
+			float dx = nearest_x - center.x;
+			float dy = nearest_y - center.y;
+			if (dx * dx + dy * dy > radius_squared) {
+				continue;
+			}
+			for (GFFN_GameObject* const object : world_grid[cell_x][cell_y]) {
+				GFFN_ObjectType object_type = object->get_object_type();
+				if (object_type != GFFN_OBJECT_TYPE_NPC && object_type != GFFN_OBJECT_TYPE_CHARACTER) {
+					continue;
+				}
+				GFFN_Character* character = static_cast<GFFN_Character*>(object);
+				if (character->is_dead()) {
+					continue;
+				}
+				WorldCoordinatef coords = character->get_floor_coordsf();
+				candidates.push_back(character);
+				candidate_x.push_back(coords.x);
+				candidate_y.push_back(coords.y);
+			}
+		}
+	}
+	falloff.resize(candidates.size());
+	distance.resize(candidates.size());
+}
+
+void GFFN_ExplosionSystem::compute_falloff(WorldCoordinatef center, float radius) {
+	const std::size_t count = candidates.size();
+	const float inverse_radius = 1.0f / radius;
+	std::size_t i = 0;
+#ifdef GFFN_EXPLOSIONS_SSE
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 inv_r = _mm_set1_ps(inverse_radius);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&candidate_x[i]), cx);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&candidate_y[i]), cy);
+		__m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		_mm_storeu_ps(&distance[i], d);
+		_mm_storeu_ps(&falloff[i], _mm_sub_ps(one, _mm_mul_ps(d, inv_r)));
+	}
+#endif
+	for (; i < count; i++) {
+		float dx = candidate_x[i] - center.x;
+		float dy = candidate_y[i] - center.y;
+		distance[i] = std::sqrt(dx * dx + dy * dy);
+		falloff[i] = 1.0f - distance[i] * inverse_radius;
+	}
+}
+
+void GFFN_ExplosionSystem::process(events::ExplosionEvent& explosion) {
+	if (explosion.blast_radius <= 0) {
+		return;
+	}
+	// Everything up to the knockback is float, the same as the candidate arrays. Only the momentum handed to each
+	// character goes back to double.
+	float radius = (float)explosion.blast_radius;
+	const WorldCoordinatef center(explosion.coordinates);
+	gather_candidates(center, radius);
+	compute_falloff(center, radius);
+	num_candidates_last_frame += candidates.size();
+
+	for (std::size_t i = 0; i < candidates.size(); i++) {
+		float t = falloff[i];
+		if (t < 0.0f) {
+			continue;
+		}
+		GFFN_Character* character = candidates[i];
+		int damage = explosion.min_damage + (int)((explosion.power - explosion.min_damage) * t);
+		character->change_hp(-damage);
+
+		// Coincident with the center has no direction, so it just goes straight up.
+		physics::Vector3Df knockback(0, 0, (float)UPWARD_MOMENTUM_FRACTION);
+		if (distance[i] > 0.001f) {
+			float inverse_distance = 1.0f / distance[i];
+			knockback.x = (candidate_x[i] - center.x) * inverse_distance;
+			knockback.y = (candidate_y[i] - center.y) * inverse_distance;
+		}
+		character->get_physics_controller().transfer_momentum(knockback * (float)(explosion.power * MOMENTUM_PER_POWER * t));
+
+		explosion.objects_hit.push_back(events::ExplosionHit{ character->get_object_id(), character->get_object_type(), damage, character->is_dead() });
+		num_hits_last_frame++;
+	}
+}
+
+} // end namespace gffn
@@ -0,0 +1,189 @@
+#include <gffn_flow_field.h>
+#include <gffn_profiler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace gffn {
+
+namespace {
+constexpr int GRID_CELL_SIZE = 100;
+
+// The 8 neighbours, straight ones first. OPPOSITE[d] is the way back.
+constexpr int DIRECTION_X[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+constexpr int DIRECTION_Y[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+constexpr std::uint8_t OPPOSITE[8] = { 1, 0, 3, 2, 7, 6, 5, 4 };
+constexpr double DIAGONAL = 0.70710678118654752;
+constexpr double UNIT_X[8] = { 1, -1, 0, 0, DIAGONAL, -DIAGONAL, DIAGONAL, -DIAGONAL };
+constexpr double UNIT_Y[8] = { 0, 0, 1, -1, DIAGONAL, DIAGONAL, -DIAGONAL, -DIAGONAL };
+}
+
+GFFN_FlowField::GFFN_FlowField() {
+	num_blockers.assign(NUM_CELLS, 0);
+	for (Field& field : fields) {
+		field.distance.assign(NUM_CELLS, UNREACHABLE);
+		field.direction.assign(NUM_CELLS, NO_DIRECTION);
+	}
+	open.reserve(NUM_CELLS);
+}
+
+int GFFN_FlowField::get_cell(WorldCoordinate coords) {
+	int cell_x = std::clamp((int)(coords.x / GRID_CELL_SIZE), 0, WORLD_GRID_WIDTH - 1);
+	int cell_y = std::clamp((int)(coords.y / GRID_CELL_SIZE), 0, WORLD_GRID_HEIGHT - 1);
+	return cell_y * WORLD_GRID_WIDTH + cell_x;
+}
+
+void GFFN_FlowField::set_goal(WorldCoordinate coords) {
+	goal = coords;
+	int cell = get_cell(coords);
+	if (cell != goal_cell) {
+		goal_cell = cell;
+		needs_search = true;
+	}
+	// Same cell, so the field is still right. Only the spot NPCs walk to in the last cell moves.
+	if (fields[front].goal_cell == goal_cell) {
+		fields[front].goal = goal;
+	}
+}
+
+void GFFN_FlowField::add_blocker(WorldCoordinate coords) {
+	std::uint8_t& blockers = num_blockers[get_cell(coords)];
+	if (blockers < 0xFF) {
+		blockers++;
+	}
+	needs_search = blockers == 1 || needs_search;
+}
+
+void GFFN_FlowField::remove_blocker(WorldCoordinate coords) {
+	std::uint8_t& blockers = num_blockers[get_cell(coords)];
+	if (blockers > 0) {
+		blockers--;
+		needs_search = blockers == 0 || needs_search;
+	}
+}
+
+bool GFFN_FlowField::is_blocked(WorldCoordinate coords) const {
+	return num_blockers[get_cell(coords)] > 0;
+}
+
+bool GFFN_FlowField::can_step(int cell_x, int cell_y, int direction) const {
+	int next_x = cell_x + DIRECTION_X[direction];
+	int next_y = cell_y + DIRECTION_Y[direction];
+	if (next_x < 0 || next_y < 0 || next_x >= WORLD_GRID_WIDTH || next_y >= WORLD_GRID_HEIGHT) {
+		return false;
+	}
+	if (num_blockers[next_y * WORLD_GRID_WIDTH + next_x] > 0) {
+		return false;
+	}
+	// No cutting corners past a tree.
+	if (DIRECTION_X[direction] != 0 && DIRECTION_Y[direction] != 0) {
+		return num_blockers[cell_y * WORLD_GRID_WIDTH + next_x] == 0 && num_blockers[next_y * WORLD_GRID_WIDTH + cell_x] == 0;
+	}
+	return true;
+}
+
+void GFFN_FlowField::start_search() {
+	Field& back = fields[1 - front];
+	std::fill(back.distance.begin(), back.distance.end(), UNREACHABLE);
+	std::fill(back.direction.begin(), back.direction.end(), NO_DIRECTION);
+	back.goal = goal;
+	back.goal_cell = goal_cell;
+	back.distance[goal_cell] = 0;
+	open.clear();
+	open.push_back(OpenCell{ 0, goal_cell });
+	search_running = true;
+	needs_search = false;
+}
+
+void GFFN_FlowField::run_search(int max_cells) {
+	Field& back = fields[1 - front];
+	int num_expanded = 0;
+	while (!open.empty() && num_expanded < max_cells) {
+		std::pop_heap(open.begin(), open.end(), std::greater<OpenCell>());
+		OpenCell current = open.back();
+		open.pop_back();
+		if (current.distance > back.distance[current.cell]) {
+			continue; // already reached cheaper
+		}
+		num_expanded++;
+		int cell_x = current.cell % WORLD_GRID_WIDTH;
+		int cell_y = current.cell / WORLD_GRID_WIDTH;
+		for (int direction = 0; direction < 8; direction++) {
+			if (!can_step(cell_x, cell_y, direction)) {
+				continue;
+			}
+			int next = (cell_y + DIRECTION_Y[direction]) * WORLD_GRID_WIDTH + cell_x + DIRECTION_X[direction];
+			std::uint32_t distance = current.distance + (direction < 4 ? STRAIGHT_COST : DIAGONAL_COST);
+			if (distance < back.distance[next]) {
+				back.distance[next] = distance;
+				back.direction[next] = OPPOSITE[direction];
+				open.push_back(OpenCell{ distance, next });
+				std::push_heap(open.begin(), open.end(), std::greater<OpenCell>());
+			}
+		}
+	}
+	cells_expanded_last_tick += num_expanded;
+	if (open.empty()) {
+		search_running = false;
+		front = 1 - front;
+		fields[front].goal = goal;
+		num_searches_finished++;
+	}
+}
+
+void GFFN_FlowField::tick() {
+	GFFN_PROFILE_SCOPE("flow_field.tick");
+	cells_expanded_last_tick = 0;
+	if (goal_cell < 0) {
+		return;
+	}
+	// A running search is finished before the next one starts from wherever the goal is by then. Restarting it whenever
+	// the goal changed cells would never finish one while the player runs faster than a cell per search.
+	if (needs_search && !search_running) {
+		start_search();
+	}
+	if (search_running) {
+		run_search(MAX_CELLS_PER_TICK);
+	}
+}
+
+bool GFFN_FlowField::get_direction(WorldCoordinate coords, physics::Vector3D& direction) const {
+	Field const& field = fields[front];
+	if (field.goal_cell < 0) {
+		return false;
+	}
+	int cell = get_cell(coords);
+	if (cell == field.goal_cell) {
+		double dx = field.goal.x - coords.x;
+		double dy = field.goal.y - coords.y;
+		double distance = std::sqrt(dx * dx + dy * dy);
+		if (distance < 1.0) {
+			// Already there. Still a path, just nowhere left to go.
+			direction = physics::Vector3D(0.0, 0.0, 0.0);
+			return true;
+		}
+		direction = physics::Vector3D(dx / distance, dy / distance, 0.0);
+		return true;
+	}
+	std::uint8_t step = field.direction[cell];
+	if (step == NO_DIRECTION) {
+		return false;
+	}
+	direction = physics::Vector3D(UNIT_X[step], UNIT_Y[step], 0.0);
+	return true;
+}
+
+double GFFN_FlowField::get_distance_to_goal(WorldCoordinate coords) const {
+	Field const& field = fields[front];
+	if (field.goal_cell < 0) {
+		return -1;
+	}
+	std::uint32_t distance = field.distance[get_cell(coords)];
+	if (distance == UNREACHABLE) {
+		return -1;
+	}
+	return (double)distance * (GRID_CELL_SIZE / (double)STRAIGHT_COST);
+}
+
+} // end namespace gffn
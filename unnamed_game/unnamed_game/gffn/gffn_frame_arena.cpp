@@ -0,0 +1,71 @@
+#include <gffn_frame_arena.h>
+#include <gffn_exception.h>
+
+#include <algorithm>
+#include <new>
+#include <string>
+
+namespace gffn {
+
+GFFN_FrameArena frame_arena;
+
+namespace {
+// Every block is aligned to a cache line, which covers anything the game allocates.
+constexpr std::size_t ARENA_BLOCK_ALIGN = 64;
+}
+
+GFFN_FrameArena::GFFN_FrameArena(std::size_t capacity) : capacity(capacity) {
+	if (capacity > 0) {
+		buffer = static_cast<std::byte*>(::operator new(capacity, std::align_val_t(ARENA_BLOCK_ALIGN)));
+	}
+	memory::add_reserved_bytes(GFFN_MEMORY_TAG_FRAME_ARENA, (std::ptrdiff_t)capacity);
+}
+
+GFFN_FrameArena::~GFFN_FrameArena() {
+	memory::add_reserved_bytes(GFFN_MEMORY_TAG_FRAME_ARENA, -(std::ptrdiff_t)(capacity + overflow_bytes));
+	for (std::byte* block : overflow_blocks) {
+		::operator delete(block, std::align_val_t(ARENA_BLOCK_ALIGN));
+	}
+	if (buffer != nullptr) {
+		::operator delete(buffer, std::align_val_t(ARENA_BLOCK_ALIGN));
+	}
+}
+
+void* GFFN_FrameArena::allocate_overflow(std::size_t size, std::size_t align) {
+	if (align > ARENA_BLOCK_ALIGN) {
+		throw GFFN_Exception(std::string("GFFN_FrameArena can't align past a cache line"));
+	}
+	std::byte* block = static_cast<std::byte*>(::operator new(std::max<std::size_t>(size, 1), std::align_val_t(ARENA_BLOCK_ALIGN)));
+	overflow_blocks.push_back(block);
+	overflow_bytes += size;
+	memory::add_reserved_bytes(GFFN_MEMORY_TAG_FRAME_ARENA, (std::ptrdiff_t)size);
+	num_overflows++;
+	return block;
+}
+
+void GFFN_FrameArena::reset() {
+	std::size_t used_bytes = offset + overflow_bytes;
+	high_water_bytes = std::max(high_water_bytes, used_bytes);
+	memory::track_free(GFFN_MEMORY_TAG_FRAME_ARENA, used_bytes, num_allocations);
+	num_allocations = 0;
+	offset = 0;
+	if (overflow_blocks.empty()) {
+		return;
+	}
+
+	// This frame didn't fit. Swap everything for one buffer with room to spare so the next ones do.
+	for (std::byte* block : overflow_blocks) {
+		::operator delete(block, std::align_val_t(ARENA_BLOCK_ALIGN));
+	}
+	overflow_blocks.clear();
+	memory::add_reserved_bytes(GFFN_MEMORY_TAG_FRAME_ARENA, -(std::ptrdiff_t)(capacity + overflow_bytes));
+	overflow_bytes = 0;
+	if (buffer != nullptr) {
+		::operator delete(buffer, std::align_val_t(ARENA_BLOCK_ALIGN));
+	}
+	capacity = std::max(capacity * 2, high_water_bytes + (high_water_bytes / 2));
+	buffer = static_cast<std::byte*>(::operator new(capacity, std::align_val_t(ARENA_BLOCK_ALIGN)));
+	memory::add_reserved_bytes(GFFN_MEMORY_TAG_FRAME_ARENA, (std::ptrdiff_t)capacity);
+}
+
+} // end namespace gffn
@@ -0,0 +1,171 @@
+#include <gffn_frame_stats.h>
+#include <gffn_render_stats.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <format>
+
+namespace gffn {
+
+void GFFN_TimingWindow::add(double ms) {
+	if (samples.empty()) {
+		return;
+	}
+	if (num_samples == samples.size()) {
+		buckets[get_bucket(samples[next_sample])]--;
+	}
+	else {
+		num_samples++;
+	}
+	// Bucketed from the stored float, the same value it'll be taken back out with.
+	samples[next_sample] = (float)ms;
+	buckets[get_bucket(samples[next_sample])]++;
+	next_sample = (next_sample + 1) % samples.size();
+}
+
+void GFFN_TimingWindow::clear() {
+	buckets.fill(0);
+	next_sample = 0;
+	num_samples = 0;
+}
+
+double GFFN_TimingWindow::get_percentile(double percentile) const {
+	if (num_samples == 0) {
+		return 0;
+	}
+	// Nearest rank: the smallest bucket with at least percentile of the samples at or below it.
+	std::size_t rank = (std::size_t)(percentile / 100.0 * num_samples + 0.999999);
+	rank = std::clamp<std::size_t>(rank, 1, num_samples);
+	std::size_t seen = 0;
+	for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		seen += buckets[bucket];
+		if (seen >= rank) {
+			return std::min((bucket + 1) * BUCKET_MS, get_max());
+		}
+	}
+	return get_max();
+}
+
+double GFFN_TimingWindow::get_max() const {
+	float max = 0;
+	for (std::size_t i = 0; i < num_samples; i++) {
+		max = std::max(max, samples[i]);
+	}
+	return max;
+}
+
+GFFN_TimingPercentiles GFFN_TimingWindow::get_percentiles() const {
+	return GFFN_TimingPercentiles{ get_percentile(50), get_percentile(95), get_percentile(99), get_max(), num_samples };
+}
+
+namespace frame_stats {
+
+std::array<std::uint32_t, GFFN_FRAME_COUNTER_END> frame_counters{};
+
+namespace {
+GFFN_TimingWindow short_frame_window(SHORT_WINDOW_FRAMES);
+GFFN_TimingWindow long_frame_window(LONG_WINDOW_FRAMES);
+GFFN_TimingWindow short_tick_window(SHORT_WINDOW_FRAMES);
+GFFN_TimingWindow long_tick_window(LONG_WINDOW_FRAMES);
+
+double hitch_multiple = 2.5;
+double min_hitch_ms = 8.0;
+std::uint64_t num_frames = 0;
+std::uint64_t num_hitches = 0;
+double session_ms = 0;
+GFFN_Hitch last_hitch{};
+std::ofstream hitch_log;
+}
+
+const char* get_counter_name(GFFN_FrameCounter counter) {
+	switch (counter) {
+	case GFFN_FRAME_COUNTER_OBJECTS_SPAWNED: return "objects_spawned";
+	case GFFN_FRAME_COUNTER_OBJECTS_REMOVED: return "objects_removed";
+	case GFFN_FRAME_COUNTER_EVENTS_DISPATCHED: return "events_dispatched";
+	case GFFN_FRAME_COUNTER_DECALS_BAKED: return "decals_baked";
+	case GFFN_FRAME_COUNTER_TEXTURES_LOADED: return "textures_loaded";
+	default: return "unknown";
+	}
+}
+
+bool end_frame(double frame_ms, double tick_ms) {
+	num_frames++;
+	session_ms += frame_ms;
+	bool hitch = false;
+	// Checked against the frames before this one, so a hitch doesn't raise its own bar.
+	if (short_frame_window.get_num_samples() == short_frame_window.get_window_size()) {
+		double median_ms = short_frame_window.get_percentile(50);
+		if (frame_ms > median_ms * hitch_multiple && frame_ms > min_hitch_ms) {
+			hitch = true;
+			num_hitches++;
+			last_hitch.frame = num_frames;
+			last_hitch.session_seconds = session_ms / 1000.0;
+			last_hitch.frame_ms = frame_ms;
+			last_hitch.tick_ms = tick_ms;
+			last_hitch.median_ms = median_ms;
+			last_hitch.counters = frame_counters;
+			last_hitch.draw_calls = render_stats::last_frame.draw_calls;
+			if (hitch_log.is_open()) {
+				hitch_log << hitch_to_json(last_hitch) << std::endl;
+			}
+			printf("Hitch on frame %llu: %.2f ms (median %.2f ms, tick %.2f ms)\n", (unsigned long long)num_frames, frame_ms, median_ms, tick_ms);
+		}
+	}
+	short_frame_window.add(frame_ms);
+	long_frame_window.add(frame_ms);
+	short_tick_window.add(tick_ms);
+	long_tick_window.add(tick_ms);
+	frame_counters.fill(0);
+	return hitch;
+}
+
+void set_hitch_threshold(double multiple, double min_ms) {
+	hitch_multiple = multiple;
+	min_hitch_ms = min_ms;
+}
+
+bool open_hitch_log(std::string const& filename) {
+	hitch_log.close();
+	hitch_log.open(filename, std::ios::app);
+	return hitch_log.is_open();
+}
+
+void close_hitch_log() {
+	hitch_log.close();
+}
+
+GFFN_TimingWindow const& get_frame_window(bool long_window) {
+	return long_window ? long_frame_window : short_frame_window;
+}
+
+GFFN_TimingWindow const& get_tick_window(bool long_window) {
+	return long_window ? long_tick_window : short_tick_window;
+}
+
+std::uint64_t get_num_frames() {
+	return num_frames;
+}
+
+std::uint64_t get_num_hitches() {
+	return num_hitches;
+}
+
+GFFN_Hitch const& get_last_hitch() {
+	return last_hitch;
+}
+
+std::string hitch_to_json(GFFN_Hitch const& hitch) {
+	GFFN_TimingPercentiles frames = long_frame_window.get_percentiles();
+	std::string json = std::format("{{ \"frame\": {}, \"session_seconds\": {:.3f}, \"frame_ms\": {:.3f}, \"tick_ms\": {:.3f}, "
+		"\"median_ms\": {:.3f}, \"long_window_p99_ms\": {:.3f}, \"draw_calls\": {}",
+		hitch.frame, hitch.session_seconds, hitch.frame_ms, hitch.tick_ms, hitch.median_ms, frames.p99_ms, hitch.draw_calls);
+	for (int i = 0; i < GFFN_FRAME_COUNTER_END; i++) {
+		json += std::format(", \"{}\": {}", get_counter_name((GFFN_FrameCounter)i), hitch.counters[i]);
+	}
+	json += " }";
+	return json;
+}
+
+} // end namespace frame_stats
+
+} // end namespace gffn
@@ -0,0 +1,162 @@
+#include <gffn_input.h>
+#include <gffn_renderer.h>
+#include <gffn_camera.h>
+#include <gffn_exception.h>
+
+#include <SDL.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace gffn { namespace input {
+
+namespace {
+constexpr char LOG_MAGIC[8] = { 'G', 'F', 'F', 'N', 'I', 'N', 'P', 'T' };
+constexpr std::uint32_t LOG_VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 8 + 4 + 8 + 8;
+constexpr std::size_t FRAME_SIZE = 16;
+
+constexpr std::array<SDL_Scancode, GFFN_INPUT_KEY_END> KEY_SCANCODES = {
+	SDL_SCANCODE_W, SDL_SCANCODE_A, SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_SPACE,
+	SDL_SCANCODE_F, SDL_SCANCODE_R, SDL_SCANCODE_M, SDL_SCANCODE_ESCAPE, SDL_SCANCODE_T, SDL_SCANCODE_F3,
+	SDL_SCANCODE_F9
+};
+constexpr std::array<int, GFFN_INPUT_MOUSE_END> MOUSE_BUTTONS = { SDL_BUTTON_LEFT, SDL_BUTTON_MIDDLE, SDL_BUTTON_RIGHT };
+
+// Logs are little endian whatever the machine is.
+void put_le(unsigned char* out, std::uint64_t value, int num_bytes) {
+	for (int i = 0; i < num_bytes; i++) {
+		out[i] = (unsigned char)(value >> (8 * i));
+	}
+}
+std::uint64_t get_le(unsigned char const* in, int num_bytes) {
+	std::uint64_t value = 0;
+	for (int i = 0; i < num_bytes; i++) {
+		value |= (std::uint64_t)in[i] << (8 * i);
+	}
+	return value;
+}
+std::uint64_t double_bits(double value) {
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+double bits_double(std::uint64_t bits) {
+	double value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+}
+
+InputFrame read_live_input(GFFN_Renderer& renderer, GFFN_Camera const& camera) {
+	InputFrame frame;
+	int wheel = 0;
+	SDL_Event e;
+	while (SDL_PollEvent(&e) > 0) {
+		if (e.type == SDL_QUIT) {
+			frame.quit = true;
+		}
+		if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+			for (int key = 0; key < GFFN_INPUT_KEY_END; key++) {
+				if (e.key.keysym.scancode == KEY_SCANCODES[key]) {
+					frame.pressed_keys |= (std::uint16_t)(1 << key);
+				}
+			}
+		}
+		if (e.type == SDL_MOUSEWHEEL) {
+			wheel += e.wheel.y;
+		}
+	}
+	frame.wheel = (std::int8_t)(wheel > 127 ? 127 : (wheel < -127 ? -127 : wheel));
+
+	const Uint8* keystate = SDL_GetKeyboardState(nullptr);
+	for (int key = 0; key < GFFN_INPUT_KEY_END; key++) {
+		if (keystate[KEY_SCANCODES[key]]) {
+			frame.held_keys |= (std::uint16_t)(1 << key);
+		}
+	}
+	const Uint32 mouse_state = SDL_GetMouseState(nullptr, nullptr);
+	for (int button = 0; button < GFFN_INPUT_MOUSE_END; button++) {
+		if (mouse_state & SDL_BUTTON(MOUSE_BUTTONS[button])) {
+			frame.mouse_buttons |= (std::uint8_t)(1 << button);
+		}
+	}
+	frame.mouse_coords = renderer.get_mouse_position_as_coordinate(camera);
+	return frame;
+}
+
+bool GFFN_InputRecorder::open(std::string const& filename, std::uint64_t seed, double fixed_delta_time_seconds) {
+	file.open(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	unsigned char header[HEADER_SIZE];
+	std::memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+	put_le(header + 8, LOG_VERSION, 4);
+	put_le(header + 12, seed, 8);
+	put_le(header + 20, double_bits(fixed_delta_time_seconds), 8);
+	file.write((char const*)header, HEADER_SIZE);
+	num_frames = 0;
+	return file.good();
+}
+
+void GFFN_InputRecorder::record(InputFrame const& frame) {
+	if (!file.is_open()) {
+		return;
+	}
+	unsigned char out[FRAME_SIZE] = {};
+	put_le(out, frame.held_keys, 2);
+	put_le(out + 2, frame.pressed_keys, 2);
+	out[4] = frame.mouse_buttons;
+	out[5] = (unsigned char)frame.wheel;
+	out[6] = frame.quit ? 1 : 0;
+	// Mouse coordinates come from whole logical pixels, so they fit an int exactly.
+	put_le(out + 8, (std::uint32_t)(std::int32_t)std::lround(frame.mouse_coords.x), 4);
+	put_le(out + 12, (std::uint32_t)(std::int32_t)std::lround(frame.mouse_coords.y), 4);
+	file.write((char const*)out, FRAME_SIZE);
+	num_frames++;
+}
+
+bool GFFN_InputReplay::load(std::string const& filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	unsigned char header[HEADER_SIZE];
+	if (!file.read((char*)header, HEADER_SIZE) || std::memcmp(header, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+		throw GFFN_Exception(std::string("Not an input log: ") + filename);
+	}
+	std::uint32_t version = (std::uint32_t)get_le(header + 8, 4);
+	if (version != LOG_VERSION) {
+		throw GFFN_Exception(std::format("Input log {} is version {}, expected {}", filename, version, LOG_VERSION));
+	}
+	seed = get_le(header + 12, 8);
+	fixed_delta_time_seconds = bits_double(get_le(header + 20, 8));
+
+	frames.clear();
+	next = 0;
+	unsigned char in[FRAME_SIZE];
+	while (file.read((char*)in, FRAME_SIZE)) {
+		InputFrame frame;
+		frame.delta_time_seconds = fixed_delta_time_seconds;
+		frame.held_keys = (std::uint16_t)get_le(in, 2);
+		frame.pressed_keys = (std::uint16_t)get_le(in + 2, 2);
+		frame.mouse_buttons = in[4];
+		frame.wheel = (std::int8_t)in[5];
+		frame.quit = in[6] != 0;
+		frame.mouse_coords = WorldCoordinate((std::int32_t)(std::uint32_t)get_le(in + 8, 4), (std::int32_t)(std::uint32_t)get_le(in + 12, 4), 0);
+		frames.push_back(frame);
+	}
+	return true;
+}
+
+bool GFFN_InputReplay::next_frame(InputFrame& frame) {
+	if (next >= frames.size()) {
+		return false;
+	}
+	frame = frames[next++];
+	return true;
+}
+
+}} // end namespace gffn::input
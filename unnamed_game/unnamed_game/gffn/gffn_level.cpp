@@ -0,0 +1,271 @@
+#include <gffn_level.h>
+#include <gffn_exception.h>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gffn {
+
+namespace {
+constexpr char LEVEL_MAGIC[8] = { 'G', 'F', 'F', 'N', 'L', 'E', 'V', 'L' };
+
+std::uint64_t align_section(std::uint64_t offset) {
+	return (offset + 7) & ~(std::uint64_t)7;
+}
+}
+
+bool GFFN_MappedFile::open(std::string const& filename) {
+	close();
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_handle = file;
+	mapping_handle = mapping;
+	data = (const unsigned char*)view;
+	size = (std::size_t)file_size.QuadPart;
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* view = mmap(nullptr, (std::size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps the file alive on its own.
+	::close(fd);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	// Loading reads every record front to back once.
+	madvise(view, (std::size_t)file_stat.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+	data = (const unsigned char*)view;
+	size = (std::size_t)file_stat.st_size;
+#endif
+	return true;
+}
+
+void GFFN_MappedFile::close() {
+	if (data == nullptr) {
+		return;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+	CloseHandle(mapping_handle);
+	CloseHandle(file_handle);
+	file_handle = nullptr;
+	mapping_handle = nullptr;
+#else
+	munmap((void*)data, size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+bool GFFN_Level::load(std::string const& filename) {
+	header = nullptr;
+	if (!file.open(filename)) {
+		return false;
+	}
+	if (file.get_size() < sizeof(GFFN_LevelHeader) || std::memcmp(file.get_data(), LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0) {
+		throw GFFN_Exception(std::string("Not a level: ") + filename);
+	}
+	const GFFN_LevelHeader* new_header = reinterpret_cast<const GFFN_LevelHeader*>(file.get_data());
+	if (new_header->version != LEVEL_VERSION) {
+		throw GFFN_Exception(std::format("Level {} is version {}, expected {}", filename, new_header->version, LEVEL_VERSION));
+	}
+	// world_grid is a fixed size, so a level has to be made for it.
+	if (new_header->grid_width != WORLD_GRID_WIDTH || new_header->grid_height != WORLD_GRID_HEIGHT) {
+		throw GFFN_Exception(std::format("Level {} is {}x{} cells, the world is {}x{}", filename,
+			new_header->grid_width, new_header->grid_height, WORLD_GRID_WIDTH, WORLD_GRID_HEIGHT));
+	}
+	auto check_section = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t record_size, const char* name) {
+		if (offset % 8 != 0 || offset > file.get_size() || count > (file.get_size() - offset) / record_size) {
+			throw GFFN_Exception(std::format("Level {} is truncated or corrupt: {} section doesn't fit", filename, name));
+		}
+	};
+	check_section(new_header->textures_offset, new_header->num_textures, sizeof(GFFN_LevelTexture), "texture");
+	check_section(new_header->cells_offset, (std::uint64_t)new_header->grid_width * new_header->grid_height, sizeof(GFFN_LevelCell), "cell");
+	check_section(new_header->static_objects_offset, new_header->num_static_objects, sizeof(GFFN_LevelStaticObject), "static object");
+	check_section(new_header->npcs_offset, new_header->num_npcs, sizeof(GFFN_LevelNPC), "NPC");
+	check_section(new_header->ground_tiles_offset, new_header->num_ground_tiles, sizeof(GFFN_LevelGroundTile), "ground tile");
+	header = new_header;
+
+	// The loader trusts these, so a bad cell range or texture index is caught here instead of read past the mapping.
+	for (GFFN_LevelCell const& cell : get_cells()) {
+		if ((std::uint64_t)cell.first_static_object + cell.num_static_objects > header->num_static_objects
+			|| (std::uint64_t)cell.first_npc + cell.num_npcs > header->num_npcs) {
+			header = nullptr;
+			throw GFFN_Exception(std::format("Level {} has a cell range past the end of its records", filename));
+		}
+	}
+	// Only shadows can be left out, everything else is sized from its texture.
+	auto valid_texture = [this](std::uint16_t texture) { return texture == LEVEL_NO_TEXTURE || texture < header->num_textures; };
+	for (GFFN_LevelStaticObject const& object : get_static_objects()) {
+		if (object.texture >= header->num_textures || !valid_texture(object.shadow_texture)) {
+			header = nullptr;
+			throw GFFN_Exception(std::format("Level {} has a static object with a bad texture index", filename));
+		}
+	}
+	for (GFFN_LevelNPC const& npc : get_npcs()) {
+		if (npc.animation_texture >= header->num_textures || !valid_texture(npc.shadow_texture)) {
+			header = nullptr;
+			throw GFFN_Exception(std::format("Level {} has an NPC with a bad texture index", filename));
+		}
+	}
+	for (GFFN_LevelGroundTile const& tile : get_ground_tiles()) {
+		if (tile.cell_x >= WORLD_GRID_WIDTH || tile.cell_y >= WORLD_GRID_HEIGHT || tile.texture >= header->num_textures) {
+			header = nullptr;
+			throw GFFN_Exception(std::format("Level {} has a bad ground tile", filename));
+		}
+	}
+	return true;
+}
+
+std::string_view GFFN_Level::get_texture_path(std::uint16_t texture) const {
+	const GFFN_LevelTexture& level_texture = get_section<GFFN_LevelTexture>(header->textures_offset, header->num_textures)[texture];
+	return std::string_view(level_texture.path, strnlen(level_texture.path, LEVEL_TEXTURE_PATH_SIZE));
+}
+
+std::uint16_t GFFN_LevelWriter::add_texture(std::string const& path) {
+	if (path.size() >= LEVEL_TEXTURE_PATH_SIZE) {
+		throw GFFN_Exception(std::format("Texture path {} is longer than {} characters", path, LEVEL_TEXTURE_PATH_SIZE - 1));
+	}
+	for (std::size_t i = 0; i < textures.size(); i++) {
+		if (path == textures[i].path) {
+			return (std::uint16_t)i;
+		}
+	}
+	if (textures.size() >= LEVEL_NO_TEXTURE) {
+		throw GFFN_Exception(std::string("Too many textures in one level"));
+	}
+	GFFN_LevelTexture texture{};
+	std::memcpy(texture.path, path.c_str(), path.size());
+	textures.push_back(texture);
+	return (std::uint16_t)(textures.size() - 1);
+}
+
+namespace {
+float clamp_to_world(double coordinate, int num_cells) {
+	return (float)std::clamp(coordinate, 0.0, num_cells * 100.0 - 1.0);
+}
+}
+
+void GFFN_LevelWriter::add_static_object(WorldCoordinate floor_coords, std::uint16_t texture, std::uint16_t shadow_texture) {
+	GFFN_LevelStaticObject object{};
+	object.x = clamp_to_world(floor_coords.x, WORLD_GRID_WIDTH);
+	object.y = clamp_to_world(floor_coords.y, WORLD_GRID_HEIGHT);
+	object.texture = texture;
+	object.shadow_texture = shadow_texture;
+	static_objects.push_back(object);
+}
+
+void GFFN_LevelWriter::add_npc(WorldCoordinate floor_coords, std::uint16_t animation_texture, std::uint16_t shadow_texture,
+	std::uint8_t character_type, std::uint8_t animation_fps, std::uint16_t animation_width, std::uint16_t animation_height) {
+	GFFN_LevelNPC npc{};
+	npc.x = clamp_to_world(floor_coords.x, WORLD_GRID_WIDTH);
+	npc.y = clamp_to_world(floor_coords.y, WORLD_GRID_HEIGHT);
+	npc.animation_texture = animation_texture;
+	npc.shadow_texture = shadow_texture;
+	npc.character_type = character_type;
+	npc.animation_fps = animation_fps;
+	npc.animation_width = animation_width;
+	npc.animation_height = animation_height;
+	npcs.push_back(npc);
+}
+
+void GFFN_LevelWriter::add_ground_tile(int cell_x, int cell_y, std::uint16_t texture) {
+	if (cell_x < 0 || cell_y < 0 || cell_x >= WORLD_GRID_WIDTH || cell_y >= WORLD_GRID_HEIGHT) {
+		throw GFFN_Exception(std::format("Ground tile {}, {} is outside the world", cell_x, cell_y));
+	}
+	ground_tiles.push_back(GFFN_LevelGroundTile{ (std::uint16_t)cell_x, (std::uint16_t)cell_y, texture, 0 });
+}
+
+bool GFFN_LevelWriter::write(std::string const& filename) {
+	// Stable, so objects in the same cell keep the order they were added in.
+	auto by_cell = [](auto const& a, auto const& b) { return get_level_cell_index(a.x, a.y) < get_level_cell_index(b.x, b.y); };
+	std::stable_sort(static_objects.begin(), static_objects.end(), by_cell);
+	std::stable_sort(npcs.begin(), npcs.end(), by_cell);
+
+	std::vector<GFFN_LevelCell> cells((std::size_t)WORLD_GRID_WIDTH * WORLD_GRID_HEIGHT, GFFN_LevelCell{});
+	for (std::size_t i = static_objects.size(); i-- > 0;) {
+		GFFN_LevelCell& cell = cells[get_level_cell_index(static_objects[i].x, static_objects[i].y)];
+		cell.first_static_object = (std::uint32_t)i;
+		cell.num_static_objects++;
+	}
+	for (std::size_t i = npcs.size(); i-- > 0;) {
+		GFFN_LevelCell& cell = cells[get_level_cell_index(npcs[i].x, npcs[i].y)];
+		cell.first_npc = (std::uint32_t)i;
+		cell.num_npcs++;
+	}
+
+	GFFN_LevelHeader header{};
+	std::memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+	header.version = LEVEL_VERSION;
+	header.grid_width = WORLD_GRID_WIDTH;
+	header.grid_height = WORLD_GRID_HEIGHT;
+	header.num_textures = (std::uint32_t)textures.size();
+	header.num_static_objects = (std::uint32_t)static_objects.size();
+	header.num_npcs = (std::uint32_t)npcs.size();
+	header.num_ground_tiles = (std::uint32_t)ground_tiles.size();
+	header.textures_offset = align_section(sizeof(GFFN_LevelHeader));
+	header.cells_offset = align_section(header.textures_offset + textures.size() * sizeof(GFFN_LevelTexture));
+	header.static_objects_offset = align_section(header.cells_offset + cells.size() * sizeof(GFFN_LevelCell));
+	header.npcs_offset = align_section(header.static_objects_offset + static_objects.size() * sizeof(GFFN_LevelStaticObject));
+	header.ground_tiles_offset = align_section(header.npcs_offset + npcs.size() * sizeof(GFFN_LevelNPC));
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+	std::uint64_t written = 0;
+	auto write_section = [&](std::uint64_t offset, const void* section, std::size_t num_bytes) {
+		static constexpr char padding[8] = {};
+		file.write(padding, (std::streamsize)(offset - written));
+		file.write((const char*)section, (std::streamsize)num_bytes);
+		written = offset + num_bytes;
+	};
+	write_section(0, &header, sizeof(header));
+	write_section(header.textures_offset, textures.data(), textures.size() * sizeof(GFFN_LevelTexture));
+	write_section(header.cells_offset, cells.data(), cells.size() * sizeof(GFFN_LevelCell));
+	write_section(header.static_objects_offset, static_objects.data(), static_objects.size() * sizeof(GFFN_LevelStaticObject));
+	write_section(header.npcs_offset, npcs.data(), npcs.size() * sizeof(GFFN_LevelNPC));
+	write_section(header.ground_tiles_offset, ground_tiles.data(), ground_tiles.size() * sizeof(GFFN_LevelGroundTile));
+	return file.good();
+}
+
+} // end namespace gffn
@@ -0,0 +1,95 @@
+#include <gffn_memory.h>
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <format>
+#include <fstream>
+
+namespace gffn { namespace memory {
+
+std::array<TagStats, GFFN_MEMORY_TAG_END> tag_stats{};
+
+const char* get_tag_name(GFFN_MemoryTag tag) {
+	switch (tag) {
+	case GFFN_MEMORY_TAG_OBJECTS: return "objects";
+	case GFFN_MEMORY_TAG_OBJECT_STORAGE: return "object_storage";
+	case GFFN_MEMORY_TAG_WORLD_GRID: return "world_grid";
+	case GFFN_MEMORY_TAG_EVENTS: return "events";
+	case GFFN_MEMORY_TAG_FRAME_ARENA: return "frame_arena";
+	case GFFN_MEMORY_TAG_TEXTURES: return "textures";
+	case GFFN_MEMORY_TAG_PARTICLES: return "particles";
+	default: return "unknown";
+	}
+}
+
+std::size_t get_texture_bytes(SDL_Texture* texture) {
+	Uint32 format;
+	int w, h;
+	if (texture == nullptr || SDL_QueryTexture(texture, &format, nullptr, &w, &h) < 0) {
+		return 0;
+	}
+	return (std::size_t)w * (std::size_t)h * SDL_BYTESPERPIXEL(format);
+}
+
+void track_texture(SDL_Texture* texture) {
+	if (texture != nullptr) {
+		track_alloc(GFFN_MEMORY_TAG_TEXTURES, get_texture_bytes(texture));
+	}
+}
+
+void untrack_texture(SDL_Texture* texture) {
+	if (texture != nullptr) {
+		track_free(GFFN_MEMORY_TAG_TEXTURES, get_texture_bytes(texture));
+	}
+}
+
+std::size_t get_total_live_bytes() {
+	std::size_t total = 0;
+	for (TagStats const& stats : tag_stats) {
+		total += stats.get_live_bytes();
+	}
+	return total;
+}
+
+std::size_t get_total_reserved_bytes() {
+	std::size_t total = 0;
+	for (TagStats const& stats : tag_stats) {
+		total += stats.reserved_bytes;
+	}
+	return total;
+}
+
+void end_frame() {
+	for (TagStats& stats : tag_stats) {
+		stats.last_frame_allocations = stats.frame_allocations;
+		stats.last_frame_frees = stats.frame_frees;
+		stats.frame_allocations = 0;
+		stats.frame_frees = 0;
+	}
+}
+
+std::string to_json() {
+	std::string json = std::format("{{\n  \"total_live_bytes\": {},\n  \"total_reserved_bytes\": {},\n  \"tags\": {{",
+		get_total_live_bytes(), get_total_reserved_bytes());
+	for (int i = 0; i < GFFN_MEMORY_TAG_END; i++) {
+		TagStats const& stats = tag_stats[i];
+		json += std::format("{}\n    \"{}\": {{ \"live_bytes\": {}, \"peak_bytes\": {}, \"reserved_bytes\": {}, "
+			"\"allocations\": {}, \"frees\": {}, \"last_frame_allocations\": {}, \"last_frame_frees\": {} }}",
+			i == 0 ? "" : ",", get_tag_name((GFFN_MemoryTag)i), stats.get_live_bytes(), stats.peak_bytes, stats.reserved_bytes,
+			stats.num_allocations, stats.num_frees, stats.last_frame_allocations, stats.last_frame_frees);
+	}
+	json += "\n  }\n}\n";
+	return json;
+}
+
+bool dump_json(std::string const& filename) {
+	std::ofstream file(filename);
+	if (!file) {
+		return false;
+	}
+	file << to_json();
+	return file.good();
+}
+
+}} // end namespace gffn::memory
@@ -0,0 +1,211 @@
+#include <gffn_overlay.h>
+#include <gffn_memory.h>
+#include <gffn_render_stats.h>
+
+namespace gffn {
+
+namespace {
+constexpr int FIRST_GLYPH = ' ';
+constexpr int NUM_GLYPHS = 64; // ' ' to '_', lower case is drawn as upper case
+constexpr int SOLID_CELL = NUM_GLYPHS; // a fully lit cell right after the glyphs, for bars and backgrounds
+constexpr int ATLAS_WIDTH = GFFN_DebugOverlay::ATLAS_COLUMNS * GFFN_DebugOverlay::ATLAS_CELL_SIZE;
+constexpr int ATLAS_HEIGHT = (NUM_GLYPHS / GFFN_DebugOverlay::ATLAS_COLUMNS + 1) * GFFN_DebugOverlay::ATLAS_CELL_SIZE;
+constexpr float GLYPH_ADVANCE = (float)((GFFN_DebugOverlay::GLYPH_WIDTH + 1) * GFFN_DebugOverlay::SCALE);
+constexpr int BAR_LABEL_CHARACTERS = 14;
+constexpr float BAR_WIDTH = 220;
+
+// The usual 5x7 font, one byte per column, top row in bit 0.
+constexpr std::uint8_t FONT[NUM_GLYPHS][GFFN_DebugOverlay::GLYPH_WIDTH] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, //  !"#
+	{ 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, // $%&'
+	{ 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, { 0x14, 0x08, 0x3E, 0x08, 0x14 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // ()*+
+	{ 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 }, // ,-./
+	{ 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // 0123
+	{ 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 4567
+	{ 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 }, // 89:;
+	{ 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, // <=>?
+	{ 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // @ABC
+	{ 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // DEFG
+	{ 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // HIJK
+	{ 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // LMNO
+	{ 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 }, // PQRS
+	{ 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // TUVW
+	{ 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // XYZ[
+	{ 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 }, // \]^_
+};
+
+constexpr SDL_Color BACKGROUND = { 0, 0, 0, 170 };
+constexpr SDL_Color BAR_BACKGROUND = { 60, 60, 60, 200 };
+}
+
+GFFN_DebugOverlay::GFFN_DebugOverlay(SDL_Renderer* renderer) {
+	// White everywhere, the glyph shapes are in the alpha. Vertex colors tint it.
+	std::vector<Uint32> pixels(ATLAS_WIDTH * ATLAS_HEIGHT, 0xFFFFFF00);
+	for (int glyph = 0; glyph <= SOLID_CELL; glyph++) {
+		int cell_x = (glyph % ATLAS_COLUMNS) * ATLAS_CELL_SIZE;
+		int cell_y = (glyph / ATLAS_COLUMNS) * ATLAS_CELL_SIZE;
+		for (int y = 0; y < ATLAS_CELL_SIZE; y++) {
+			for (int x = 0; x < ATLAS_CELL_SIZE; x++) {
+				bool lit = glyph == SOLID_CELL
+					|| (x < GLYPH_WIDTH && y < GLYPH_HEIGHT && ((FONT[glyph][x] >> y) & 1));
+				if (lit) {
+					pixels[(cell_y + y) * ATLAS_WIDTH + cell_x + x] = 0xFFFFFFFF;
+				}
+			}
+		}
+	}
+	atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, ATLAS_WIDTH, ATLAS_HEIGHT);
+	if (atlas == nullptr) {
+		return; // the overlay just won't draw
+	}
+	SDL_UpdateTexture(atlas, nullptr, pixels.data(), ATLAS_WIDTH * sizeof(Uint32));
+	SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureScaleMode(atlas, SDL_ScaleModeNearest);
+	memory::track_texture(atlas);
+}
+
+GFFN_DebugOverlay::~GFFN_DebugOverlay() {
+	if (atlas != nullptr) {
+		memory::untrack_texture(atlas);
+		SDL_DestroyTexture(atlas);
+	}
+}
+
+void GFFN_DebugOverlay::add_quad(float x, float y, float w, float h, float u0, float v0, float u1, float v1, SDL_Color color) {
+	int first_vertex = (int)(positions.size() / 2);
+	positions.insert(positions.end(), { x, y, x + w, y, x + w, y + h, x, y + h });
+	uvs.insert(uvs.end(), { u0, v0, u1, v0, u1, v1, u0, v1 });
+	colors.insert(colors.end(), { color, color, color, color });
+	indices.insert(indices.end(), { first_vertex, first_vertex + 1, first_vertex + 2, first_vertex + 2, first_vertex + 3, first_vertex });
+}
+
+void GFFN_DebugOverlay::add_solid_quad(float x, float y, float w, float h, SDL_Color color) {
+	// The middle of the solid cell, so filtering never picks up a neighbour.
+	constexpr float u = ((SOLID_CELL % ATLAS_COLUMNS) * ATLAS_CELL_SIZE + ATLAS_CELL_SIZE / 2) / (float)ATLAS_WIDTH;
+	constexpr float v = ((SOLID_CELL / ATLAS_COLUMNS) * ATLAS_CELL_SIZE + ATLAS_CELL_SIZE / 2) / (float)ATLAS_HEIGHT;
+	add_quad(x, y, w, h, u, v, u, v, color);
+}
+
+float GFFN_DebugOverlay::add_text(float x, float y, std::string_view text, SDL_Color color) {
+	for (char c : text) {
+		int glyph = (unsigned char)c;
+		if (glyph >= 'a' && glyph <= 'z') {
+			glyph -= 'a' - 'A';
+		}
+		glyph -= FIRST_GLYPH;
+		if (glyph < 0 || glyph >= NUM_GLYPHS) {
+			glyph = '?' - FIRST_GLYPH;
+		}
+		if (glyph != 0) {
+			float u0 = (float)((glyph % ATLAS_COLUMNS) * ATLAS_CELL_SIZE) / ATLAS_WIDTH;
+			float v0 = (float)((glyph / ATLAS_COLUMNS) * ATLAS_CELL_SIZE) / ATLAS_HEIGHT;
+			add_quad(x, y, (float)(GLYPH_WIDTH * SCALE), (float)(GLYPH_HEIGHT * SCALE),
+				u0, v0, u0 + (float)GLYPH_WIDTH / ATLAS_WIDTH, v0 + (float)GLYPH_HEIGHT / ATLAS_HEIGHT, color);
+		}
+		x += GLYPH_ADVANCE;
+	}
+	return x;
+}
+
+void GFFN_DebugOverlay::begin(int x, int y) {
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (has_last_begin) {
+		frame_times_ms[next_frame_time] = std::chrono::duration<float, std::milli>(now - last_begin).count();
+		next_frame_time = (next_frame_time + 1) % FRAME_HISTORY_SIZE;
+		num_frame_times = std::min(num_frame_times + 1, FRAME_HISTORY_SIZE);
+	}
+	last_begin = now;
+	has_last_begin = true;
+
+	positions.clear();
+	colors.clear();
+	uvs.clear();
+	indices.clear();
+	panel_x = x;
+	panel_y = y;
+	cursor_y = y + PADDING;
+	panel_right = x + PADDING;
+	// The background goes first so it's under everything, draw() sizes it once the panel is done.
+	add_solid_quad(0, 0, 0, 0, BACKGROUND);
+}
+
+void GFFN_DebugOverlay::text(std::string_view line, SDL_Color color) {
+	float end_x = add_text((float)(panel_x + PADDING), (float)cursor_y, line, color);
+	panel_right = std::max(panel_right, (int)end_x + PADDING);
+	cursor_y += LINE_HEIGHT;
+}
+
+void GFFN_DebugOverlay::bar(std::string_view label, double value, double max_value, std::string_view unit, SDL_Color color) {
+	float x = (float)(panel_x + PADDING);
+	float y = (float)cursor_y;
+	add_text(x, y, label.substr(0, BAR_LABEL_CHARACTERS), GREY);
+	x += BAR_LABEL_CHARACTERS * GLYPH_ADVANCE;
+
+	float fill = max_value > 0 ? (float)std::clamp(value / max_value, 0.0, 1.0) : 0.0f;
+	float bar_height = (float)(GLYPH_HEIGHT * SCALE);
+	add_solid_quad(x, y, BAR_WIDTH, bar_height, BAR_BACKGROUND);
+	if (fill > 0) {
+		add_solid_quad(x, y, BAR_WIDTH * fill, bar_height, color);
+	}
+	x += BAR_WIDTH + GLYPH_ADVANCE;
+
+	char buffer[32];
+	auto result = std::format_to_n(buffer, sizeof(buffer), "{:.2f} {}", value, unit);
+	float end_x = add_text(x, y, std::string_view(buffer, std::min<std::size_t>((std::size_t)result.size, sizeof(buffer))), WHITE);
+	panel_right = std::max(panel_right, (int)end_x + PADDING);
+	cursor_y += LINE_HEIGHT;
+}
+
+void GFFN_DebugOverlay::frame_time_graph(double budget_ms, int height) {
+	constexpr float COLUMN_WIDTH = 2;
+	float x = (float)(panel_x + PADDING);
+	float y = (float)cursor_y;
+	float width = FRAME_HISTORY_SIZE * COLUMN_WIDTH;
+	// Three budgets tall, anything slower is clipped but still red.
+	float ms_per_pixel = (float)(budget_ms * 3) / height;
+	add_solid_quad(x, y, width, (float)height, BAR_BACKGROUND);
+
+	std::size_t oldest = num_frame_times < FRAME_HISTORY_SIZE ? 0 : next_frame_time;
+	for (std::size_t i = 0; i < num_frame_times; i++) {
+		float frame_ms = frame_times_ms[(oldest + i) % FRAME_HISTORY_SIZE];
+		float column_height = std::min(frame_ms / ms_per_pixel, (float)height);
+		SDL_Color color = frame_ms <= budget_ms ? GREEN : (frame_ms <= budget_ms * 2 ? YELLOW : RED);
+		add_solid_quad(x + i * COLUMN_WIDTH, y + height - column_height, COLUMN_WIDTH, column_height, color);
+	}
+	for (int budgets = 1; budgets <= 2; budgets++) {
+		float line_y = y + height - (float)(budget_ms * budgets) / ms_per_pixel;
+		add_solid_quad(x, line_y, width, 1, WHITE);
+	}
+	panel_right = std::max(panel_right, (int)(x + width) + PADDING);
+	cursor_y += height + LINE_HEIGHT / 2;
+}
+
+void GFFN_DebugOverlay::draw(SDL_Renderer* renderer) {
+	if (atlas == nullptr || indices.empty()) {
+		return;
+	}
+	float panel_w = (float)(panel_right - panel_x);
+	float panel_h = (float)(cursor_y + PADDING - panel_y);
+	float* background = positions.data();
+	background[0] = (float)panel_x;           background[1] = (float)panel_y;
+	background[2] = (float)panel_x + panel_w; background[3] = (float)panel_y;
+	background[4] = (float)panel_x + panel_w; background[5] = (float)panel_y + panel_h;
+	background[6] = (float)panel_x;           background[7] = (float)panel_y + panel_h;
+
+	int num_vertices = (int)(positions.size() / 2);
+	SDL_RenderGeometryRaw(renderer, atlas,
+		positions.data(), 2 * sizeof(float),
+		colors.data(), sizeof(SDL_Color),
+		uvs.data(), 2 * sizeof(float),
+		num_vertices, indices.data(), (int)indices.size(), sizeof(int));
+	render_stats::count_draw(atlas, (std::uint32_t)(num_vertices / 4));
+}
+
+double GFFN_DebugOverlay::get_last_frame_ms() const {
+	if (num_frame_times == 0) {
+		return 0;
+	}
+	return frame_times_ms[(next_frame_time + FRAME_HISTORY_SIZE - 1) % FRAME_HISTORY_SIZE];
+}
+
+} // end namespace gffn
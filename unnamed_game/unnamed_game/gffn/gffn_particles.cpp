@@ -0,0 +1,341 @@
+#include <gffn_particles.h>
+#include <gffn_profiler.h>
+#include <gffn_render_stats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFFN_PARTICLES_SSE
+#include <emmintrin.h>
+#endif
+
+namespace gffn { namespace particles {
+
+namespace {
+constexpr std::size_t MIN_PARTICLES_ALLOCATED = 1024;
+constexpr float DEGREES_TO_RADIANS = (float)M_PI / 180.0f;
+
+// Scalar version of one step of ParticleBuffer::update, for the tail and for compilers without SSE.
+inline void update_particle(ParticleBuffer& buffer, std::size_t i, float delta_time_seconds) {
+	buffer.age[i] += delta_time_seconds;
+	buffer.x[i] += buffer.velocity_x[i] * delta_time_seconds;
+	buffer.y[i] += buffer.velocity_y[i] * delta_time_seconds;
+	buffer.velocity_height[i] -= buffer.gravity[i] * delta_time_seconds;
+	buffer.height[i] = std::max(buffer.height[i] + buffer.velocity_height[i] * delta_time_seconds, 0.0f);
+	float t = std::min(buffer.age[i] * buffer.inverse_lifetime[i], 1.0f);
+	buffer.size[i] = buffer.base_size[i] * (1.0f - t * buffer.shrink[i]);
+	buffer.alpha[i] = 1.0f - t * buffer.fade[i];
+}
+
+inline void move_particle(ParticleBuffer& buffer, std::size_t from, std::size_t to) {
+	buffer.x[to] = buffer.x[from];
+	buffer.y[to] = buffer.y[from];
+	buffer.height[to] = buffer.height[from];
+	buffer.velocity_x[to] = buffer.velocity_x[from];
+	buffer.velocity_y[to] = buffer.velocity_y[from];
+	buffer.velocity_height[to] = buffer.velocity_height[from];
+	buffer.gravity[to] = buffer.gravity[from];
+	buffer.age[to] = buffer.age[from];
+	buffer.inverse_lifetime[to] = buffer.inverse_lifetime[from];
+	buffer.base_size[to] = buffer.base_size[from];
+	buffer.size[to] = buffer.size[from];
+	buffer.shrink[to] = buffer.shrink[from];
+	buffer.fade[to] = buffer.fade[from];
+	buffer.alpha[to] = buffer.alpha[from];
+	buffer.color[to] = buffer.color[from];
+}
+
+inline Uint8 clamp_channel(int value) {
+	return (Uint8)std::clamp(value, 0, 255);
+}
+} // end anonymous namespace
+
+std::size_t ParticleBuffer::make_room(std::size_t n) {
+	std::size_t wanted = std::min(count + n, max_particles);
+	if (wanted > allocated) {
+		std::size_t new_allocated = std::max(allocated * 2, MIN_PARTICLES_ALLOCATED);
+		new_allocated = std::min(std::max(new_allocated, wanted), max_particles);
+		for (std::vector<float>* field : { &x, &y, &height, &velocity_x, &velocity_y, &velocity_height, &gravity,
+			&age, &inverse_lifetime, &base_size, &size, &shrink, &fade, &alpha }) {
+			field->resize(new_allocated);
+		}
+		color.resize(new_allocated);
+		allocated = new_allocated;
+	}
+	return wanted - count;
+}
+
+void ParticleBuffer::update(float delta_time_seconds) {
+	std::size_t i = 0;
+#ifdef GFFN_PARTICLES_SSE
+	const __m128 dt = _mm_set1_ps(delta_time_seconds);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 particle_age = _mm_add_ps(_mm_loadu_ps(&age[i]), dt);
+		_mm_storeu_ps(&age[i], particle_age);
+
+		_mm_storeu_ps(&x[i], _mm_add_ps(_mm_loadu_ps(&x[i]), _mm_mul_ps(_mm_loadu_ps(&velocity_x[i]), dt)));
+		_mm_storeu_ps(&y[i], _mm_add_ps(_mm_loadu_ps(&y[i]), _mm_mul_ps(_mm_loadu_ps(&velocity_y[i]), dt)));
+
+		__m128 vh = _mm_sub_ps(_mm_loadu_ps(&velocity_height[i]), _mm_mul_ps(_mm_loadu_ps(&gravity[i]), dt));
+		_mm_storeu_ps(&velocity_height[i], vh);
+		__m128 h = _mm_add_ps(_mm_loadu_ps(&height[i]), _mm_mul_ps(vh, dt));
+		_mm_storeu_ps(&height[i], _mm_max_ps(h, zero));
+
+		__m128 t = _mm_min_ps(_mm_mul_ps(particle_age, _mm_loadu_ps(&inverse_lifetime[i])), one);
+		__m128 size_scale = _mm_sub_ps(one, _mm_mul_ps(t, _mm_loadu_ps(&shrink[i])));
+		_mm_storeu_ps(&size[i], _mm_mul_ps(_mm_loadu_ps(&base_size[i]), size_scale));
+		_mm_storeu_ps(&alpha[i], _mm_sub_ps(one, _mm_mul_ps(t, _mm_loadu_ps(&fade[i]))));
+	}
+#endif
+	for (; i < count; i++) {
+		update_particle(*this, i, delta_time_seconds);
+	}
+}
+
+void ParticleBuffer::remove_dead() {
+	for (std::size_t i = 0; i < count;) {
+		if (age[i] * inverse_lifetime[i] >= 1.0f) {
+			count--;
+			move_particle(*this, count, i);
+			continue;
+		}
+		i++;
+	}
+}
+
+std::size_t ParticleBuffer::get_bytes() const {
+	return allocated * (14 * sizeof(float) + sizeof(std::uint32_t));
+}
+
+void ParticleBatch::update_memory_tracking() {
+	std::size_t bytes = buffer.get_bytes() + vertex_positions.capacity() * sizeof(float) + vertex_colors.capacity() * sizeof(SDL_Color)
+		+ vertex_uvs.capacity() * sizeof(float) + indices.capacity() * sizeof(int);
+	if (bytes != tracked_bytes) {
+		memory::track_free(GFFN_MEMORY_TAG_PARTICLES, tracked_bytes);
+		memory::track_alloc(GFFN_MEMORY_TAG_PARTICLES, bytes);
+		tracked_bytes = bytes;
+	}
+}
+
+void ParticleBatch::render(SDL_Renderer* renderer, SDL_Rect const& viewport) {
+	if (buffer.count == 0) {
+		return;
+	}
+	// The static parts only grow with the buffer, after that this is free.
+	if (indices.size() < buffer.allocated * 6) {
+		std::size_t old_quads = indices.size() / 6;
+		indices.resize(buffer.allocated * 6);
+		vertex_uvs.resize(buffer.allocated * 8);
+		for (std::size_t quad = old_quads; quad < buffer.allocated; quad++) {
+			int first_vertex = (int)quad * 4;
+			int* quad_indices = &indices[quad * 6];
+			quad_indices[0] = first_vertex;
+			quad_indices[1] = first_vertex + 1;
+			quad_indices[2] = first_vertex + 2;
+			quad_indices[3] = first_vertex + 2;
+			quad_indices[4] = first_vertex + 3;
+			quad_indices[5] = first_vertex;
+			float* uvs = &vertex_uvs[quad * 8];
+			uvs[0] = 0; uvs[1] = 0;
+			uvs[2] = 1; uvs[3] = 0;
+			uvs[4] = 1; uvs[5] = 1;
+			uvs[6] = 0; uvs[7] = 1;
+		}
+		vertex_positions.resize(buffer.allocated * 8);
+		vertex_colors.resize(buffer.allocated * 4);
+		update_memory_tracking();
+	}
+
+	const float left = (float)viewport.x;
+	const float top = (float)viewport.y;
+	const float right = (float)(viewport.x + viewport.w);
+	const float bottom = (float)(viewport.y + viewport.h);
+	int num_quads = 0;
+	for (std::size_t i = 0; i < buffer.count; i++) {
+		float half_size = buffer.size[i] * 0.5f;
+		float center_x = buffer.x[i];
+		float center_y = buffer.y[i] - buffer.height[i];
+		if (center_x + half_size < left || center_x - half_size > right || center_y + half_size < top || center_y - half_size > bottom) {
+			continue;
+		}
+		center_x -= left;
+		center_y -= top;
+
+		float* positions = &vertex_positions[num_quads * 8];
+		positions[0] = center_x - half_size; positions[1] = center_y - half_size;
+		positions[2] = center_x + half_size; positions[3] = center_y - half_size;
+		positions[4] = center_x + half_size; positions[5] = center_y + half_size;
+		positions[6] = center_x - half_size; positions[7] = center_y + half_size;
+
+		SDL_Color color;
+		std::memcpy(&color, &buffer.color[i], sizeof(color));
+		color.a = (Uint8)(color.a * buffer.alpha[i]);
+		SDL_Color* colors = &vertex_colors[num_quads * 4];
+		colors[0] = color;
+		colors[1] = color;
+		colors[2] = color;
+		colors[3] = color;
+		num_quads++;
+	}
+	if (num_quads == 0) {
+		return;
+	}
+	SDL_RenderGeometryRaw(renderer, texture,
+		vertex_positions.data(), 2 * sizeof(float),
+		vertex_colors.data(), sizeof(SDL_Color),
+		vertex_uvs.data(), 2 * sizeof(float),
+		num_quads * 4, indices.data(), num_quads * 6, sizeof(int));
+	render_stats::count_draw(texture, (std::uint32_t)num_quads);
+}
+
+ParticleBatch& ParticleSystem::get_batch(SDL_Texture* texture) {
+	// Only a handful of textures, a linear search beats hashing here.
+	for (std::unique_ptr<ParticleBatch>& batch : batches) {
+		if (batch->get_texture() == texture) {
+			return *batch;
+		}
+	}
+	batches.push_back(std::make_unique<ParticleBatch>(texture, max_particles_per_texture));
+	return *batches.back();
+}
+
+int ParticleSystem::vary(int value, int variance) {
+	if (variance == 0) {
+		return value;
+	}
+	return value + rng.range_int(-variance, variance);
+}
+
+void ParticleSystem::spawn(ParticleEmitter const& emitter, int num_particles) {
+	if (num_particles <= 0) {
+		return;
+	}
+	ParticleBatch& batch = get_batch(emitter.texture);
+	ParticleBuffer& buffer = batch.get_buffer();
+	std::size_t allocated_before = buffer.allocated;
+	std::size_t num_to_spawn = buffer.make_room((std::size_t)num_particles);
+	if (buffer.allocated != allocated_before) {
+		batch.update_memory_tracking();
+	}
+
+	particle_info const& info = emitter.info;
+	std::uint32_t base_color = (std::uint32_t)info.particle_color;
+	for (std::size_t n = 0; n < num_to_spawn; n++) {
+		std::size_t i = buffer.count++;
+		float direction = (float)vary(info.particle_direction, info.particle_direction_variance) * DEGREES_TO_RADIANS;
+		float speed = (float)std::max(vary(info.particle_speed, info.particle_speed_variance), 0);
+		float lifetime_ms = (float)std::max(vary(info.particle_lifetime, info.particle_lifetime_variance), 1);
+
+		buffer.x[i] = emitter.coords.x;
+		buffer.y[i] = emitter.coords.y;
+		buffer.height[i] = 0;
+		buffer.velocity_x[i] = std::cos(direction) * speed;
+		buffer.velocity_y[i] = std::sin(direction) * speed;
+		buffer.velocity_height[i] = (float)info.particle_upward_speed;
+		buffer.gravity[i] = (float)info.particle_gravity;
+		buffer.age[i] = 0;
+		buffer.inverse_lifetime[i] = 1000.0f / lifetime_ms;
+		buffer.base_size[i] = (float)std::max(vary(info.particle_size, info.particle_size_variance), 1);
+		buffer.size[i] = buffer.base_size[i];
+		buffer.shrink[i] = emitter.shrink ? 1.0f : 0.0f;
+		buffer.fade[i] = emitter.fade ? 1.0f : 0.0f;
+		buffer.alpha[i] = 1.0f;
+
+		SDL_Color color;
+		color.r = clamp_channel(vary((int)((base_color >> 24) & 0xFF), info.particle_color_variance));
+		color.g = clamp_channel(vary((int)((base_color >> 16) & 0xFF), info.particle_color_variance));
+		color.b = clamp_channel(vary((int)((base_color >> 8) & 0xFF), info.particle_color_variance));
+		color.a = (Uint8)(base_color & 0xFF);
+		std::memcpy(&buffer.color[i], &color, sizeof(color));
+	}
+}
+
+emitter_id_t ParticleSystem::add_emitter(particle_info const& info, WorldCoordinate coords, SDL_Texture* texture, bool fade, bool shrink) {
+	ParticleEmitter emitter{ info, WorldCoordinatef(coords), texture, fade, shrink, true, 0.0f, 0.0f };
+	spawn(emitter, info.num_particles);
+	if (info.emitter_lifetime <= 0) {
+		return NO_EMITTER;
+	}
+	if (!free_emitter_ids.empty()) {
+		emitter_id_t emitter_id = free_emitter_ids.back();
+		free_emitter_ids.pop_back();
+		emitters[emitter_id] = emitter;
+		return emitter_id;
+	}
+	emitters.push_back(emitter);
+	return (emitter_id_t)emitters.size() - 1;
+}
+
+void ParticleSystem::burst(particle_info const& info, WorldCoordinate coords, SDL_Texture* texture, bool fade, bool shrink) {
+	ParticleEmitter emitter{ info, WorldCoordinatef(coords), texture, fade, shrink, false, 0.0f, 0.0f };
+	spawn(emitter, info.num_particles);
+}
+
+void ParticleSystem::move_emitter(emitter_id_t emitter_id, WorldCoordinate coords) {
+	if (emitter_id < 0 || emitter_id >= (emitter_id_t)emitters.size() || !emitters[emitter_id].active) {
+		return;
+	}
+	emitters[emitter_id].coords = WorldCoordinatef(coords);
+}
+
+void ParticleSystem::stop_emitter(emitter_id_t emitter_id) {
+	if (emitter_id < 0 || emitter_id >= (emitter_id_t)emitters.size() || !emitters[emitter_id].active) {
+		return;
+	}
+	emitters[emitter_id].active = false;
+	free_emitter_ids.push_back(emitter_id);
+}
+
+void ParticleSystem::tick(double delta_time_seconds) {
+	GFFN_PROFILE_SCOPE("particles.tick");
+	float dt = (float)delta_time_seconds;
+	for (std::size_t emitter_id = 0; emitter_id < emitters.size(); emitter_id++) {
+		ParticleEmitter& emitter = emitters[emitter_id];
+		if (!emitter.active) {
+			continue;
+		}
+		particle_info const& info = emitter.info;
+		int num_particles = 0;
+		if (info.num_particles_per_tick > 0) {
+			num_particles += vary(info.num_particles_per_tick, info.num_particles_per_tick_variance);
+		}
+		if (info.num_particles_per_second > 0) {
+			emitter.particles_owed += (float)vary(info.num_particles_per_second, info.num_particles_per_second_variance) * dt;
+			int whole_particles = (int)emitter.particles_owed;
+			emitter.particles_owed -= (float)whole_particles;
+			num_particles += whole_particles;
+		}
+		spawn(emitter, num_particles);
+
+		emitter.age_ms += dt * 1000.0f;
+		if (emitter.age_ms >= (float)info.emitter_lifetime) {
+			stop_emitter((emitter_id_t)emitter_id);
+		}
+	}
+
+	for (std::unique_ptr<ParticleBatch>& batch : batches) {
+		ParticleBuffer& buffer = batch->get_buffer();
+		buffer.update(dt);
+		buffer.remove_dead();
+	}
+}
+
+void ParticleSystem::render(SDL_Renderer* renderer, SDL_Rect const& viewport) {
+	for (std::unique_ptr<ParticleBatch>& batch : batches) {
+		batch->render(renderer, viewport);
+	}
+}
+
+std::size_t ParticleSystem::get_num_live_particles() const {
+	std::size_t total = 0;
+	for (std::unique_ptr<ParticleBatch> const& batch : batches) {
+		total += batch->get_num_particles();
+	}
+	return total;
+}
+
+}} // end namespace gffn::particles
@@ -0,0 +1,165 @@
+#include <gffn_pool.h>
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace gffn {
+
+bool GFFN_FixedPool::default_use_huge_pages = false;
+
+namespace {
+
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Tries to get the chunk on huge pages, falls back to normal pages if the OS says no (no privilege, no reserved pages).
+void* allocate_huge_page_chunk(std::size_t& size, bool& got_huge_pages) {
+	size = ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+#if defined(_WIN32)
+	SIZE_T large_page_minimum = GetLargePageMinimum();
+	if (large_page_minimum != 0) {
+		SIZE_T large_size = ((size + large_page_minimum - 1) / large_page_minimum) * large_page_minimum;
+		void* memory = VirtualAlloc(nullptr, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory != nullptr) {
+			size = large_size;
+			got_huge_pages = true;
+			return memory;
+		}
+	}
+	got_huge_pages = false;
+	return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux__)
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (memory != MAP_FAILED) {
+		got_huge_pages = true;
+		return memory;
+	}
+	got_huge_pages = false;
+	memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return nullptr;
+	}
+	madvise(memory, size, MADV_HUGEPAGE); // transparent huge pages if they're enabled
+	return memory;
+#else
+	got_huge_pages = false;
+	return nullptr;
+#endif
+}
+
+void free_huge_page_chunk(void* memory, std::size_t size) {
+#if defined(_WIN32)
+	VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+	munmap(memory, size);
+#endif
+}
+
+} // end anonymous namespace
+
+GFFN_FixedPool::GFFN_FixedPool(std::size_t block_size, std::size_t block_align, GFFN_MemoryTag tag, std::size_t blocks_per_chunk, bool use_huge_pages) :
+block_align(std::max(block_align, alignof(FreeBlock))), tag(tag), blocks_per_chunk(blocks_per_chunk), use_huge_pages(use_huge_pages) {
+	if (blocks_per_chunk == 0) {
+		throw GFFN_Exception(std::string("GFFN_FixedPool needs at least one block per chunk"));
+	}
+	// Every block has to be able to hold the free list link and keep the next block aligned.
+	this->block_size = std::max(block_size, sizeof(FreeBlock));
+	this->block_size = ((this->block_size + this->block_align - 1) / this->block_align) * this->block_align;
+}
+
+GFFN_FixedPool::~GFFN_FixedPool() {
+	for (Chunk const& chunk : chunks) {
+		memory::add_reserved_bytes(tag, -(std::ptrdiff_t)chunk.size);
+		if (chunk.mapped) {
+			free_huge_page_chunk(chunk.memory, chunk.size);
+		}
+		else {
+			::operator delete(chunk.memory, std::align_val_t(block_align));
+		}
+	}
+}
+
+void GFFN_FixedPool::grow() {
+	release_tail();
+	tail = add_chunk(blocks_per_chunk, use_huge_pages, num_tail_blocks);
+}
+
+void GFFN_FixedPool::release_tail() {
+	for (std::size_t i = num_tail_blocks; i > 0; i--) {
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(tail + ((i - 1) * block_size));
+		block->next = free_list;
+		free_list = block;
+	}
+	tail = nullptr;
+	num_tail_blocks = 0;
+}
+
+bool GFFN_FixedPool::wants_huge_pages(std::size_t num_chunk_blocks) const {
+	return use_huge_pages || block_size * num_chunk_blocks >= HUGE_PAGE_SIZE;
+}
+
+void GFFN_FixedPool::reserve(std::size_t num_blocks) {
+	if (this->num_blocks >= num_blocks) {
+		return;
+	}
+	std::size_t num_chunk_blocks = std::max(num_blocks - this->num_blocks, blocks_per_chunk);
+	release_tail();
+	tail = add_chunk(num_chunk_blocks, wants_huge_pages(num_chunk_blocks), num_tail_blocks);
+}
+
+char* GFFN_FixedPool::allocate_contiguous(std::size_t num_blocks) {
+	char* blocks;
+	if (num_blocks <= num_tail_blocks) {
+		blocks = take_from_tail(num_blocks);
+	}
+	else if (num_blocks <= blocks_per_chunk) {
+		grow();
+		blocks = take_from_tail(num_blocks);
+	}
+	else {
+		// The tail stays where it is. A huge page chunk can fit a few more blocks than asked for, those go on the free list.
+		std::size_t num_new_blocks;
+		blocks = add_chunk(num_blocks, wants_huge_pages(num_blocks), num_new_blocks);
+		for (std::size_t i = num_new_blocks; i > num_blocks; i--) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(blocks + ((i - 1) * block_size));
+			block->next = free_list;
+			free_list = block;
+		}
+	}
+	num_live += num_blocks;
+	memory::track_alloc(tag, block_size * num_blocks);
+	return blocks;
+}
+
+char* GFFN_FixedPool::add_chunk(std::size_t num_chunk_blocks, bool huge_pages, std::size_t& num_new_blocks) {
+	std::size_t chunk_size = block_size * num_chunk_blocks;
+	void* memory = nullptr;
+	bool got_huge_pages = false;
+	if (huge_pages) {
+		memory = allocate_huge_page_chunk(chunk_size, got_huge_pages);
+	}
+	if (memory == nullptr) {
+		// Either huge pages are off or the platform can't map them at all.
+		chunk_size = block_size * num_chunk_blocks;
+		memory = ::operator new(chunk_size, std::align_val_t(block_align));
+		chunks.push_back(Chunk{ memory, chunk_size, false, false });
+	}
+	else {
+		chunks.push_back(Chunk{ memory, chunk_size, true, got_huge_pages });
+	}
+
+	memory::add_reserved_bytes(tag, (std::ptrdiff_t)chunk_size);
+
+	// A huge page chunk is rounded up, so it can fit more blocks than asked for.
+	num_new_blocks = chunk_size / block_size;
+	num_blocks += num_new_blocks;
+	return static_cast<char*>(memory);
+}
+
+} // end namespace gffn
@@ -0,0 +1,159 @@
+#include <gffn_profiler.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace gffn { namespace profiler {
+
+namespace {
+// Rings are never freed, so a thread that has exited still shows up in a dump.
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<GFFN_ProfilerRing>> rings;
+
+// Frame ends, only touched by the sim thread.
+std::array<std::uint64_t, FRAME_HISTORY_SIZE> frame_end_ns{};
+std::uint64_t num_frames = 0;
+
+std::string trace_filename = "gffn_trace.json";
+std::size_t dump_frames = DEFAULT_DUMP_FRAMES;
+std::uint64_t spike_threshold_ns = 0; // 0 is off
+std::uint64_t last_spike_dump_frame = 0;
+
+// Zone names are literals from our own code, but a quote or backslash in one would still break the whole file.
+void append_json_string(std::string& out, const char* text) {
+	out += '"';
+	for (const char* c = text; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			out += '\\';
+		}
+		out += *c;
+	}
+	out += '"';
+}
+}
+
+void GFFN_ProfilerRing::copy_since(std::uint64_t since_ns, std::vector<Zone>& out) const {
+	std::uint64_t end = head.load(std::memory_order_acquire);
+	std::uint64_t begin = end > THREAD_RING_SIZE ? end - THREAD_RING_SIZE : 0;
+	std::size_t first_copied = out.size();
+	for (std::uint64_t i = begin; i < end; i++) {
+		out.push_back(zones[i & (THREAD_RING_SIZE - 1)]);
+	}
+	// The owner might have wrapped around over the oldest ones while we were copying, those are garbage. That includes
+	// slot end_after, which the owner can be writing into right now before it bumps head.
+	std::uint64_t end_after = head.load(std::memory_order_acquire);
+	std::uint64_t first_valid = end_after >= THREAD_RING_SIZE ? end_after - THREAD_RING_SIZE + 1 : 0;
+	if (first_valid > begin) {
+		std::size_t num_overwritten = (std::size_t)std::min(first_valid - begin, end - begin);
+		out.erase(out.begin() + first_copied, out.begin() + first_copied + num_overwritten);
+	}
+	out.erase(std::remove_if(out.begin() + first_copied, out.end(), [since_ns](Zone const& zone) { return zone.end_ns <= since_ns; }),
+		out.end());
+}
+
+GFFN_ProfilerRing& register_thread() {
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	rings.push_back(std::make_unique<GFFN_ProfilerRing>());
+	rings.back()->thread_index = (std::uint32_t)rings.size() - 1;
+	return *rings.back();
+}
+
+void mark_frame() {
+	std::uint64_t now = now_ns();
+	bool has_start = num_frames > 0;
+	std::uint64_t frame_start = has_start ? frame_end_ns[(num_frames - 1) % FRAME_HISTORY_SIZE] : 0;
+	frame_end_ns[num_frames % FRAME_HISTORY_SIZE] = now;
+	num_frames++;
+	if (!has_start) {
+		return;
+	}
+	get_thread_ring().push("frame", frame_start, now);
+
+	if (spike_threshold_ns > 0 && now - frame_start > spike_threshold_ns
+		&& (last_spike_dump_frame == 0 || num_frames - last_spike_dump_frame >= dump_frames)) {
+		last_spike_dump_frame = num_frames;
+		if (dump_chrome_trace(trace_filename, dump_frames)) {
+			printf("Frame %llu took %.2f ms, wrote %s\n", (unsigned long long)num_frames, (now - frame_start) / 1e6, trace_filename.c_str());
+		}
+	}
+}
+
+std::uint64_t get_num_frames() {
+	return num_frames;
+}
+
+std::string to_chrome_trace(std::size_t num_frames_wanted) {
+	// A dump starts where the oldest frame asked for started, or at the oldest frame we still know about.
+	std::uint64_t frames_back = std::min<std::uint64_t>({ (std::uint64_t)num_frames_wanted, num_frames, FRAME_HISTORY_SIZE - 1 });
+	std::uint64_t since_ns = 0;
+	if (num_frames > frames_back) {
+		since_ns = frame_end_ns[(num_frames - frames_back - 1) % FRAME_HISTORY_SIZE];
+	}
+
+	std::vector<Zone> zones;
+	std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first_event = true;
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	for (std::unique_ptr<GFFN_ProfilerRing> const& ring : rings) {
+		if (ring->thread_name != nullptr) {
+			json += std::format("{}\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":",
+				first_event ? "" : ",", ring->thread_index);
+			append_json_string(json, ring->thread_name);
+			json += "}}";
+			first_event = false;
+		}
+		zones.clear();
+		ring->copy_since(since_ns, zones);
+		for (Zone const& zone : zones) {
+			json += first_event ? "\n{\"name\":" : ",\n{\"name\":";
+			append_json_string(json, zone.name);
+			// Chrome wants microseconds, three decimals keeps the nanoseconds.
+			std::uint64_t start_ns = zone.start_ns > since_ns ? zone.start_ns - since_ns : 0;
+			json += std::format(",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{}.{:03},\"dur\":{}.{:03}}}", ring->thread_index,
+				start_ns / 1000, start_ns % 1000, (zone.end_ns - zone.start_ns) / 1000, (zone.end_ns - zone.start_ns) % 1000);
+			first_event = false;
+		}
+	}
+	json += "\n]}\n";
+	return json;
+}
+
+bool dump_chrome_trace(std::string const& filename, std::size_t num_frames_wanted) {
+	std::ofstream file(filename);
+	if (!file) {
+		return false;
+	}
+	file << to_chrome_trace(num_frames_wanted);
+	return file.good();
+}
+
+void init_from_environment() {
+	if (const char* filename = std::getenv("GFFN_TRACE_FILE")) {
+		trace_filename = filename;
+	}
+	if (const char* frames = std::getenv("GFFN_TRACE_FRAMES")) {
+		long long value = std::atoll(frames);
+		if (value > 0) {
+			dump_frames = (std::size_t)std::min<long long>(value, FRAME_HISTORY_SIZE - 1);
+		}
+	}
+	if (const char* spike_ms = std::getenv("GFFN_TRACE_SPIKE_MS")) {
+		double value = std::atof(spike_ms);
+		spike_threshold_ns = value > 0 ? (std::uint64_t)(value * 1e6) : 0;
+	}
+}
+
+std::string const& get_trace_filename() {
+	return trace_filename;
+}
+
+std::size_t get_dump_frames() {
+	return dump_frames;
+}
+
+}} // end namespace gffn::profiler
@@ -0,0 +1,59 @@
+#include <gffn_random.h>
+
+#include <atomic>
+
+namespace gffn {
+
+namespace {
+constexpr std::uint64_t DEFAULT_MASTER_SEED = 0x6766666E5F736565; // unseeded runs are still repeatable
+
+std::uint64_t splitmix64(std::uint64_t& x) {
+	std::uint64_t z = (x += 0x9E3779B97F4A7C15);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+	return z ^ (z >> 31);
+}
+
+std::atomic<std::uint64_t> master_seed{ DEFAULT_MASTER_SEED };
+// Bumped by set_master_seed so thread generators know to reseed. Starts at 1 so a fresh thread always seeds.
+std::atomic<std::uint32_t> seed_generation{ 1 };
+std::atomic<std::uint64_t> num_rng_threads{ 0 };
+}
+
+void GFFN_Rng::reseed(std::uint64_t seed) {
+	for (std::uint64_t& word : state) {
+		word = splitmix64(seed);
+	}
+}
+
+namespace random {
+
+void set_master_seed(std::uint64_t seed) {
+	master_seed.store(seed);
+	seed_generation.fetch_add(1);
+}
+
+std::uint64_t get_master_seed() {
+	return master_seed.load();
+}
+
+GFFN_Rng make_stream(std::uint64_t stream_id) {
+	std::uint64_t mixed_id = stream_id;
+	return GFFN_Rng(get_master_seed() ^ splitmix64(mixed_id));
+}
+
+GFFN_Rng& get_thread_rng() {
+	thread_local std::uint64_t thread_index = num_rng_threads.fetch_add(1);
+	thread_local std::uint32_t generation = 0;
+	thread_local GFFN_Rng rng;
+	std::uint32_t current_generation = seed_generation.load(std::memory_order_relaxed);
+	if (generation != current_generation) {
+		rng = make_stream(GFFN_RANDOM_STREAM_THREAD_BASE + thread_index);
+		generation = current_generation;
+	}
+	return rng;
+}
+
+} // end namespace random
+
+} // end namespace gffn
@@ -1,10 +1,24 @@
 #include <gffn_renderer.h>
+#include <gffn_render_stats.h>
 
 namespace gffn {
-    GFFN_Renderer::GFFN_Renderer(std::string const& game_name) : window{ game_name } {
+    namespace render_stats {
+        FrameCounts current_frame{};
+        FrameCounts last_frame{};
+        SDL_Texture* last_texture = nullptr;
+    }
+
+    GFFN_Renderer::GFFN_Renderer(std::string const& game_name, bool headless) : headless(headless) {
         // Renderer setup
-        //renderer = SDL_CreateRenderer(window.get_sdl_window(), -1, SDL_RENDERER_ACCELERATED);
-        renderer = SDL_CreateRenderer(window.get_sdl_window(), -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (headless) {
+            headless_surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_RGBA8888);
+            renderer = headless_surface != nullptr ? SDL_CreateSoftwareRenderer(headless_surface) : nullptr;
+        }
+        else {
+            window = std::make_unique<GFFN_Window>(game_name);
+            //renderer = SDL_CreateRenderer(window->get_sdl_window(), -1, SDL_RENDERER_ACCELERATED);
+            renderer = SDL_CreateRenderer(window->get_sdl_window(), -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        }
         if (renderer == nullptr) {
             throw GFFN_Exception(std::string("Failure to create SDL renderer"));
         }
@@ -17,10 +31,18 @@ namespace gffn {
         character_dismemberment_images = std::make_unique<GFFN_MultiImage>(get_texture("textures/goblin/goblin_1_limbs.png"));
 
         // TODO: Multi layer? Having a camera texture instead of having to do math to know what gets rendered. Might be more performant.
-        SDL_Texture* ground_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WORLD_GRID_WIDTH * 100, WORLD_GRID_HEIGHT * 100);
+        // Headless, the ground only has to exist as a target for decals. The ground object is world sized either way.
+        int ground_texture_width = headless ? 100 : WORLD_GRID_WIDTH * 100;
+        int ground_texture_height = headless ? 100 : WORLD_GRID_HEIGHT * 100;
+        SDL_Texture* ground_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, ground_texture_width, ground_texture_height);
         if (ground_texture == nullptr) {
 			throw GFFN_Exception(std::string("Failure to create ground texture"));
 		}
+        memory::track_texture(ground_texture);
+        ground_object = std::make_shared<GFFN_GroundObject>(ground_texture);
+        if (headless) {
+            return;
+        }
         SDL_SetRenderTarget(renderer, ground_texture);
         for (SDL_Rect rect(0, 0, 100, 100); rect.x < WORLD_GRID_WIDTH * 100; rect.x += 100) {
             for (rect.y = 0; rect.y < WORLD_GRID_HEIGHT * 100; rect.y += 100) {
@@ -31,7 +53,6 @@ namespace gffn {
 				}
 			}
         }
-        ground_object = std::make_shared<GFFN_GroundObject>(ground_texture);
     }
     GFFN_Renderer::~GFFN_Renderer() {
         /*for (auto const& texture : still_textures) {
@@ -42,9 +63,13 @@ namespace gffn {
         }
         SDL_DestroyTexture(ground_object->get_texture());*/
         for(auto const& [key, value] : textures) {
+			memory::untrack_texture(value);
 			SDL_DestroyTexture(value);
 		}
         SDL_DestroyRenderer(renderer);
+        if (headless_surface != nullptr) {
+            SDL_FreeSurface(headless_surface);
+        }
     }
 
     void GFFN_Renderer::render_object_relative_to_camera(GFFN_GameObject* const object, GFFN_Camera camera) {
@@ -59,20 +84,26 @@ namespace gffn {
         object_rect_relative_to_camera.h = object_render_rect->h;
         if (object->get_shadow_texture() != nullptr) {
             // Create shadow rect in relation to character's rect.
-            SDL_Rect shadow_rect = *object->get_shadow_render_rect();
+            SDL_Rect shadow_rect = object->get_shadow_render_rect();
             SDL_Rect shadow_rect_relative_to_camera{};
             shadow_rect_relative_to_camera.x = shadow_rect.x - camera.viewport.x;
             shadow_rect_relative_to_camera.y = shadow_rect.y - camera.viewport.y;
             shadow_rect_relative_to_camera.w = shadow_rect.w;
             shadow_rect_relative_to_camera.h = shadow_rect.h;
             SDL_RenderCopy(renderer, object->get_shadow_texture(), nullptr, &shadow_rect_relative_to_camera);
+            render_stats::count_draw(object->get_shadow_texture());
         }
         object_rect_relative_to_camera.y -= static_cast<int>(object->get_height_offset());
         SDL_RenderCopy(renderer, object->get_texture(), object->get_source_rect(), &object_rect_relative_to_camera);
+        render_stats::count_draw(object->get_texture());
     }
 
-    void GFFN_Renderer::render_everything_in_viewport(objects_by_y_t& game_world_objects, GFFN_Camera camera) {
-        static std::vector<GFFN_GameObject*> sorted_row_of_objects;
+    void GFFN_Renderer::render_everything_in_viewport(objects_by_y_t& game_world_objects, GFFN_Camera camera, particles::ParticleSystem& particle_system) {
+        GFFN_PROFILE_SCOPE("render_everything_in_viewport");
+        frame_vector<GFFN_GameObject*> sorted_row_of_objects;
+        sorted_row_of_objects.reserve(256);
+
+        decal_queue.flush(renderer, ground_object->get_texture());
 
         SDL_SetRenderTarget(renderer, camera.get_camera_texture());
 
@@ -84,6 +115,7 @@ namespace gffn {
         ground_rect_relative_to_camera.w = ground_render_rect->w;
         ground_rect_relative_to_camera.h = ground_render_rect->h;
         SDL_RenderCopy(renderer, ground_object->get_texture(), ground_object->get_source_rect(), &ground_rect_relative_to_camera);
+        render_stats::count_draw(ground_object->get_texture());
 
         int top_left_grid_x = (camera.viewport.x / 100) - 1;
         int top_left_grid_y = (camera.viewport.y / 100) - 1;
@@ -113,11 +145,39 @@ namespace gffn {
 			sorted_row_of_objects.clear();
 		}
 
+        // Particles go over everything, one draw per particle texture.
+        {
+            GFFN_PROFILE_SCOPE("particles.render");
+            particle_system.render(renderer, camera.viewport);
+        }
+
         SDL_SetRenderTarget(renderer, nullptr);
         SDL_RenderCopy(renderer, camera.get_camera_texture(), nullptr, nullptr);
+        render_stats::count_draw(camera.get_camera_texture());
+    }
+
+    void GFFN_Renderer::present() {
+        GFFN_PROFILE_SCOPE("SDL_RenderPresent");
         SDL_RenderPresent(renderer);
     }
 
+    void GFFN_Renderer::paint_ground_tiles(std::span<const GFFN_GroundTile> tiles) {
+        if (headless || tiles.empty()) {
+            return;
+        }
+        SDL_Texture* previous_target = SDL_GetRenderTarget(renderer);
+        SDL_SetRenderTarget(renderer, ground_object->get_texture());
+        for (GFFN_GroundTile const& tile : tiles) {
+            SDL_Rect rect{ tile.cell_x * 100, tile.cell_y * 100, 100, 100 };
+            if (SDL_RenderCopy(renderer, tile.texture, nullptr, &rect) < 0) {
+                SDL_SetRenderTarget(renderer, previous_target);
+                throw GFFN_Exception(std::string("Failure to copy texture to ground texture"));
+            }
+            render_stats::count_draw(tile.texture);
+        }
+        SDL_SetRenderTarget(renderer, previous_target);
+    }
+
     WorldCoordinate GFFN_Renderer::get_mouse_position_as_coordinate(GFFN_Camera camera) {
         SDL_Rect camera_viewport = camera.viewport;
         int mouse_x, mouse_y;
@@ -0,0 +1,48 @@
+#include <gffn_simulation_lod.h>
+
+#include <algorithm>
+
+namespace gffn {
+
+void GFFN_SimulationLOD::begin_frame(double delta_time_seconds, WorldCoordinate camera_center) {
+	this->delta_time_seconds = delta_time_seconds;
+	this->camera_center = camera_center;
+	frame++;
+	num_objects.fill(0);
+	num_objects_ticked.fill(0);
+}
+
+GFFN_SimulationLODLevel GFFN_SimulationLOD::get_level(WorldCoordinate coords) const {
+	double dx = coords.x - camera_center.x;
+	double dy = coords.y - camera_center.y;
+	double distance_squared = dx * dx + dy * dy;
+	if (has_player) {
+		dx = coords.x - player_coords.x;
+		dy = coords.y - player_coords.y;
+		distance_squared = std::min(distance_squared, dx * dx + dy * dy);
+	}
+	if (distance_squared < FULL_RATE_DISTANCE * FULL_RATE_DISTANCE) {
+		return GFFN_SIMULATION_LOD_FULL;
+	}
+	if (distance_squared < HALF_RATE_DISTANCE * HALF_RATE_DISTANCE) {
+		return GFFN_SIMULATION_LOD_HALF;
+	}
+	if (distance_squared < QUARTER_RATE_DISTANCE * QUARTER_RATE_DISTANCE) {
+		return GFFN_SIMULATION_LOD_QUARTER;
+	}
+	return GFFN_SIMULATION_LOD_EIGHTH;
+}
+
+bool GFFN_SimulationLOD::should_tick(long unsigned int object_id, WorldCoordinate coords, double& scaled_delta_time_seconds) {
+	GFFN_SimulationLODLevel level = get_level(coords);
+	int period = get_tick_period(level);
+	num_objects[level]++;
+	if (((frame + object_id) & (period - 1)) != 0) {
+		return false;
+	}
+	num_objects_ticked[level]++;
+	scaled_delta_time_seconds = delta_time_seconds * period;
+	return true;
+}
+
+} // end namespace gffn
@@ -0,0 +1,211 @@
+#include <gffn_timer_wheel.h>
+#include <gffn_profiler.h>
+
+#include <algorithm>
+
+namespace gffn {
+
+GFFN_TimerWheel timer_wheel;
+
+namespace {
+constexpr std::uint64_t SLOT_MASK = GFFN_TimerWheel::SLOTS_PER_LEVEL - 1;
+constexpr std::uint64_t MAX_DELTA = ((std::uint64_t)1 << (GFFN_TimerWheel::BITS_PER_LEVEL * GFFN_TimerWheel::NUM_LEVELS)) - 1;
+}
+
+GFFN_TimerWheel::TimerNode* GFFN_TimerWheel::get_node(timer_id_t timer_id) {
+	std::uint32_t index = (std::uint32_t)(timer_id & 0xFFFFFFFF);
+	if (index == 0 || index > nodes.size()) {
+		return nullptr;
+	}
+	TimerNode& node = nodes[index - 1];
+	if (node.generation != (std::uint32_t)(timer_id >> 32) || node.callback == nullptr) {
+		return nullptr;
+	}
+	return &node;
+}
+
+void GFFN_TimerWheel::link(std::uint32_t index) {
+	TimerNode& node = nodes[index];
+	std::uint64_t delta = node.expire_tick > current_tick ? node.expire_tick - current_tick : 0;
+	std::uint64_t expire_tick = node.expire_tick;
+	int level = 0;
+	while (level < NUM_LEVELS - 1 && delta >= ((std::uint64_t)1 << (BITS_PER_LEVEL * (level + 1)))) {
+		level++;
+	}
+	if (delta > MAX_DELTA) {
+		// Too far out for the wheel. Parked in the furthest slot, it gets put back in when that slot cascades.
+		expire_tick = current_tick + MAX_DELTA;
+	}
+	else if (delta == 0) {
+		expire_tick = current_tick;
+	}
+	int slot = level * SLOTS_PER_LEVEL + (int)((expire_tick >> (BITS_PER_LEVEL * level)) & SLOT_MASK);
+	node.slot = (std::uint16_t)slot;
+	node.previous = NO_NODE;
+	node.next = slots[slot];
+	if (node.next != NO_NODE) {
+		nodes[node.next].previous = index;
+	}
+	slots[slot] = index;
+	node.linked = true;
+}
+
+void GFFN_TimerWheel::unlink(std::uint32_t index) {
+	TimerNode& node = nodes[index];
+	if (node.previous != NO_NODE) {
+		nodes[node.previous].next = node.next;
+	}
+	else {
+		slots[node.slot] = node.next;
+	}
+	if (node.next != NO_NODE) {
+		nodes[node.next].previous = node.previous;
+	}
+	node.linked = false;
+}
+
+void GFFN_TimerWheel::release(std::uint32_t index) {
+	TimerNode& node = nodes[index];
+	node.callback = nullptr;
+	node.data = nullptr;
+	node.generation++;
+	free_nodes.push_back(index);
+	num_pending--;
+}
+
+timer_id_t GFFN_TimerWheel::schedule(std::uint64_t delay_ms, callback_t callback, void* data) {
+	std::uint32_t index;
+	if (!free_nodes.empty()) {
+		index = free_nodes.back();
+		free_nodes.pop_back();
+	}
+	else {
+		index = (std::uint32_t)nodes.size();
+		nodes.push_back(TimerNode{ 0, 0, nullptr, nullptr, NO_NODE, NO_NODE, 1, 0, false });
+	}
+	TimerNode& node = nodes[index];
+	// Never in the current tick, that one has already fired.
+	node.expire_tick = current_tick + (delay_ms == 0 ? 1 : delay_ms);
+	node.sequence = next_sequence++;
+	node.callback = callback;
+	node.data = data;
+	link(index);
+	num_pending++;
+	return make_id(index, node.generation);
+}
+
+std::uint64_t GFFN_TimerWheel::get_sequence(timer_id_t timer_id) {
+	TimerNode* node = get_node(timer_id);
+	return node == nullptr ? 0 : node->sequence;
+}
+
+void GFFN_TimerWheel::set_sequence(timer_id_t timer_id, std::uint64_t sequence) {
+	TimerNode* node = get_node(timer_id);
+	if (node != nullptr) {
+		node->sequence = sequence;
+	}
+}
+
+bool GFFN_TimerWheel::cancel(timer_id_t timer_id) {
+	TimerNode* node = get_node(timer_id);
+	if (node == nullptr) {
+		return false;
+	}
+	std::uint32_t index = (std::uint32_t)(node - nodes.data());
+	if (node->linked) {
+		unlink(index);
+	}
+	release(index);
+	return true;
+}
+
+std::uint64_t GFFN_TimerWheel::get_ms_left(timer_id_t timer_id) {
+	TimerNode* node = get_node(timer_id);
+	if (node == nullptr) {
+		return 0;
+	}
+	return node->expire_tick > current_tick ? node->expire_tick - current_tick : 0;
+}
+
+void GFFN_TimerWheel::reset(double elapsed_seconds, std::uint64_t next_sequence) {
+	for (std::uint32_t index = 0; index < nodes.size(); index++) {
+		TimerNode& node = nodes[index];
+		if (node.callback == nullptr) {
+			continue; // already on the free list
+		}
+		node.callback = nullptr;
+		node.data = nullptr;
+		node.generation++;
+		node.linked = false;
+		free_nodes.push_back(index);
+	}
+	slots.fill(NO_NODE);
+	num_pending = 0;
+	num_fired_last_advance = 0;
+	this->elapsed_seconds = elapsed_seconds;
+	current_tick = (std::uint64_t)(elapsed_seconds * 1000.0);
+	this->next_sequence = next_sequence;
+}
+
+void GFFN_TimerWheel::cascade(int level) {
+	int slot = level * SLOTS_PER_LEVEL + (int)((current_tick >> (BITS_PER_LEVEL * level)) & SLOT_MASK);
+	std::uint32_t index = slots[slot];
+	slots[slot] = NO_NODE;
+	while (index != NO_NODE) {
+		std::uint32_t next = nodes[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+void GFFN_TimerWheel::advance(double delta_time_seconds) {
+	GFFN_PROFILE_SCOPE("timer_wheel.advance");
+	elapsed_seconds += delta_time_seconds;
+	std::uint64_t target_tick = (std::uint64_t)(elapsed_seconds * 1000.0);
+	num_fired_last_advance = 0;
+	while (current_tick < target_tick) {
+		current_tick++;
+		// Every time a level wraps around, the next slot of the level above gets spread over the levels below it.
+		for (int level = 1; level < NUM_LEVELS; level++) {
+			if (((current_tick >> (BITS_PER_LEVEL * (level - 1))) & SLOT_MASK) != 0) {
+				break;
+			}
+			cascade(level);
+		}
+		if (num_pending == 0) {
+			continue;
+		}
+
+		int slot = (int)(current_tick & SLOT_MASK);
+		firing.clear();
+		for (std::uint32_t index = slots[slot]; index != NO_NODE; index = nodes[index].next) {
+			if (nodes[index].expire_tick <= current_tick) {
+				firing.push_back(make_id(index, nodes[index].generation));
+			}
+		}
+		// A slot's list is in whatever order timers were linked and cascaded, which a restore doesn't reproduce.
+		if (firing.size() > 1) {
+			std::sort(firing.begin(), firing.end(), [this](timer_id_t a, timer_id_t b) {
+				TimerNode const& x = nodes[(a & 0xFFFFFFFF) - 1];
+				TimerNode const& y = nodes[(b & 0xFFFFFFFF) - 1];
+				return x.expire_tick != y.expire_tick ? x.expire_tick < y.expire_tick : x.sequence < y.sequence;
+			});
+		}
+		// Looked up again by id, an earlier callback this tick might have cancelled it.
+		for (timer_id_t timer_id : firing) {
+			TimerNode* node = get_node(timer_id);
+			if (node == nullptr) {
+				continue;
+			}
+			std::uint32_t index = (std::uint32_t)(node - nodes.data());
+			callback_t callback = node->callback;
+			void* data = node->data;
+			unlink(index);
+			release(index);
+			num_fired_last_advance++;
+			callback(data);
+		}
+	}
+}
+
+} // end namespace gffn
@@ -1,83 +1,321 @@
-#ifndef PID_H
-#define PID_H
+#pragma once
+
+// Rewritten header only, with a SIMD bank, from Nick Mosher's PID controller that this project started out with. His
+// original description is kept below.
+/**
+ * @author Nick Mosher, <codewhisperer97@gmail.com>
+ *
+ * A PID Controller is a method of system control in which a correctional output
+ * is generated to guide the system toward a desired setpoint (aka target).
+ * The PID Controller calculates the output based on the following factors:
+ *
+ *    Gains (proportional, integral, and derivative)
+ *    Target
+ *    Feedback
+ *
+ * The gain values act as multipliers for their corresponding components of PID
+ * (more detail later).  The target is the value which the system strives to
+ * reach by manipulating the output.  The feedback is the system's actual
+ * position or status in regards to the physical world.
+ * Another important term in PID is "error", which refers to the difference
+ * between the target and the feedback.
+ *
+ * Each of the three components of PID contributes a unique behavior to the
+ * system.
+ *
+ *    The Proportional component introduces a linear relationship between the
+ *    error (target minus feedback) and the output.  This means that as the
+ *    feedback grows further away from the target, the output grows
+ *    proportionally stronger.
+ *
+ *        Proportional component = (P Gain) * (target - feedback)
+ *
+ *    The Integral component is designed to give a very precise approach of the
+ *    feedback to the target.  Depending on the scale of the physical system
+ *    and the precision of feedback (e.g. sensors), the proportional component
+ *    alone is likely not sufficient to provide adequate power (e.g. to motors)
+ *    to guide the system in regards to small-scale corrections.  The Integral
+ *    component integrates the error of the system (target - feedback) over
+ *    time.  If the system reaches a point where it is close but not exactly
+ *    on top of the target, the integration will slowly build until it is
+ *    powerful enough to overcome static resistances and move the system
+ *    preciesly to the target.
+ *
+ *        Integral component = (I Gain) * Integral of error over time
+ *
+ *          *In this implementation, Integral is calculated with a running
+ *          summation of the system's error, updated at each tick.
+ *
+ *    The Derivative component measures the rate of change of the feedback.
+ *    It can reduce the strength of the output if the feedback is approaching
+ *    the target too quickly or if the feedback is moving away from the target.
+ *
+ *        Derivative component = (D Gain) * ((error - lastError) / time - lastTime)
+ *
+ * The output generated by the PID Controller is the sum of the three
+ * components.
+ *
+ *    PID output = Proportional component + Integral component + Derivative component
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFFN_PID_SSE
+#include <emmintrin.h>
 #endif
-#include <functional>
 
+namespace gffn {
+
+// Tuning for a controller or a whole bank. Everything is constexpr so tunings can live next to the code that uses them,
+// like static constexpr PIDGains<float> PURSUIT_GAINS{ 2.0f, 0.1f, 0.5f };
+template <class T = double>
+struct PIDGains {
+	static_assert(std::is_floating_point_v<T>, "PID math needs a floating point type, integer error sums truncate");
+
+	T p = 0;
+	T i = 0;
+	T d = 0;
+	T max_integral = 30000; // the error integral is clamped to +-this so it can't wind up forever while the output is saturated
+	T min_output = 0;
+	T max_output = 0;       // outputs are only clamped when max_output > min_output
+	T wrap_range = 0;       // if > 0 the feedback wraps around every wrap_range (angles), and the error takes the short way
+
+	constexpr PIDGains() = default;
+	constexpr PIDGains(T p, T i, T d) : p(p), i(i), d(d) {}
+	constexpr PIDGains(T p, T i, T d, T max_integral, T min_output, T max_output, T wrap_range = 0) :
+	p(p), i(i), d(d), max_integral(max_integral), min_output(min_output), max_output(max_output), wrap_range(wrap_range) {}
+
+	constexpr bool is_output_clamped() const { return max_output > min_output; }
+};
+
+namespace pid {
+
+template <class T>
+constexpr T clamp(T value, T low, T high) {
+	return value < low ? low : (value > high ? high : value);
+}
+
+// Shortest signed difference on a ring of size range. No std::round so it stays constexpr.
 template <class T>
-class PIDController
-{
+constexpr T wrap_error(T error, T range) {
+	T turns = error / range;
+	long long whole_turns = (long long)(turns >= 0 ? turns + (T)0.5 : turns - (T)0.5);
+	return error - range * (T)whole_turns;
+}
+
+} // end namespace pid
+
+// One controller. The caller hands in the feedback and uses the output, no callbacks. Time comes in as the tick's
+// delta time, so it works the same whatever rate it's ticked at (the LOD tick periods included).
+template <class T = double>
+class PIDController {
+	PIDGains<T> gains;
+	T integral = 0;
+	T last_error = 0;
+	T output = 0;
+	bool has_last_error = false;
+public:
+	constexpr PIDController() = default;
+	constexpr explicit PIDController(PIDGains<T> const& gains) : gains(gains) {}
+
+	// Returns the new output. The integral is trapezoidal, and there's no derivative on the first tick after a reset since
+	// there's nothing to take it against.
+	constexpr T tick(T target, T feedback, T delta_time_seconds) {
+		T error = target - feedback;
+		if (gains.wrap_range > 0) {
+			error = pid::wrap_error(error, gains.wrap_range);
+		}
+		T derivative = 0;
+		if (has_last_error && delta_time_seconds > 0) {
+			integral += (last_error + error) * (T)0.5 * delta_time_seconds;
+			derivative = (error - last_error) / delta_time_seconds;
+		}
+		integral = pid::clamp(integral, -gains.max_integral, gains.max_integral);
+		output = gains.p * error + gains.i * integral + gains.d * derivative;
+		if (gains.is_output_clamped()) {
+			output = pid::clamp(output, gains.min_output, gains.max_output);
+		}
+		last_error = error;
+		has_last_error = true;
+		return output;
+	}
+
+	// Forgets the integral and the last error, for when the target jumps somewhere unrelated (a new chase target).
+	constexpr void reset() {
+		integral = 0;
+		last_error = 0;
+		output = 0;
+		has_last_error = false;
+	}
+
+	constexpr void set_gains(PIDGains<T> const& new_gains) { gains = new_gains; }
+	constexpr PIDGains<T> const& get_gains() const { return gains; }
+	constexpr T get_output() const { return output; }
+	constexpr T get_integral() const { return integral; }
+	constexpr T get_last_error() const { return last_error; }
+};
+
+// N controllers with the same tuning, stored as structure of arrays and stepped in one call. For things like thousands of
+// NPCs steering toward their targets: fill the targets and feedbacks, step, read the outputs. The float version goes
+// 4 lanes at a time with SSE2, one lane per controller, with the leftovers past the last multiple of 4 done by the scalar
+// loop. Anything else is only the scalar loop, which the compiler can vectorize.
+// Every lane does the same operations in the same order as PIDController::tick, so a lane's output matches what a
+// PIDController with the same gains and inputs returns. gffn_pid_bench checks that before it times anything.
+// Wrapping isn't supported here, bank things like x and y, not headings.
+template <class T = float>
+class PIDBank {
+	static_assert(std::is_floating_point_v<T>, "PID math needs a floating point type, integer error sums truncate");
+
+	PIDGains<T> gains;
+	std::vector<T> targets;
+	std::vector<T> feedbacks;
+	std::vector<T> integrals;
+	std::vector<T> last_errors;
+	std::vector<T> outputs;
+	std::vector<T> has_last_error; // 0 or 1, kept as T so it can be multiplied in instead of branched on
+
+	void step_scalar(std::size_t begin, T delta_time_seconds) {
+		T half_delta_time = delta_time_seconds * (T)0.5;
+		// Divided rather than multiplied by the inverse, so every lane rounds the same as PIDController::tick. No derivative
+		// for a zero delta time, same as there.
+		bool has_derivative = delta_time_seconds > 0;
+		bool clamp_output = gains.is_output_clamped();
+		for (std::size_t index = begin; index < targets.size(); index++) {
+			T error = targets[index] - feedbacks[index];
+			T had_last = has_last_error[index];
+			T integral = integrals[index] + had_last * (last_errors[index] + error) * half_delta_time;
+			integral = pid::clamp(integral, -gains.max_integral, gains.max_integral);
+			T derivative = has_derivative ? had_last * ((error - last_errors[index]) / delta_time_seconds) : (T)0;
+			T output = gains.p * error + gains.i * integral + gains.d * derivative;
+			if (clamp_output) {
+				output = pid::clamp(output, gains.min_output, gains.max_output);
+			}
+			integrals[index] = integral;
+			last_errors[index] = error;
+			outputs[index] = output;
+			has_last_error[index] = (T)1;
+		}
+	}
+
+#ifdef GFFN_PID_SSE
+	std::size_t step_sse(float delta_time_seconds) {
+		std::size_t num_vectorized = targets.size() & ~(std::size_t)3;
+		__m128 half_delta_time = _mm_set1_ps(delta_time_seconds * 0.5f);
+		bool has_derivative = delta_time_seconds > 0;
+		__m128 delta_time = _mm_set1_ps(delta_time_seconds);
+		__m128 p = _mm_set1_ps(gains.p);
+		__m128 i = _mm_set1_ps(gains.i);
+		__m128 d = _mm_set1_ps(gains.d);
+		__m128 max_integral = _mm_set1_ps(gains.max_integral);
+		__m128 min_integral = _mm_set1_ps(-gains.max_integral);
+		bool clamp_output = gains.is_output_clamped();
+		__m128 min_output = _mm_set1_ps(gains.min_output);
+		__m128 max_output = _mm_set1_ps(gains.max_output);
+		__m128 one = _mm_set1_ps(1.0f);
+		float* target = targets.data();
+		float* feedback = feedbacks.data();
+		float* integrals_out = integrals.data();
+		float* last_errors_out = last_errors.data();
+		float* outputs_out = outputs.data();
+		float* had_last_out = has_last_error.data();
+		for (std::size_t index = 0; index < num_vectorized; index += 4) {
+			__m128 error = _mm_sub_ps(_mm_loadu_ps(target + index), _mm_loadu_ps(feedback + index));
+			__m128 had_last = _mm_loadu_ps(had_last_out + index);
+			__m128 last_error = _mm_loadu_ps(last_errors_out + index);
+			__m128 integral = _mm_add_ps(_mm_loadu_ps(integrals_out + index),
+				_mm_mul_ps(had_last, _mm_mul_ps(_mm_add_ps(last_error, error), half_delta_time)));
+			integral = _mm_min_ps(_mm_max_ps(integral, min_integral), max_integral);
+			__m128 derivative = has_derivative ? _mm_mul_ps(had_last, _mm_div_ps(_mm_sub_ps(error, last_error), delta_time)) : _mm_setzero_ps();
+			__m128 output = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, error), _mm_mul_ps(i, integral)), _mm_mul_ps(d, derivative));
+			if (clamp_output) {
+				output = _mm_min_ps(_mm_max_ps(output, min_output), max_output);
+			}
+			_mm_storeu_ps(integrals_out + index, integral);
+			_mm_storeu_ps(last_errors_out + index, error);
+			_mm_storeu_ps(outputs_out + index, output);
+			_mm_storeu_ps(had_last_out + index, one);
+		}
+		return num_vectorized;
+	}
+#endif
 public:
-	PIDController(double p, double i, double d, std::function<T()> pidSource, std::function<void(T output)> pidOutput);
-	T tick();
-	void setTarget(T t);
-	T getTarget();
-	T getOutput();
-	T getFeedback();
-	T getError();
-	void setEnabled(bool e);
-	bool isEnabled();
-	T getProportionalComponent();
-	T getIntegralComponent();
-	T getDerivativeComponent();
-	void setMaxIntegralCumulation(T max);
-	T getMaxIntegralCumulation();
-	T getIntegralCumulation();
-
-	void setInputBounded(bool bounded);
-	bool isInputBounded();
-	void setInputBounds(T lower, T upper);
-	T getInputLowerBound();
-	T getInputUpperBound();
-	void setOutputBounded(bool bounded);
-	bool isOutputBounded();
-	void setOutputBounds(T lower, T upper);
-	T getOutputLowerBound();
-	T getOutputUpperBound();
-	void setFeedbackWrapped(bool wrap);
-	bool isFeedbackWrapped();
-	void setFeedbackWrapBounds(T lower, T upper);
-	T getFeedbackWrapLowerBound();
-	T getFeedbackWrapUpperBound();
-
-	void setPID(double p, double i, double d);
-	void setP(double p);
-	void setI(double i);
-	void setD(double d);
-	double getP();
-	double getI();
-	double getD();
-	void setPIDSource(T(*pidSource)());
-	void setPIDOutput(void (*pidOutput)(T output));
-	void registerTimeFunction(unsigned long (*getSystemTime)());
-private:
-	double _p;
-	double _i;
-	double _d;
-	T target;
-	T output;
-	bool enabled;
-	T currentFeedback;
-	T lastFeedback;
-	T error;
-	T lastError;
-	long currentTime;
-	long lastTime;
-	T integralCumulation;
-	T maxCumulation;
-	T cycleDerivative;
-
-	bool inputBounded;
-	T inputLowerBound;
-	T inputUpperBound;
-	bool outputBounded;
-	T outputLowerBound;
-	T outputUpperBound;
-	bool feedbackWrapped;
-	T feedbackWrapLowerBound;
-	T feedbackWrapUpperBound;
-
-	bool timeFunctionRegistered;
-	std::function<T()> _pidSource;
-	std::function<void(T output)> _pidOutput;
-	unsigned long (*_getSystemTime)();
-};
\ No newline at end of file
+	PIDBank() = default;
+	explicit PIDBank(PIDGains<T> const& gains) : gains(gains) {}
+
+	// Returns the new controller's index. Indices stay put until remove() moves the last one down.
+	std::size_t add(T target = 0, T feedback = 0) {
+		targets.push_back(target);
+		feedbacks.push_back(feedback);
+		integrals.push_back(0);
+		last_errors.push_back(0);
+		outputs.push_back(0);
+		has_last_error.push_back(0);
+		return targets.size() - 1;
+	}
+	// Swaps the last controller into index and pops, so whoever owned the last index has to take index instead.
+	void remove(std::size_t index) {
+		std::size_t last = targets.size() - 1;
+		targets[index] = targets[last];
+		feedbacks[index] = feedbacks[last];
+		integrals[index] = integrals[last];
+		last_errors[index] = last_errors[last];
+		outputs[index] = outputs[last];
+		has_last_error[index] = has_last_error[last];
+		targets.pop_back();
+		feedbacks.pop_back();
+		integrals.pop_back();
+		last_errors.pop_back();
+		outputs.pop_back();
+		has_last_error.pop_back();
+	}
+	void reserve(std::size_t num_controllers) {
+		targets.reserve(num_controllers);
+		feedbacks.reserve(num_controllers);
+		integrals.reserve(num_controllers);
+		last_errors.reserve(num_controllers);
+		outputs.reserve(num_controllers);
+		has_last_error.reserve(num_controllers);
+	}
+	void clear() {
+		targets.clear();
+		feedbacks.clear();
+		integrals.clear();
+		last_errors.clear();
+		outputs.clear();
+		has_last_error.clear();
+	}
+	void reset(std::size_t index) {
+		integrals[index] = 0;
+		last_errors[index] = 0;
+		outputs[index] = 0;
+		has_last_error[index] = 0;
+	}
+
+	// Ticks every controller once. Same math as PIDController::tick.
+	void step(T delta_time_seconds) {
+		std::size_t begin = 0;
+#ifdef GFFN_PID_SSE
+		if constexpr (std::is_same_v<T, float>) {
+			begin = step_sse(delta_time_seconds);
+		}
+#endif
+		step_scalar(begin, delta_time_seconds);
+	}
+
+	void set_target(std::size_t index, T target) { targets[index] = target; }
+	void set_feedback(std::size_t index, T feedback) { feedbacks[index] = feedback; }
+	T get_output(std::size_t index) const { return outputs[index]; }
+	// For filling or reading a whole bank in one loop.
+	T* get_targets() { return targets.data(); }
+	T* get_feedbacks() { return feedbacks.data(); }
+	T const* get_outputs() const { return outputs.data(); }
+
+	void set_gains(PIDGains<T> const& new_gains) { gains = new_gains; }
+	PIDGains<T> const& get_gains() const { return gains; }
+	std::size_t size() const { return targets.size(); }
+};
+
+} // end namespace gffn
@@ -3,6 +3,8 @@
 #include <vector>
 #include <format>
 #include <chrono>
+#include <map>
+#include <tuple>
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -33,18 +35,22 @@ typedef enum : int {
 	GFFN_CHARACTER_ANIMATION_STATE_END
 } GFFN_CharacterAnimationState;
 
-class GFFN_Animations {
+// Everything about an animation texture that is the same for every character drawn with it. Characters share one of
+// these per texture instead of each querying the texture and keeping their own copy.
+struct GFFN_AnimationSheet {
+	SDL_Texture* animation_texture; // This texture contains all of the frames of the animation.
 	int frame_width;
 	int frame_height;
-	SDL_Texture* animation_texture; // This texture contains all of the frames of the animation.
-	std::shared_ptr<SDL_Rect> frame_rect; // This is the rectangle of the current frame.
-	std::pair<int, int> current_frame; // The first value is the state, the second value is the frame number of that state.
-	int fps;
 	int number_of_states;
 	int number_of_frames_per_state;
-public:
-	GFFN_Animations(SDL_Texture* animation_texture, int fps, int frame_width, int frame_height) : 
-	animation_texture(animation_texture), fps(fps), current_frame(GFFN_ANIMATION_IDLE_BOTTOM_LEFT, 0), frame_width(frame_width), frame_height(frame_height) {
+
+	static const GFFN_AnimationSheet* get(SDL_Texture* animation_texture, int frame_width, int frame_height) {
+		static std::map<std::tuple<SDL_Texture*, int, int>, GFFN_AnimationSheet> sheets;
+		auto key = std::make_tuple(animation_texture, frame_width, frame_height);
+		auto it = sheets.find(key);
+		if (it != sheets.end()) {
+			return &it->second;
+		}
 		int width, height;
 		SDL_QueryTexture(animation_texture, NULL, NULL, &width, &height);
 		if (width % frame_width != 0) {
@@ -53,35 +59,49 @@ public:
 		if (height % frame_height != 0) {
 			throw GFFN_Exception(std::format("Animation texture height is not a multiple of {}.", frame_height));
 		}
-		number_of_states = height / frame_height;
-		number_of_frames_per_state = width / frame_width;
-		frame_rect = std::make_shared<SDL_Rect>();
+		GFFN_AnimationSheet sheet{ animation_texture, frame_width, frame_height, height / frame_height, width / frame_width };
+		return &sheets.emplace(key, sheet).first->second;
 	}
+};
+
+class GFFN_Animations {
+	const GFFN_AnimationSheet* sheet;
+	std::chrono::high_resolution_clock::time_point last_time = std::chrono::high_resolution_clock::now();
+	// The state and the frame number of that state.
+	short current_state = GFFN_ANIMATION_IDLE_BOTTOM_LEFT;
+	short current_frame_number = 0;
+	short fps;
+public:
+	GFFN_Animations(SDL_Texture* animation_texture, int fps, int frame_width, int frame_height) : 
+	sheet(GFFN_AnimationSheet::get(animation_texture, frame_width, frame_height)), fps((short)fps) {}
 	~GFFN_Animations() {}
 
 	// Returns information to get the current frame. 
 	// The first value contains the entire animation texture, the second value contains the rectangle of the current frame.
-	std::pair<SDL_Texture*, SDL_Rect*> get_current_frame() {
-		int current_state = current_frame.first;
-		int current_frame_number = current_frame.second;
-		*frame_rect = { current_frame_number * frame_width, current_state * frame_height, frame_width, frame_height };
-		return std::make_pair(animation_texture, frame_rect.get());
+	std::pair<SDL_Texture*, SDL_Rect> get_current_frame() const {
+		SDL_Rect frame_rect{ current_frame_number * sheet->frame_width, current_state * sheet->frame_height, sheet->frame_width, sheet->frame_height };
+		return std::make_pair(sheet->animation_texture, frame_rect);
 	}
 
 	void set_fps(int fps) {
-		this->fps = fps;
+		this->fps = (short)fps;
 	}
 
 	void set_state(int state) {
-		current_frame.first = state;
+		current_state = (short)state;
 	}	
 
+	// For world snapshots.
+	const GFFN_AnimationSheet* get_sheet() const { return sheet; }
+	int get_fps() const { return fps; }
+	int get_state() const { return current_state; }
+	int get_frame_number() const { return current_frame_number; }
+	void set_frame_number(int frame_number) { current_frame_number = (short)frame_number; }
+
 	void next_frame() {
-		current_frame.second = (current_frame.second + 1) % number_of_frames_per_state;
+		current_frame_number = (current_frame_number + 1) % sheet->number_of_frames_per_state;
 	}
 
-	std::chrono::high_resolution_clock::time_point last_time = std::chrono::high_resolution_clock::now();
-
 	void tick() {
 		auto current_time = std::chrono::high_resolution_clock::now();
 		auto time_diff = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - last_time);
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <utility>
+
+#include <gffn_timer_wheel.h>
+
+namespace gffn {
+
+// Coroutine frames come from size class pools, so starting a behavior when an NPC spawns doesn't hit the heap.
+void* allocate_behavior_frame(std::size_t size);
+void deallocate_behavior_frame(void* frame, std::size_t size);
+// Grows the pool for frames of size so num_frames more fit, for batch spawns. See GFFN_Behavior::get_frame_size.
+void reserve_behavior_frames(std::size_t size, std::size_t num_frames);
+
+// An AI script written as a coroutine. It runs until its first co_await when it's created, then only gets resumed when
+// what it waits on happens, through the timer wheel. Nothing about it is looked at on frames where it's waiting.
+// Owns the coroutine. Destroying it (or assigning another behavior) stops the script, and any timer it was waiting on is
+// cancelled with it.
+class GFFN_Behavior {
+public:
+	struct promise_type {
+		GFFN_Behavior get_return_object() { return GFFN_Behavior(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { throw; }
+
+		// Only the compiler knows how big a frame is. operator new runs right before the promise in it is constructed, so
+		// it leaves the size here for the promise to keep.
+		inline static std::size_t last_frame_size = 0;
+		std::size_t frame_size = last_frame_size;
+
+		static void* operator new(std::size_t size) {
+			last_frame_size = size;
+			return allocate_behavior_frame(size);
+		}
+		static void operator delete(void* frame, std::size_t size) { deallocate_behavior_frame(frame, size); }
+	};
+
+	GFFN_Behavior() = default;
+	~GFFN_Behavior() { reset(); }
+	GFFN_Behavior(GFFN_Behavior&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	GFFN_Behavior& operator=(GFFN_Behavior&& other) noexcept {
+		if (this != &other) {
+			reset();
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	GFFN_Behavior(const GFFN_Behavior&) = delete;
+	GFFN_Behavior& operator=(const GFFN_Behavior&) = delete;
+
+	void reset() {
+		if (handle) {
+			handle.destroy();
+			handle = nullptr;
+		}
+	}
+	bool is_running() const { return handle && !handle.done(); }
+	// What the timer wheel resumes it with, for putting a wait back after the wheel was reset.
+	void* get_address() const { return handle.address(); }
+	// Size of the coroutine frame, 0 if there's none. Every behavior started from the same coroutine has the same size.
+	std::size_t get_frame_size() const { return handle ? handle.promise().frame_size : 0; }
+
+private:
+	std::coroutine_handle<promise_type> handle = nullptr;
+
+	explicit GFFN_Behavior(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+};
+
+namespace behavior {
+
+// co_await wait_seconds(2.5) resumes the script after that much sim time.
+class wait_seconds {
+	double seconds;
+	timer_id_t timer_id = NO_TIMER;
+
+	static void resume(void* data) { std::coroutine_handle<>::from_address(data).resume(); }
+public:
+	explicit wait_seconds(double seconds) : seconds(seconds) {}
+	// If the script is destroyed while it's waiting, the timer goes with it.
+	~wait_seconds() { timer_wheel.cancel(timer_id); }
+	wait_seconds(const wait_seconds&) = delete;
+	wait_seconds& operator=(const wait_seconds&) = delete;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> waiting) {
+		timer_id = timer_wheel.schedule_seconds(seconds, &wait_seconds::resume, waiting.address());
+	}
+	void await_resume() noexcept { timer_id = NO_TIMER; }
+};
+
+// co_await wait_until(condition) resumes the script once condition() is true. It's checked every poll_seconds on the
+// timer wheel rather than every frame, so a thousand NPCs waiting on something cost nothing in between.
+template <class Condition>
+class wait_until {
+	Condition condition;
+	double poll_seconds;
+	timer_id_t timer_id = NO_TIMER;
+	std::coroutine_handle<> waiting = nullptr;
+
+	static void poll(void* data) {
+		wait_until* self = static_cast<wait_until*>(data);
+		self->timer_id = NO_TIMER;
+		if (self->condition()) {
+			self->waiting.resume();
+			return;
+		}
+		self->timer_id = timer_wheel.schedule_seconds(self->poll_seconds, &wait_until::poll, self);
+	}
+public:
+	static constexpr double DEFAULT_POLL_SECONDS = 0.1;
+
+	explicit wait_until(Condition condition, double poll_seconds = DEFAULT_POLL_SECONDS) :
+	condition(std::move(condition)), poll_seconds(poll_seconds) {}
+	~wait_until() { timer_wheel.cancel(timer_id); }
+	wait_until(const wait_until&) = delete;
+	wait_until& operator=(const wait_until&) = delete;
+
+	bool await_ready() { return condition(); }
+	void await_suspend(std::coroutine_handle<> waiting) {
+		this->waiting = waiting;
+		timer_id = timer_wheel.schedule_seconds(poll_seconds, &wait_until::poll, this);
+	}
+	void await_resume() noexcept {}
+};
+
+} // end namespace behavior
+
+} // end namespace gffn
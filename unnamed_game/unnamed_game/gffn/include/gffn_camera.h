@@ -5,31 +5,38 @@
 
 #include <gffn_utils.h>
 #include <gffn_physics.h>
+#include <gffn_memory.h>
+#include <gffn_profiler.h>
 
 namespace gffn{
 class GFFN_Camera {
 	// This is used so that it's easy to set the center pos of the camera to the center of a character, or wherever else
 	physics::ObjectPhysicsController camera_physics_controller;
 	WorldCoordinate camera_center_pos;
-	SDL_Texture* camera_texture;
+	SDL_Texture* camera_texture = nullptr;
 	SDL_Renderer* renderer;
+	bool headless; // no camera texture, a headless renderer draws straight into its own tiny target
 public:
 	static constexpr int WIDTH_OF_VIEWPORT_AT_ZOOM_1 = RENDERER_LOGICAL_WIDTH;
 	static constexpr int HEIGHT_OF_VIEWPORT_AT_ZOOM_1 = RENDERER_LOGICAL_HEIGHT;
 	// in logical pixels. This is the length and width of the viewport in pixels, with each unit of GFFN_WorldCoordinate being one pixel.
 	SDL_Rect viewport;
-	GFFN_Camera(SDL_Renderer* renderer) : 
-	renderer(renderer), camera_center_pos(WorldCoordinate(WORLD_GRID_WIDTH*50, WORLD_GRID_HEIGHT*50, 0)), 
-	viewport(SDL_Rect(0, 0, WIDTH_OF_VIEWPORT_AT_ZOOM_1, HEIGHT_OF_VIEWPORT_AT_ZOOM_1)),
-	camera_physics_controller(WorldCoordinate(WORLD_GRID_WIDTH * 50, WORLD_GRID_HEIGHT * 50, 0), 15) {
-		camera_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WIDTH_OF_VIEWPORT_AT_ZOOM_1, HEIGHT_OF_VIEWPORT_AT_ZOOM_1);
+	GFFN_Camera(SDL_Renderer* renderer, bool headless = false) : 
+	camera_physics_controller(WorldCoordinate(WORLD_GRID_WIDTH * 50, WORLD_GRID_HEIGHT * 50, 0), 15),
+	camera_center_pos(WorldCoordinate(WORLD_GRID_WIDTH*50, WORLD_GRID_HEIGHT*50, 0)), renderer(renderer), headless(headless),
+	viewport(SDL_Rect(0, 0, WIDTH_OF_VIEWPORT_AT_ZOOM_1, HEIGHT_OF_VIEWPORT_AT_ZOOM_1)) {
+		if (!headless) {
+			camera_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, WIDTH_OF_VIEWPORT_AT_ZOOM_1, HEIGHT_OF_VIEWPORT_AT_ZOOM_1);
+			memory::track_texture(camera_texture);
+		}
 	} // for starting a game at the origin
 	~GFFN_Camera() {}
 
 	void set_camera_center_pos(WorldCoordinate new_pos) {
 		camera_center_pos = new_pos;
-		viewport.x = (int)(camera_center_pos.x - ((double)viewport.w / 2));
-		viewport.y = (int)(camera_center_pos.y - ((double)viewport.h / 2));
+		WorldCoordinateInt2D top_left(WorldCoordinate(camera_center_pos.x - ((double)viewport.w / 2), camera_center_pos.y - ((double)viewport.h / 2), 0));
+		viewport.x = top_left.x;
+		viewport.y = top_left.y;
 	}
 	void move_to_position(WorldCoordinate new_pos) {
 		physics::Vector3D cam_to_pos = physics::Vector3D(camera_center_pos, new_pos);
@@ -43,6 +50,7 @@ public:
 	}
 
 	void tick(double delta_time_seconds) {
+		GFFN_PROFILE_SCOPE("camera.tick");
 		camera_physics_controller.tick(delta_time_seconds);
 		set_camera_center_pos(camera_physics_controller.get_floor_coords());
 		if (viewport.x < 150) {
@@ -80,8 +88,13 @@ public:
 	void zoom(double zoom_factor) {
 		viewport.w = (int)(WIDTH_OF_VIEWPORT_AT_ZOOM_1 * zoom_factor);
 		viewport.h = (int)(HEIGHT_OF_VIEWPORT_AT_ZOOM_1 * zoom_factor);
+		if (headless) {
+			return;
+		}
+		memory::untrack_texture(camera_texture);
 		SDL_DestroyTexture(camera_texture);
 		camera_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, viewport.w, viewport.h);
+		memory::track_texture(camera_texture);
 	}
 
 	// TODO: Add velocity if desired, not needed now.
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <gffn_game_object.h>
+#include <gffn_simulation_lod.h>
+
+namespace gffn {
+
+// Keeps goblins from standing inside each other. Once a tick every character is bucketed into a grid with cells as big
+// as the separation radius (a counting sort, no per cell vectors), then each NPC looks at a capped number of entries in
+// the 3x3 cells around it (three rows, each one contiguous range of the sorted arrays). In a clump the cap is hit and
+// the NPC is pushed down the density gradient instead, so the cost per NPC stays the same however many goblins are
+// stacked on one spot.
+class GFFN_CrowdSeparation {
+	// Per agent, in the order they were gathered.
+	std::vector<GFFN_Character*> agents;
+	std::vector<float> agent_x;
+	std::vector<float> agent_y;
+	std::vector<int> agent_cell;
+	std::vector<long unsigned int> agent_id;
+	std::vector<std::uint8_t> agent_gets_pushed; // NPCs that tick this frame
+	std::vector<float> force_x;
+	std::vector<float> force_y;
+	// Agents sorted by cell. Cell c holds sorted_agents[cell_start[c]] to sorted_agents[cell_start[c + 1]], and the
+	// positions and ids are copied in the same order so scanning a cell reads memory in a straight line.
+	std::vector<std::uint32_t> cell_start;
+	std::vector<std::uint32_t> sorted_agents;
+	std::vector<float> sorted_x;
+	std::vector<float> sorted_y;
+	std::vector<long unsigned int> sorted_id;
+	std::vector<int> sorted_cell;
+	std::vector<std::uint8_t> sorted_gets_pushed;
+	int cells_wide;
+	int cells_high;
+	std::size_t num_pairs_last_tick = 0;
+	std::size_t num_capped_last_tick = 0;
+
+	void gather_agents(std::vector<GFFN_GameObject*>::iterator begin, std::vector<GFFN_GameObject*>::iterator end, GFFN_SimulationLOD const& lod);
+	void bucket_agents();
+	void compute_forces();
+	int get_cell_population(int cell_x, int cell_y) const;
+	void add_coincident_force(std::uint32_t me, std::uint32_t other, float& total_x, float& total_y) const;
+public:
+	static constexpr float SEPARATION_DISTANCE = 70.0f;
+	static constexpr float FORCE_AT_SEPARATION_DISTANCE = 50000.0f;
+	static constexpr float MAX_PAIR_FORCE = 200000.0f;
+	// Entries looked at per NPC, neighbors within the radius or not. Past this the density gradient takes over.
+	static constexpr int MAX_SCANNED_PER_AGENT = 32;
+	static constexpr int MAX_NEIGHBORS_PER_AGENT = 12;
+	static constexpr float DENSITY_FORCE_PER_AGENT = 20000.0f;
+
+	GFFN_CrowdSeparation();
+
+	// Adds separation forces to every NPC in [begin, end) that ticks this frame. Characters push NPCs but don't get pushed
+	// themselves, and NPCs the LOD skips this frame still push the others. Forces are only added on the frames an NPC
+	// ticks, so a far NPC doesn't pile up 8 frames of them.
+	void tick(std::vector<GFFN_GameObject*>::iterator begin, std::vector<GFFN_GameObject*>::iterator end, GFFN_SimulationLOD const& lod);
+
+	std::size_t get_num_agents() const { return agents.size(); }
+	std::size_t get_num_pairs_last_tick() const { return num_pairs_last_tick; }
+	std::size_t get_num_capped_last_tick() const { return num_capped_last_tick; }
+};
+
+} // end namespace gffn
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace gffn {
+
+typedef struct GFFN_Decal {
+	SDL_Texture* texture;
+	SDL_Rect source_rect;
+	SDL_Rect dest_rect; // relative to the ground texture
+	bool has_source_rect;
+	std::uint32_t sequence; // keeps the bake order stable within a texture, so overlapping decals don't flicker between runs
+} GFFN_Decal;
+
+// Collects everything that wants to be baked into the ground texture during the tick and draws it all in one
+// render target pass, grouped by texture. With a budget, only that many are drawn per frame and the rest wait for the
+// next one, oldest first.
+class GFFN_DecalQueue {
+	std::vector<GFFN_Decal> decals;
+	std::size_t budget_per_frame = 0; // 0 is no limit
+	std::uint32_t next_sequence = 0;
+	std::size_t num_flushed_last_frame = 0;
+public:
+	static constexpr std::size_t INITIAL_CAPACITY = 512;
+
+	GFFN_DecalQueue() { decals.reserve(INITIAL_CAPACITY); }
+
+	void push(SDL_Texture* texture, SDL_Rect const* source_rect, SDL_Rect const& dest_rect) {
+		GFFN_Decal decal;
+		decal.texture = texture;
+		decal.has_source_rect = source_rect != nullptr;
+		decal.source_rect = source_rect != nullptr ? *source_rect : SDL_Rect{};
+		decal.dest_rect = dest_rect;
+		decal.sequence = next_sequence++;
+		decals.push_back(decal);
+	}
+
+	// Draws queued decals onto target and puts the previous render target back.
+	void flush(SDL_Renderer* renderer, SDL_Texture* target);
+
+	void set_budget_per_frame(std::size_t budget) { budget_per_frame = budget; }
+	std::size_t get_budget_per_frame() const { return budget_per_frame; }
+	std::size_t get_num_pending() const { return decals.size(); }
+	std::size_t get_num_flushed_last_frame() const { return num_flushed_last_frame; }
+};
+
+} // end namespace gffn
@@ -1,36 +1,202 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <tuple>
 #include <vector>
-#include <queue>
-#include <variant>
+
 #include <gffn_utils.h>
+#include <gffn_physics.h>
+#include <gffn_exception.h>
+#include <gffn_frame_arena.h>
+
+namespace gffn { namespace events {
 
-namespace gffn { 
+// Events carry object ids, not pointers. By the time a handler runs the object might be gone, so handlers look the
+// id up and skip it if it doesn't exist anymore.
 
-class GFFN_StraightProjectile;
-class GFFN_GridObject;
+typedef struct ExplosionHit {
+	long unsigned int object_id;
+	GFFN_ObjectType object_type;
+	int damage;
+	bool killed;
+} ExplosionHit;
 
-namespace events {
 typedef struct ExplosionEvent {
 	WorldCoordinate coordinates;
-	int power;
+	int power;            // damage at the center
 	long int blast_radius;
-	int min_damage;
-	std::vector<std::tuple<long unsigned int, GFFN_ObjectType>> objects_hit;
+	int min_damage;       // damage at the edge
+	// Filled in by the explosion handler, so handlers after it can see who got hit. Lives in the frame arena, so it's
+	// only good until the end of the tick.
+	frame_vector<ExplosionHit> objects_hit;
 } ExplosionEvent;
 
-
 typedef struct ProjectileHitEvent {
-	GFFN_StraightProjectile* const projectile;
-	GFFN_GridObject* const object;
+	long unsigned int projectile_id;
+	long unsigned int target_id;
+	GFFN_ObjectType target_type;
+	int damage;
+	int num_hits;                          // how many hits got coalesced into this one
+	physics::NormalizedVector3D direction; // of the last projectile that hit
+
+	std::uint64_t get_coalesce_key() const { return target_id; }
+	void coalesce(ProjectileHitEvent const& later) {
+		damage += later.damage;
+		num_hits += later.num_hits;
+		projectile_id = later.projectile_id;
+		direction = later.direction;
+	}
 } ProjectileHitEvent;
 
-//typedef struct ProjectileHitEvent {
-//	std::pair<long unsigned int, GFFN_ObjectType> projectile_info;
-//	std::pair<long unsigned int, GFFN_ObjectType> object_info;
-//} ProjectileHitEvent;
+// Events that can be merged by target. get_coalesce_key says which events are about the same thing, coalesce folds a
+// later event into an earlier one.
+template <class E>
+concept CoalescableEvent = requires(E & event, E const& later) {
+	{ event.get_coalesce_key() } -> std::convertible_to<std::uint64_t>;
+	event.coalesce(later);
+};
+
+// Every thread that pushes events gets its own index (the first one to push is 0), so each one writes to its own
+// buffer in every channel without locking.
+static constexpr std::size_t MAX_PRODUCER_THREADS = 16;
+std::size_t get_producer_thread_index();
+
+typedef int handler_id_t;
+
+// All events of one type. Producers push into their thread's buffer during the tick. publish() merges those into the
+// front buffer, which handlers then see as one contiguous span, while new pushes go back into the (now empty) producer
+// buffers. Every vector keeps its capacity, so after warm up a tick doesn't allocate.
+template <class E>
+class EventChannel {
+	struct alignas(64) ProducerBuffer {
+		std::vector<E> events;
+	};
+	std::array<ProducerBuffer, MAX_PRODUCER_THREADS> producers;
+	std::vector<E> front;
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> coalesce_scratch; // (key, index into merged)
+	std::vector<E> merged;
+	std::vector<std::pair<handler_id_t, std::function<void(std::span<E>)>>> handlers;
+	handler_id_t next_handler_id = 0;
+	bool coalescing = false;
+	std::size_t num_pushed_last_publish = 0;
+
+	void coalesce_into_front() {
+		coalesce_scratch.clear();
+		for (std::uint32_t i = 0; i < merged.size(); i++) {
+			coalesce_scratch.emplace_back((std::uint64_t)merged[i].get_coalesce_key(), i);
+		}
+		// Sorting by (key, index) keeps push order within a key, so "later" in coalesce means later.
+		std::sort(coalesce_scratch.begin(), coalesce_scratch.end());
+		for (std::size_t i = 0; i < coalesce_scratch.size();) {
+			front.push_back(merged[coalesce_scratch[i].second]);
+			E& coalesced = front.back();
+			std::size_t j = i + 1;
+			for (; j < coalesce_scratch.size() && coalesce_scratch[j].first == coalesce_scratch[i].first; j++) {
+				coalesced.coalesce(merged[coalesce_scratch[j].second]);
+			}
+			i = j;
+		}
+	}
+public:
+	void push(E const& event) {
+		std::size_t thread_index = get_producer_thread_index();
+		producers[thread_index].events.push_back(event);
+	}
+
+	// Turns coalescing by get_coalesce_key on or off. Only does anything for CoalescableEvent types.
+	void set_coalescing(bool coalescing) { this->coalescing = coalescing; }
+	bool get_coalescing() const { return coalescing; }
+
+	// Handlers get the whole front buffer at once, in subscription order. They may fill in results on the events
+	// (like ExplosionEvent::objects_hit) for the handlers after them.
+	handler_id_t subscribe(std::function<void(std::span<E>)> handler) {
+		handlers.emplace_back(next_handler_id, std::move(handler));
+		return next_handler_id++;
+	}
+	void unsubscribe(handler_id_t handler_id) {
+		std::erase_if(handlers, [handler_id](auto const& handler) { return handler.first == handler_id; });
+	}
+
+	// Only call this when no other thread is pushing, i.e. at the end of the tick.
+	void publish() {
+		front.clear();
+		merged.clear();
+		for (ProducerBuffer& producer : producers) {
+			merged.insert(merged.end(), producer.events.begin(), producer.events.end());
+			producer.events.clear();
+		}
+		num_pushed_last_publish = merged.size();
+		if constexpr (CoalescableEvent<E>) {
+			if (coalescing) {
+				coalesce_into_front();
+				return;
+			}
+		}
+		front.swap(merged);
+	}
+
+	void dispatch() {
+		if (front.empty()) {
+			return;
+		}
+		for (auto& handler : handlers) {
+			handler.second(std::span<E>(front.data(), front.size()));
+		}
+	}
+
+	std::span<const E> get_published() const { return std::span<const E>(front.data(), front.size()); }
+	std::size_t get_num_pushed_last_publish() const { return num_pushed_last_publish; }
+	std::size_t get_num_pending() const {
+		std::size_t total = 0;
+		for (ProducerBuffer const& producer : producers) {
+			total += producer.events.size();
+		}
+		return total;
+	}
+	std::size_t get_storage_bytes() const {
+		std::size_t bytes = (front.capacity() + merged.capacity()) * sizeof(E)
+			+ coalesce_scratch.capacity() * sizeof(std::pair<std::uint64_t, std::uint32_t>);
+		for (ProducerBuffer const& producer : producers) {
+			bytes += producer.events.capacity() * sizeof(E);
+		}
+		return bytes;
+	}
+};
+
+// One channel per event type.
+template <class... Events>
+class GFFN_EventBus {
+	std::tuple<EventChannel<Events>...> channels;
+public:
+	template <class E>
+	EventChannel<E>& get_channel() { return std::get<EventChannel<E>>(channels); }
+
+	template <class E>
+	void push(E const& event) { get_channel<E>().push(event); }
+
+	template <class E>
+	handler_id_t subscribe(std::function<void(std::span<E>)> handler) { return get_channel<E>().subscribe(std::move(handler)); }
+	template <class E>
+	void unsubscribe(handler_id_t handler_id) { get_channel<E>().unsubscribe(handler_id); }
+
+	void publish() { std::apply([](auto&... channel) { (channel.publish(), ...); }, channels); }
+	void dispatch() { std::apply([](auto&... channel) { (channel.dispatch(), ...); }, channels); }
+
+	// Events handed to the handlers by the last publish, after coalescing.
+	std::size_t get_num_published() const {
+		return std::apply([](auto const&... channel) { return (channel.get_published().size() + ... + 0); }, channels);
+	}
+	std::size_t get_storage_bytes() const {
+		return std::apply([](auto const&... channel) { return (channel.get_storage_bytes() + ... + 0); }, channels);
+	}
+};
 
-typedef std::queue<std::variant<ExplosionEvent, ProjectileHitEvent>> EventQueue;
+typedef GFFN_EventBus<ProjectileHitEvent, ExplosionEvent> EventBus;
 
-extern EventQueue event_queue;
-}} // end namespace gffn::events
\ No newline at end of file
+extern EventBus event_bus;
+}} // end namespace gffn::events
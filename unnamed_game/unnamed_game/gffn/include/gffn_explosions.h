@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <gffn_game_object.h>
+#include <gffn_events.h>
+
+namespace gffn {
+
+// Resolves explosions against world_grid. Every character in a cell the blast touches is a candidate, their positions
+// get copied into flat arrays and the distance falloff is done 4 at a time, then damage and knockback are applied
+// to the ones inside the radius and written to the event's objects_hit.
+class GFFN_ExplosionSystem {
+	// Scratch for the explosion being processed, kept between explosions so they don't allocate.
+	std::vector<GFFN_Character*> candidates;
+	std::vector<float> candidate_x;
+	std::vector<float> candidate_y;
+	std::vector<float> falloff;      // 1 at the center, 0 at the edge, negative outside
+	std::vector<float> distance;
+	std::size_t num_candidates_last_frame = 0;
+	std::size_t num_hits_last_frame = 0;
+
+	void gather_candidates(WorldCoordinatef center, float radius);
+	void compute_falloff(WorldCoordinatef center, float radius);
+public:
+	// Knockback momentum at the center of the blast, per point of power. 800 gets a 100kg goblin going 800px/s at power 100.
+	static constexpr double MOMENTUM_PER_POWER = 800.0;
+	static constexpr double UPWARD_MOMENTUM_FRACTION = 0.5;
+
+	GFFN_ExplosionSystem() {}
+
+	// Damage falls off linearly from power at the center to min_damage at blast_radius. Dead characters are skipped,
+	// the ones that die here are left for the caller to dismember and remove (they're in objects_hit with dead == true).
+	void process(events::ExplosionEvent& explosion);
+
+	// Call at the start of every tick, so the counters are per frame.
+	void begin_frame() {
+		num_candidates_last_frame = 0;
+		num_hits_last_frame = 0;
+	}
+	std::size_t get_num_candidates_last_frame() const { return num_candidates_last_frame; }
+	std::size_t get_num_hits_last_frame() const { return num_hits_last_frame; }
+};
+
+} // end namespace gffn
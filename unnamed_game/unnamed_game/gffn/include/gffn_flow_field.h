@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <gffn_utils.h>
+#include <gffn_physics.h>
+
+namespace gffn {
+
+// One shared path search for every NPC chasing the same goal. A Dijkstra over the world grid cells is run outwards from
+// the goal, and every reachable cell stores which of its 8 neighbours is one step closer. A chasing NPC just looks up the
+// cell it's standing in, so it costs the same whether 1 or 5000 goblins are chasing.
+// The search is only redone when the goal moves to another cell or a blocker is added/removed, and it's spread over
+// ticks (MAX_CELLS_PER_TICK at a time) into a back buffer. NPCs keep following the last finished field meanwhile. A goal
+// that moves again mid search waits for that search to finish, so the field is never more than two searches behind.
+class GFFN_FlowField {
+public:
+	static constexpr int NUM_CELLS = WORLD_GRID_WIDTH * WORLD_GRID_HEIGHT;
+	static constexpr std::uint32_t UNREACHABLE = 0xFFFFFFFF;
+	static constexpr std::uint8_t NO_DIRECTION = 0xFF;
+	// Steps are 10 across and 14 diagonal, so distances are in tenths of a cell.
+	static constexpr std::uint32_t STRAIGHT_COST = 10;
+	static constexpr std::uint32_t DIAGONAL_COST = 14;
+	static constexpr int MAX_CELLS_PER_TICK = 2500;
+
+private:
+	// On the heap, the world lives on the stack in main and two of these are ~100KB.
+	typedef struct Field {
+		std::vector<std::uint32_t> distance;
+		std::vector<std::uint8_t> direction; // index into the neighbour offsets, NO_DIRECTION at the goal
+		WorldCoordinate goal;
+		int goal_cell = -1;
+	} Field;
+
+	// Heap entries for the search, (distance, cell).
+	typedef struct OpenCell {
+		std::uint32_t distance;
+		int cell;
+		bool operator>(OpenCell const& other) const { return distance > other.distance; }
+	} OpenCell;
+
+	Field fields[2];
+	int front = 0;                                // the one NPCs sample
+	std::vector<std::uint8_t> num_blockers;
+	std::vector<OpenCell> open;                   // keeps its capacity between searches
+	WorldCoordinate goal;
+	int goal_cell = -1;
+	bool search_running = false;
+	bool needs_search = false;
+	std::size_t num_searches_finished = 0;
+	int cells_expanded_last_tick = 0;
+
+	static int get_cell(WorldCoordinate coords);
+	void start_search();
+	void run_search(int max_cells);
+	bool can_step(int cell_x, int cell_y, int direction) const;
+public:
+	GFFN_FlowField();
+
+	// Moving the goal inside its cell just updates where NPCs head once they're in that cell, no new search.
+	void set_goal(WorldCoordinate coords);
+	// Cells with at least one blocker are never stepped into. Environmental objects never move, so they're added once.
+	void add_blocker(WorldCoordinate coords);
+	void remove_blocker(WorldCoordinate coords);
+	bool is_blocked(WorldCoordinate coords) const;
+
+	// Continues (or starts) the search. Call once a tick, after set_goal.
+	void tick();
+
+	// Unit direction to walk in from coords, false if there's no path from there (or no field yet).
+	// In the goal's cell it points straight at the goal, and it's zero within a pixel of it.
+	bool get_direction(WorldCoordinate coords, physics::Vector3D& direction) const;
+	// Path length to the goal in world units, or -1 if unreachable.
+	double get_distance_to_goal(WorldCoordinate coords) const;
+
+	bool has_field() const { return fields[front].goal_cell >= 0; }
+	bool is_searching() const { return search_running; }
+	std::size_t get_num_searches_finished() const { return num_searches_finished; }
+	int get_cells_expanded_last_tick() const { return cells_expanded_last_tick; }
+};
+
+} // end namespace gffn
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <gffn_memory.h>
+
+namespace gffn {
+
+// Linear (bump) allocator for memory that only has to live until the end of the frame. Allocating is a pointer bump,
+// freeing single allocations does nothing and reset() throws everything away at once.
+// If a frame needs more than the arena has, the extra comes from overflow blocks and the next reset() grows the arena
+// to the high water mark, so after a few frames everything fits and a frame never calls malloc.
+// Anything allocated from it must be gone (or never touched again) by the time reset() is called.
+class GFFN_FrameArena {
+	std::byte* buffer = nullptr;
+	std::size_t capacity = 0;
+	std::size_t offset = 0;
+	std::uint32_t num_allocations = 0; // since the last reset
+	std::vector<std::byte*> overflow_blocks;
+	std::size_t overflow_bytes = 0;
+	std::size_t high_water_bytes = 0;
+	std::size_t num_overflows = 0;
+
+	void* allocate_overflow(std::size_t size, std::size_t align);
+public:
+	static constexpr std::size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+	GFFN_FrameArena(std::size_t capacity = DEFAULT_CAPACITY);
+	~GFFN_FrameArena();
+	GFFN_FrameArena(const GFFN_FrameArena&) = delete;
+	GFFN_FrameArena& operator=(const GFFN_FrameArena&) = delete;
+
+	void* allocate(std::size_t size, std::size_t align) {
+		memory::track_alloc(GFFN_MEMORY_TAG_FRAME_ARENA, size);
+		num_allocations++;
+		std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer);
+		std::size_t aligned_offset = (((base + offset + align - 1) / align) * align) - base;
+		if (aligned_offset + size > capacity) {
+			return allocate_overflow(size, align);
+		}
+		offset = aligned_offset + size;
+		return buffer + aligned_offset;
+	}
+
+	// O(1) unless the frame overflowed, in which case the arena is grown once so the next frame won't.
+	void reset();
+
+	std::size_t get_bytes_used() const { return offset + overflow_bytes; }
+	std::size_t get_capacity() const { return capacity; }
+	std::size_t get_high_water_bytes() const { return high_water_bytes; }
+	std::size_t get_num_overflows() const { return num_overflows; }
+};
+
+// The sim thread's arena. GFFN_GameWorld::tick resets it at the end of every tick.
+extern GFFN_FrameArena frame_arena;
+
+// std allocator on top of a GFFN_FrameArena, so std containers can be used for per-frame scratch data.
+// deallocate is a no-op, the memory comes back when the arena is reset.
+template <class T>
+class GFFN_FrameAllocator {
+	template <class U> friend class GFFN_FrameAllocator;
+	GFFN_FrameArena* arena;
+public:
+	typedef T value_type;
+
+	GFFN_FrameAllocator() noexcept : arena(&frame_arena) {}
+	GFFN_FrameAllocator(GFFN_FrameArena& arena) noexcept : arena(&arena) {}
+	template <class U>
+	GFFN_FrameAllocator(const GFFN_FrameAllocator<U>& other) noexcept : arena(other.arena) {}
+
+	T* allocate(std::size_t n) {
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, std::size_t) noexcept {}
+
+	template <class U>
+	bool operator==(const GFFN_FrameAllocator<U>& other) const noexcept { return arena == other.arena; }
+	template <class U>
+	bool operator!=(const GFFN_FrameAllocator<U>& other) const noexcept { return arena != other.arena; }
+};
+
+template <class T>
+using frame_vector = std::vector<T, GFFN_FrameAllocator<T>>;
+
+} // end namespace gffn
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace gffn {
+
+// Things that happened during a frame, kept so a hitch can say what else was going on.
+typedef enum : int {
+	GFFN_FRAME_COUNTER_OBJECTS_SPAWNED = 0,
+	GFFN_FRAME_COUNTER_OBJECTS_REMOVED,
+	GFFN_FRAME_COUNTER_EVENTS_DISPATCHED,
+	GFFN_FRAME_COUNTER_DECALS_BAKED,
+	GFFN_FRAME_COUNTER_TEXTURES_LOADED,
+	GFFN_FRAME_COUNTER_END
+} GFFN_FrameCounter;
+
+typedef struct GFFN_TimingPercentiles {
+	double p50_ms;
+	double p95_ms;
+	double p99_ms;
+	double max_ms;
+	std::size_t num_samples;
+} GFFN_TimingPercentiles;
+
+// The last window_size samples as a histogram of 0.05 ms buckets up to 100 ms, kept up to date as samples come and go,
+// so percentiles cost a walk over the buckets rather than a sort. Percentiles are accurate to a bucket; max is exact.
+class GFFN_TimingWindow {
+public:
+	static constexpr double BUCKET_MS = 0.05;
+	static constexpr std::size_t NUM_BUCKETS = 2000; // the last one holds everything from 100 ms up
+private:
+	std::vector<float> samples;
+	std::size_t next_sample = 0;
+	std::size_t num_samples = 0;
+	std::array<std::uint32_t, NUM_BUCKETS> buckets{};
+
+	static std::size_t get_bucket(double ms) {
+		std::size_t bucket = ms > 0 ? (std::size_t)(ms / BUCKET_MS) : 0;
+		return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+	}
+public:
+	explicit GFFN_TimingWindow(std::size_t window_size) : samples(window_size) {}
+
+	void add(double ms);
+	void clear();
+	// The upper edge of the bucket the percentile falls in, or the exact max if that's lower.
+	double get_percentile(double percentile) const;
+	double get_max() const;
+	GFFN_TimingPercentiles get_percentiles() const;
+	std::size_t get_num_samples() const { return num_samples; }
+	std::size_t get_window_size() const { return samples.size(); }
+};
+
+// Tail latency of frames and ticks, and a log of every hitch: a frame slower than hitch_multiple times the median of the
+// recent ones. When a frame hitches the counters for that frame go into the log with it.
+// Like memory stats, only the sim thread touches this.
+namespace frame_stats {
+
+static constexpr std::size_t SHORT_WINDOW_FRAMES = 120;  // about two seconds
+static constexpr std::size_t LONG_WINDOW_FRAMES = 3600;  // about a minute
+
+typedef struct GFFN_Hitch {
+	std::uint64_t frame;
+	double session_seconds;
+	double frame_ms;
+	double tick_ms;
+	double median_ms; // of the short window before this frame
+	std::array<std::uint32_t, GFFN_FRAME_COUNTER_END> counters;
+	std::uint32_t draw_calls;
+} GFFN_Hitch;
+
+extern std::array<std::uint32_t, GFFN_FRAME_COUNTER_END> frame_counters;
+
+inline void count(GFFN_FrameCounter counter, std::uint32_t amount = 1) {
+	frame_counters[counter] += amount;
+}
+
+const char* get_counter_name(GFFN_FrameCounter counter);
+
+// Call once a frame after everything for it is done. frame_ms is wall time since the last call, tick_ms the part of it
+// spent in GFFN_GameWorld::tick. Returns true if the frame was a hitch.
+bool end_frame(double frame_ms, double tick_ms);
+
+// Hitches are frames over multiple * the short window median, and over min_ms so a 1 ms jitter on a 0.3 ms median
+// doesn't count. Nothing is flagged until the short window is full.
+void set_hitch_threshold(double multiple, double min_ms);
+// Every hitch gets appended to filename as one JSON object per line. Returns false if it can't be opened.
+bool open_hitch_log(std::string const& filename);
+void close_hitch_log();
+
+GFFN_TimingWindow const& get_frame_window(bool long_window = false);
+GFFN_TimingWindow const& get_tick_window(bool long_window = false);
+std::uint64_t get_num_frames();
+std::uint64_t get_num_hitches();
+// Only valid if get_num_hitches() > 0.
+GFFN_Hitch const& get_last_hitch();
+
+std::string hitch_to_json(GFFN_Hitch const& hitch);
+
+} // end namespace frame_stats
+
+} // end namespace gffn
@@ -5,11 +5,12 @@
 #include <format>
 #include <map>
 #include <queue>
-#include <random>
 #include <memory>
 #include <tuple>
 #include <cmath>
 #include <array>
+#include <algorithm>
+#include <chrono>
 
 #include <SDL.h>
 #include <SDL_image.h>
@@ -21,6 +22,11 @@
 #include <gffn_animation.h>
 #include <gffn_events.h>
 #include <gffn_physics.h>
+#include <gffn_pool.h>
+#include <gffn_flow_field.h>
+#include <gffn_timer_wheel.h>
+#include <gffn_behavior.h>
+#include <gffn_snapshot.h>
 
 namespace gffn {
 
@@ -38,9 +44,13 @@ typedef struct GFFN_ObjectIDInfo {
 } GFFN_ObjectIDInfo;
 
 class GFFN_IDable {
-private: // Only this class gets to call this function because it would be very bad if two objects had the same ID.
-	static long unsigned int gen_object_id() {
+private: // Only this class gets to call these functions because it would be very bad if two objects had the same ID.
+	static long unsigned int& next_object_id() {
 		static long unsigned int object_id = 0;
+		return object_id;
+	}
+	static long unsigned int gen_object_id() {
+		long unsigned int& object_id = next_object_id();
 		if (object_id == std::numeric_limits<long unsigned int>::max()) {
 			throw GFFN_Exception(std::string("Object ID overflow"));
 		}
@@ -52,38 +62,51 @@ public:
 	static constexpr int DEFAULT_SIZE_LENGTH_OF_OBJECT = 100;
 	GFFN_IDable() : object_id(gen_object_id()) {}
 	long unsigned int get_object_id() const { return object_id; }
+
+	// For restoring world snapshots, so objects made after a rollback get the same ids they got the first time. Only safe
+	// to wind back once every object made since then is gone, which restore_snapshot makes sure of.
+	static long unsigned int get_next_object_id() { return next_object_id(); }
+	static void set_next_object_id(long unsigned int object_id) { next_object_id() = object_id; }
 };
 
 class GFFN_GameObject;
 extern std::array<std::array<std::vector<GFFN_GameObject*>, WORLD_GRID_HEIGHT>, WORLD_GRID_WIDTH> world_grid;
 
+// The textures an object is drawn with. These are only read when drawing, and lots of objects share the same pair,
+// so objects point at one shared copy instead of carrying both pointers around.
+struct GFFN_ObjectVisuals {
+	SDL_Texture* texture;
+	SDL_Texture* shadow_texture;
+
+	static const GFFN_ObjectVisuals* get(SDL_Texture* texture, SDL_Texture* shadow_texture) {
+		static std::map<std::pair<SDL_Texture*, SDL_Texture*>, GFFN_ObjectVisuals> all_visuals;
+		auto key = std::make_pair(texture, shadow_texture);
+		auto it = all_visuals.find(key);
+		if (it == all_visuals.end()) {
+			it = all_visuals.emplace(key, GFFN_ObjectVisuals{ texture, shadow_texture }).first;
+		}
+		return &it->second;
+	}
+};
+
 class GFFN_GameObject : public GFFN_IDable {
-protected:	
-	// Main variables used in rendering any object.
-	SDL_Texture* texture = nullptr;
-	void set_texture(SDL_Texture* texture) { this->texture = texture; }
-	SDL_Texture* shadow_texture = nullptr;
-	void set_shadow_texture(SDL_Texture* shadow_texture) { this->shadow_texture = shadow_texture; }
-	std::unique_ptr<SDL_Rect> render_rect;
-	void set_render_rect(SDL_Rect render_rect) { this->render_rect = std::make_unique<SDL_Rect>(render_rect); }
-	std::unique_ptr<SDL_Rect> source_rect;
-	void set_source_rect(SDL_Rect source_rect) { this->source_rect = std::make_unique<SDL_Rect>(source_rect); }
-	std::unique_ptr<SDL_Rect> shadow_render_rect;
-	void set_shadow_render_rect(SDL_Rect shadow_render_rect) { this->shadow_render_rect = std::make_unique<SDL_Rect>(shadow_render_rect); }
-	bool hidden = false;
+protected:
+	// Hot data, everything here gets touched on every tick so it's kept together at the front of the object.
+	SDL_Rect render_rect; // inline so spawning doesn't hit the heap, x and y are the top left coords
+	void set_render_rect(SDL_Rect render_rect) { this->render_rect = render_rect; }
+	std::pair<int, int> grid_location;
 	double height_offset = 0;
-
-	WorldCoordinateInt2D top_left_coords;
-	bool _to_remove = false;
 	GFFN_ObjectType object_type;
-	std::pair<int, int> grid_location;
-
-	void update_render_rect() {
-		render_rect->x = (int)top_left_coords.x;
-		render_rect->y = (int)top_left_coords.y;
-		shadow_render_rect->x = render_rect->x + render_rect->w / 2 - 50;
-		shadow_render_rect->y = render_rect->y + render_rect->h - shadow_render_rect->h;
-	}
+	bool _to_remove = false;
+	bool hidden = false;
+	bool has_source_rect = false; // no source rect means the whole texture gets drawn
+
+	// Cold data, only read when the object gets drawn.
+	const GFFN_ObjectVisuals* visuals = GFFN_ObjectVisuals::get(nullptr, nullptr);
+	void set_texture(SDL_Texture* texture) { visuals = GFFN_ObjectVisuals::get(texture, visuals->shadow_texture); }
+	void set_shadow_texture(SDL_Texture* shadow_texture) { visuals = GFFN_ObjectVisuals::get(visuals->texture, shadow_texture); }
+	SDL_Rect source_rect{};
+	void set_source_rect(SDL_Rect source_rect) { this->source_rect = source_rect; has_source_rect = true; }
 	int get_texture_width(SDL_Texture* texture) {
 		int width;
 		SDL_QueryTexture(texture, nullptr, nullptr, &width, nullptr);
@@ -102,26 +125,39 @@ protected:
 			}
 		}
 	}
-public:
-	GFFN_GameObject(GFFN_ObjectType object_type, WorldCoordinateInt2D top_left_coords, int width, int height) : top_left_coords(top_left_coords), object_type(object_type) {
-		render_rect = std::make_unique<SDL_Rect>(top_left_coords.x, top_left_coords.y, width, height);
-		shadow_render_rect = 
-			std::make_unique<SDL_Rect>(render_rect->x + render_rect->w / 2 - 50, render_rect->y + height - DEFAULT_SIZE_LENGTH_OF_OBJECT, DEFAULT_SIZE_LENGTH_OF_OBJECT, DEFAULT_SIZE_LENGTH_OF_OBJECT);
+	// Cells are kept in object id order, so what's in a cell reads the same whatever order things moved in. Projectile hits
+	// and explosions act on the first matches in a cell, and a world restored from a snapshot has to replay those the same.
+	void insert_into_grid_cell(std::pair<int, int> cell) {
+		std::vector<GFFN_GameObject*>& grid_cell = world_grid[cell.first][cell.second];
+		if (grid_cell.empty() || grid_cell.back()->get_object_id() < object_id) {
+			grid_cell.push_back(this); // nothing in there is newer, the usual case for spawns
+			return;
+		}
+		auto it = std::upper_bound(grid_cell.begin(), grid_cell.end(), object_id,
+			[](long unsigned int object_id, GFFN_GameObject* other) { return object_id < other->get_object_id(); });
+		grid_cell.insert(it, this);
 	}
-	~GFFN_GameObject() {
+public:
+	GFFN_GameObject(GFFN_ObjectType object_type, WorldCoordinateInt2D top_left_coords, int width, int height) :
+	render_rect{ top_left_coords.x, top_left_coords.y, width, height }, object_type(object_type) {}
+	virtual ~GFFN_GameObject() {
 		remove_from_curr_grid_location();
 	}
 
 	// main API used for rendering:
-	SDL_Texture* get_texture() { return texture; }
-	SDL_Texture* get_shadow_texture() { return shadow_texture; }
-	SDL_Rect* get_render_rect() { return render_rect.get(); }
-	SDL_Rect* get_source_rect() { return source_rect.get(); }
-	SDL_Rect* get_shadow_render_rect() { return shadow_render_rect.get(); }
+	SDL_Texture* get_texture() { return visuals->texture; }
+	SDL_Texture* get_shadow_texture() { return visuals->shadow_texture; }
+	SDL_Rect* get_render_rect() { return &render_rect; }
+	SDL_Rect* get_source_rect() { return has_source_rect ? &source_rect : nullptr; }
+	// The shadow always sits centered under the bottom of the render rect, so it's worked out when drawn instead of stored.
+	SDL_Rect get_shadow_render_rect() const {
+		return SDL_Rect{ render_rect.x + render_rect.w / 2 - 50, render_rect.y + render_rect.h - DEFAULT_SIZE_LENGTH_OF_OBJECT,
+			DEFAULT_SIZE_LENGTH_OF_OBJECT, DEFAULT_SIZE_LENGTH_OF_OBJECT };
+	}
 	double get_height_offset() const { return height_offset; }
 	void set_hidden(bool hidden) { this->hidden = hidden; }
 	bool get_hidden() const { return hidden; }
-	int get_y() const { return render_rect->y + render_rect->h - FLOOR_COORDS_Y_OFFSET; }
+	int get_y() const { return render_rect.y + render_rect.h - FLOOR_COORDS_Y_OFFSET; }
 
 	// API used for controlling the object:
 	bool to_remove() const { return _to_remove; }
@@ -129,20 +165,46 @@ public:
 	GFFN_ObjectType get_object_type() const { return object_type; }
 
 	// Misc useful APIs:
-	WorldCoordinateInt2D get_top_left_coords() const { return top_left_coords; }
+	WorldCoordinateInt2D get_top_left_coords() const { return WorldCoordinateInt2D(render_rect.x, render_rect.y); }
 	WorldCoordinate get_center_coords() const {
 		WorldCoordinate center_coords;
-		center_coords.x = top_left_coords.x + ((double)render_rect->w / 2);
-		center_coords.y = top_left_coords.y + ((double)render_rect->h / 2);
+		center_coords.x = render_rect.x + ((double)render_rect.w / 2);
+		center_coords.y = render_rect.y + ((double)render_rect.h / 2);
 		return center_coords;
 	}
 	void set_floor_coords(WorldCoordinate floor_coords) {
-		top_left_coords = WorldCoordinateInt2D((int)floor_coords.x - (render_rect->w / 2), (int)floor_coords.y - render_rect->h - FLOOR_COORDS_Y_OFFSET);
+		WorldCoordinateInt2D floor_pixel(floor_coords);
+		render_rect.x = floor_pixel.x - (render_rect.w / 2);
+		render_rect.y = floor_pixel.y - render_rect.h - FLOOR_COORDS_Y_OFFSET;
+	}
+
+	virtual void tick(double delta_time_seconds) {};
+
+	// World snapshots. Every class saves and restores its own fields and then calls its base class. Restoring also takes
+	// the snapshot's id, a rebuilt object gets its old id back before it goes in the world.
+	virtual void save_snapshot(GFFN_ObjectSnapshot& snapshot) const {
+		snapshot = GFFN_ObjectSnapshot(); // records get reused, nothing from the last object in this one can be left over
+		snapshot.object_id = object_id;
+		snapshot.object_type = object_type;
+		snapshot.render_rect = render_rect;
+		snapshot.source_rect = source_rect;
+		snapshot.grid_location = grid_location;
+		snapshot.height_offset = height_offset;
+		snapshot.visuals = visuals;
+		snapshot.to_remove = _to_remove;
+		snapshot.hidden = hidden;
+		snapshot.has_source_rect = has_source_rect;
+	}
+	virtual void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		object_id = snapshot.object_id;
+		render_rect = snapshot.render_rect;
+		source_rect = snapshot.source_rect;
+		height_offset = snapshot.height_offset;
+		visuals = snapshot.visuals;
+		_to_remove = snapshot.to_remove;
+		hidden = snapshot.hidden;
+		has_source_rect = snapshot.has_source_rect;
 	}
-
-	virtual void tick(double delta_time_seconds) {
-		update_render_rect();
-	};
 };
 
 class GFFN_Movable : public GFFN_GameObject {
@@ -150,7 +212,7 @@ protected:
 	physics::ObjectPhysicsController physics_controller;
 public:
 	GFFN_Movable(GFFN_ObjectType object_type, int width, int height, WorldCoordinate floor_coords, SDL_Texture* shadow_texture, double ground_coef_friction=7) :
-	GFFN_GameObject(object_type, WorldCoordinate(floor_coords.x - (width / 2), floor_coords.y - height - FLOOR_COORDS_Y_OFFSET, 0), width, height),
+	GFFN_GameObject(object_type, calculate_top_left_coords_from_floor_coords(floor_coords, width, height), width, height),
 	physics_controller(floor_coords, ground_coef_friction) {
 		// Movable objects have shadows, so init that info here:
 		set_shadow_texture(shadow_texture);
@@ -163,6 +225,9 @@ public:
 	WorldCoordinate get_floor_coords() const {
 		return physics_controller.get_floor_coords();
 	}
+	WorldCoordinatef get_floor_coordsf() const {
+		return physics_controller.get_floor_coordsf();
+	}
 	void set_ground_coef_friction(double ground_coef_friction) {
 		physics_controller.set_ground_coef_friction(ground_coef_friction);
 	}
@@ -179,7 +244,24 @@ public:
 		return physics_controller;
 	}
 
+	bool is_asleep() const {
+		return physics_controller.is_asleep();
+	}
+
+	void save_snapshot(GFFN_ObjectSnapshot& snapshot) const {
+		GFFN_GameObject::save_snapshot(snapshot);
+		snapshot.physics = physics_controller;
+	}
+	void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		GFFN_GameObject::restore_snapshot(snapshot);
+		physics_controller = snapshot.physics;
+	}
+
+	// A sleeping object didn't move, so there's nothing to update.
 	void tick(double delta_time_seconds) {
+		if (physics_controller.is_asleep()) {
+			return;
+		}
 		physics_controller.tick(delta_time_seconds);
 		height_offset = physics_controller.get_floor_coords().z;
 		WorldCoordinate floor_coords = physics_controller.get_floor_coords();
@@ -197,27 +279,68 @@ protected:
 		return loc.first == grid_location.first && loc.second == grid_location.second;
 	}
 	void update_grid_location_from_floor_coords() {
-		WorldCoordinate floor_coords = get_floor_coords();
-		int grid_x = (int)(floor_coords.x / 100.0);
-		int grid_y = (int)(floor_coords.y / 100.0);
-		if (grid_x < 0 || grid_y < 0 || grid_x >= WORLD_GRID_WIDTH || grid_y >= WORLD_GRID_HEIGHT) {
+		if (!timing_grid_updates) {
+			move_to_grid_cell_from_floor_coords();
+			return;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		move_to_grid_cell_from_floor_coords();
+		grid_update_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	void move_to_grid_cell_from_floor_coords() {
+		std::pair<int, int> cell;
+		if (!get_grid_cell(cell)) {
 			return;
 		}
-		if (!object_in_grid_location(std::make_pair(grid_x, grid_y))) {
+		if (!object_in_grid_location(cell)) {
 			// We changed grid!
 			remove_from_curr_grid_location();
-			world_grid[grid_x][grid_y].push_back(this);
-			grid_location.first = grid_x;
-			grid_location.second = grid_y;
+			insert_into_grid_cell(cell);
+			grid_location = cell;
 		}
 	}
 public:
+	// Keeping objects in the right world_grid cell happens inside their ticks, since projectiles look at their cell right
+	// after moving. The world's phase timing turns this on and takes grid_update_ms back out of the tick phases.
+	inline static bool timing_grid_updates = false;
+	inline static double grid_update_ms = 0;
+
 	GFFN_GridObject(GFFN_ObjectType object_type, int width, int height, WorldCoordinate floor_coords, SDL_Texture* shadow_texture) :
 	GFFN_Movable(object_type, width, height, floor_coords, shadow_texture) {}
+	// The world_grid cell the floor coords are in, false if they're off the grid.
+	bool get_grid_cell(std::pair<int, int>& cell) const {
+		WorldCoordinate floor_coords = get_floor_coords();
+		cell.first = (int)std::floor(floor_coords.x / 100.0);
+		cell.second = (int)std::floor(floor_coords.y / 100.0);
+		return cell.first >= 0 && cell.second >= 0 && cell.first < WORLD_GRID_WIDTH && cell.second < WORLD_GRID_HEIGHT;
+	}
+	// For new objects joining the world, so they're on the grid before their first tick. Only for objects that aren't on
+	// the grid yet, it doesn't look for an old cell to take them out of.
+	void add_to_grid() {
+		std::pair<int, int> cell;
+		if (get_grid_cell(cell)) {
+			insert_into_grid_cell(cell);
+			grid_location = cell;
+		}
+	}
 	~GFFN_GridObject() {
 		remove_from_curr_grid_location();
 	}
+	// Back in the cell it was in then, which isn't always the one its floor coords are in: sleeping objects and NPCs the
+	// simulation LOD skipped haven't moved cells yet. Objects flagged for removal might have left the grid already.
+	void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		bool was_removed = _to_remove;
+		GFFN_Movable::restore_snapshot(snapshot);
+		if (snapshot.grid_location != grid_location || was_removed) {
+			remove_from_curr_grid_location();
+			insert_into_grid_cell(snapshot.grid_location);
+			grid_location = snapshot.grid_location;
+		}
+	}
 	void tick(double delta_time_seconds) {
+		if (is_asleep()) {
+			return;
+		}
 		GFFN_Movable::tick(delta_time_seconds);
 		update_grid_location_from_floor_coords();
 	}
@@ -225,22 +348,19 @@ public:
 
 class GFFN_Character : public GFFN_GridObject {
 protected:
-	int size_width_of_character = 100;
-	int size_height_of_character = 200;
 	static constexpr int SHADOW_HEIGHT_OFFSET = 100;
 	static constexpr int SHADOW_WIDTH = 100;
 	static constexpr int SHADOW_HEIGHT = 100;
+	physics::NormalizedVector3D look_direction;
+	GFFN_Animations animations;
 	int hp;
 	bool dead = false;
-	GFFN_Animations animations;
-	physics::NormalizedVector3D look_direction;
 public:
 
 	GFFN_Character(GFFN_ObjectType object_type, SDL_Texture* animation_texture, SDL_Texture* shadow_texture,
 	int fps, WorldCoordinate floor_coords, int animation_width=25, int animation_height=50) :
-	GFFN_GridObject(object_type, animation_width*4, animation_height*4, floor_coords, shadow_texture), animations(animation_texture, fps, animation_width, animation_height), hp(100),
-	size_width_of_character(animation_width*4), size_height_of_character(animation_height*4) {
-		texture = animation_texture;
+	GFFN_GridObject(object_type, animation_width*4, animation_height*4, floor_coords, shadow_texture), animations(animation_texture, fps, animation_width, animation_height), hp(100) {
+		set_texture(animation_texture);
 		if(floor_coords.x > WORLD_GRID_WIDTH*100) {
 			set_floor_coords(WorldCoordinate(WORLD_GRID_WIDTH*100, floor_coords.y, floor_coords.z));
 		}
@@ -279,11 +399,36 @@ public:
 	}
 	void animation_tick() {
 		animations.tick();
-		set_source_rect(*animations.get_current_frame().second);
+		set_source_rect(animations.get_current_frame().second);
 	}
-	void tick(double delta_time_seconds) {
+	// Off screen the animation isn't stepped, nobody would see it.
+	void tick(double delta_time_seconds, bool on_screen = true) {
 		GFFN_GridObject::tick(delta_time_seconds);
-		animation_tick();
+		if (on_screen) {
+			animation_tick();
+		}
+	}
+
+	const GFFN_Animations& get_animations() const { return animations; }
+	void save_snapshot(GFFN_ObjectSnapshot& snapshot) const {
+		GFFN_GridObject::save_snapshot(snapshot);
+		snapshot.look_direction = look_direction;
+		snapshot.animation_sheet = animations.get_sheet();
+		snapshot.animation_fps = (short)animations.get_fps();
+		snapshot.animation_state = (short)animations.get_state();
+		snapshot.animation_frame = (short)animations.get_frame_number();
+		snapshot.hp = hp;
+		snapshot.dead = dead;
+	}
+	// The frame timer runs on the wall clock, not sim time, so it's left alone.
+	void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		GFFN_GridObject::restore_snapshot(snapshot);
+		look_direction = snapshot.look_direction;
+		animations.set_fps(snapshot.animation_fps);
+		animations.set_state(snapshot.animation_state);
+		animations.set_frame_number(snapshot.animation_frame);
+		hp = snapshot.hp;
+		dead = snapshot.dead;
 	}
 };
 
@@ -297,111 +442,164 @@ struct NPC_info {
 	int animation_height = 25;
 };
 
+// Everything in NPC_info except where to spawn. Every NPC made from the same info points at one shared archetype
+// instead of keeping its own copy.
+struct GFFN_NPCArchetype {
+	GFFN_CharacterType character_type;
+	SDL_Texture* animation_texture;
+	SDL_Texture* shadow_texture;
+	int animation_fps;
+	int animation_width;
+	int animation_height;
+
+	static const GFFN_NPCArchetype* get(NPC_info const& npc_info) {
+		typedef std::tuple<GFFN_CharacterType, SDL_Texture*, SDL_Texture*, int, int, int> archetype_key_t;
+		static std::map<archetype_key_t, GFFN_NPCArchetype> archetypes;
+		archetype_key_t key(npc_info.character_type, npc_info.animation_texture, npc_info.shadow_texture,
+			npc_info.animation_fps, npc_info.animation_width, npc_info.animation_height);
+		auto it = archetypes.find(key);
+		if (it == archetypes.end()) {
+			it = archetypes.emplace(key, GFFN_NPCArchetype{ npc_info.character_type, npc_info.animation_texture, npc_info.shadow_texture,
+				npc_info.animation_fps, npc_info.animation_width, npc_info.animation_height }).first;
+		}
+		return &it->second;
+	}
+};
+
 class GFFN_NPC : public GFFN_Character {
-	typedef enum : int {
+	typedef enum : unsigned char {
 		PATROL,
 		CHASE,
 	} NPCState;
 
-	typedef enum : int {
+	typedef enum : unsigned char {
 		WALK_FORWARD,
 		WAIT,
+		WAIT_FOR_GROUND, // done waiting, but still flying from a hit
 	} NPCPatrolState;
 
-	NPC_info npc_info;
-
+	// Hot AI state first. The patrol timing lives in patrol_behavior, which only runs when its timers fire.
 	NPCState state = PATROL;
-
 	NPCPatrolState patrol_state = WAIT;
-	double state_time_length = 0;
-	double time_in_state = 0;
+	timer_id_t patrol_timer = NO_TIMER; // what patrol_behavior is waiting on, before it so it's still here when that's destroyed
+	GFFN_Behavior patrol_behavior;
+
+	const GFFN_NPCArchetype* archetype;
+
+	static constexpr double CHASE_START_DISTANCE = 1200;
+	static constexpr double CHASE_GIVE_UP_DISTANCE = 2000;
+	static constexpr double CHASE_FORCE = 150000;
+	static constexpr double GROUND_POLL_SECONDS = 0.1;
+
+	// co_await patrol_wait(this, seconds) is behavior::wait_seconds with the timer kept in the NPC, so a snapshot can read how
+	// long is left and restoring one can put the same wait back on the wheel instead of starting the coroutine over.
+	class patrol_wait {
+		GFFN_NPC* npc;
+		double seconds;
+	public:
+		patrol_wait(GFFN_NPC* npc, double seconds) : npc(npc), seconds(seconds) {}
+		~patrol_wait() { timer_wheel.cancel(npc->patrol_timer); }
+		patrol_wait(const patrol_wait&) = delete;
+		patrol_wait& operator=(const patrol_wait&) = delete;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> waiting) {
+			npc->patrol_timer = timer_wheel.schedule_seconds(seconds, &GFFN_NPC::resume_patrol, waiting.address());
+		}
+		void await_resume() noexcept { npc->patrol_timer = NO_TIMER; }
+	};
+	static void resume_patrol(void* data) { std::coroutine_handle<>::from_address(data).resume(); }
+	// The old behavior has to be gone before the new one starts, it cancels patrol_timer on its way out.
+	void start_patrol(NPCPatrolState phase = WAIT, double first_wait_seconds = -1) {
+		patrol_behavior.reset();
+		patrol_behavior = patrol(phase, first_wait_seconds);
+	}
 
 public:
 	GFFN_NPC(NPC_info npc_info) :
 	GFFN_Character(GFFN_ObjectType::GFFN_OBJECT_TYPE_NPC, npc_info.animation_texture, npc_info.shadow_texture, npc_info.animation_fps, 
-	npc_info.floor_coords, npc_info.animation_width, npc_info.animation_height), npc_info(npc_info) {}
+	npc_info.floor_coords, npc_info.animation_width, npc_info.animation_height), archetype(GFFN_NPCArchetype::get(npc_info)) {
+		start_patrol();
+	}
 	~GFFN_NPC() {}
-	void handle_grid_interations() {
-		static constexpr double AVOID_CROWDING_CONSTANT_MULTIPLIER = 50.0;
-		static constexpr double AVOID_CROWDING_DISTANCE_SQUARED_XY = 4900;
-		static constexpr double AVOID_CROWDING_DISTANCE_XY = 70.0;
-		static constexpr double PROJECTILE_HIT_DISTANCE = 50.0;
-		WorldCoordinate my_coords = get_floor_coords();
-
-		for(int i = -1; i <= 1; i++) {
-			for (int j = -1; j <= 1; j++) {
-				if(grid_location.first + i < 0 || grid_location.first + i > WORLD_GRID_WIDTH-1) {
-					continue;
-				}
-				if (grid_location.second + j < 0 || grid_location.second + j > WORLD_GRID_HEIGHT-1) {
-					continue;
+	const GFFN_NPCArchetype* get_archetype() const { return archetype; }
+	std::size_t get_patrol_frame_size() const { return patrol_behavior.get_frame_size(); }
+	// Wait a bit, turn somewhere random, walk a bit, repeat. A restored NPC starts over in the phase it was saved in,
+	// with first_wait_seconds left of the wait it was in.
+	GFFN_Behavior patrol(NPCPatrolState phase = WAIT, double first_wait_seconds = -1) {
+		auto next_wait = [&first_wait_seconds](double seconds) {
+			return first_wait_seconds >= 0 ? std::exchange(first_wait_seconds, -1) : seconds;
+		};
+		while (true) {
+			if (phase == WAIT) {
+				patrol_state = WAIT;
+				co_await patrol_wait(this, next_wait(random::range(2.0, 3.0)));
+				phase = WAIT_FOR_GROUND;
+			}
+			if (phase == WAIT_FOR_GROUND) {
+				// Don't start walking while still flying from a hit.
+				patrol_state = WAIT_FOR_GROUND;
+				if (first_wait_seconds >= 0) {
+					co_await patrol_wait(this, next_wait(0));
 				}
-				auto& grid = world_grid[grid_location.first + i][grid_location.second + j];
-				for (GFFN_GameObject* const other_object_base : grid) {
-					GFFN_ObjectType other_object_type = other_object_base->get_object_type();
-					long unsigned int other_object_id = other_object_base->get_object_id();
-					
-					GFFN_GridObject * other_object = static_cast<GFFN_GridObject*>(other_object_base);
-					if (other_object_id != object_id && (other_object_type == GFFN_OBJECT_TYPE_CHARACTER || other_object_type == GFFN_OBJECT_TYPE_NPC)) {
-						WorldCoordinate other_coords = other_object->get_floor_coords();
-						//double distance = my_coords.distance_from(other_coords);
-						double distance_squared_xy = my_coords.distance_from_squared_xy(other_coords);
-						if (distance_squared_xy < AVOID_CROWDING_DISTANCE_SQUARED_XY) {
-							try {
-								physics::NormalizedVector3D direction_vector(other_coords, my_coords);
-								physics::Vector3D force_to_add = physics::Vector3D(direction_vector.x * 50000.0 * (AVOID_CROWDING_DISTANCE_SQUARED_XY / distance_squared_xy),
-									direction_vector.y * 50000.0 * (AVOID_CROWDING_DISTANCE_SQUARED_XY / distance_squared_xy), 0.0);
-								if(force_to_add.magnitude() > 500000.0) {
-									force_to_add = physics::Vector3D(direction_vector.x * 200000.0, direction_vector.y * 200000.0, 0.0);
-								}
-								physics_controller.add_force(force_to_add);
-							}
-							catch (std::runtime_error&) {
-								physics_controller.add_force(physics::Vector3D(1, 1, 0));
-							}
-						}
-					}
+				while (!grounded()) {
+					co_await patrol_wait(this, GROUND_POLL_SECONDS);
 				}
+				look_direction.rotate_xy(random::range(0.0, 360.0));
 			}
+			patrol_state = WALK_FORWARD;
+			co_await patrol_wait(this, next_wait(random::range(2.0, 3.0)));
+			phase = WAIT;
 		}
 	}
-	void patrol_tick(double delta_time_seconds) {
-		static std::random_device rd;
-		static std::mt19937 gen(rd());
-		static std::uniform_real_distribution<> rand_deg(0, 360);
-		static std::uniform_real_distribution<> rand_time(2, 3);
-
-		time_in_state += delta_time_seconds;
-
-		if (time_in_state > state_time_length) {
-			time_in_state = 0;
-			state_time_length = rand_time(gen);
-			if (patrol_state == WALK_FORWARD) {
-				patrol_state = WAIT;
-				//set_velocity(GFFN_Velocity(0.0, 0.0));
-			}
-			else {
-				look_direction.rotate_xy(rand_deg(gen));
-				patrol_state = WALK_FORWARD;
-			}
+	void patrol_tick() {
+		if (patrol_state == WALK_FORWARD) {
+			physics_controller.add_force(physics::Vector3D(look_direction.x * 100000.0, look_direction.y * 100000.0, 0.0));
 		}
-		else {
-			if(patrol_state == WALK_FORWARD)
-				physics_controller.add_force(physics::Vector3D(look_direction.x * 100000.0, look_direction.y * 100000.0, 0.0));
+	}
+	// Follows the shared flow field towards its goal. Returns false if there's no path from here. At the goal it stays
+	// in CHASE and just stands there, facing the way it was.
+	bool chase_tick(GFFN_FlowField const& chase_field) {
+		physics::Vector3D direction;
+		if (!chase_field.get_direction(get_floor_coords(), direction)) {
+			return false;
+		}
+		if (direction.is_zero()) {
+			return true;
 		}
+		look_direction.x = direction.x;
+		look_direction.y = direction.y;
+		look_direction.z = 0;
+		physics_controller.add_force(physics::Vector3D(direction.x * CHASE_FORCE, direction.y * CHASE_FORCE, 0.0));
+		return true;
 	}
-	void tick(double delta_time_seconds) {
-		handle_grid_interations();
-		GFFN_Character::tick(delta_time_seconds);
+	void tick(double delta_time_seconds, GFFN_FlowField const& chase_field, bool on_screen = true) {
+		// Crowd separation forces come from GFFN_CrowdSeparation, which the world runs before the objects tick.
+		GFFN_Character::tick(delta_time_seconds, on_screen);
 
 		if (dead) {
+			patrol_behavior.reset();
 			return;
 		}
 		this->animations.set_state(0);
 
+		// Path distance, not straight line, so a goblin behind a wall of trees doesn't start chasing.
+		double distance_to_goal = chase_field.get_distance_to_goal(get_floor_coords());
 		switch (state) {
 		case PATROL: {
-			patrol_tick(delta_time_seconds);
+			if (distance_to_goal >= 0 && distance_to_goal < CHASE_START_DISTANCE) {
+				state = CHASE;
+				patrol_behavior.reset();
+				break;
+			}
+			patrol_tick();
+			break;
+		}
+		case CHASE: {
+			if (distance_to_goal < 0 || distance_to_goal > CHASE_GIVE_UP_DISTANCE || !chase_tick(chase_field)) {
+				state = PATROL;
+				start_patrol();
+			}
 			break;
 		}
 		default: {
@@ -410,24 +608,79 @@ public:
 		}
 
 	}
+
+	void save_snapshot(GFFN_ObjectSnapshot& snapshot) const {
+		GFFN_Character::save_snapshot(snapshot);
+		snapshot.archetype = archetype;
+		snapshot.npc_state = state;
+		snapshot.patrol_state = patrol_state;
+		if (patrol_behavior.is_running() && timer_wheel.is_pending(patrol_timer)) {
+			snapshot.timer_ms_left = (std::uint32_t)timer_wheel.get_ms_left(patrol_timer);
+			snapshot.timer_sequence = timer_wheel.get_sequence(patrol_timer);
+		}
+	}
+	// The coroutine itself can't be copied. If the running one is waiting in the same phase it only needs its wait put
+	// back on the wheel (every wait in a phase carries on the same way), otherwise patrolling starts over from the saved
+	// phase and time left. Either way the wait keeps its old place in the firing order. The timer wheel has to be reset to
+	// the snapshot's time before this.
+	void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		bool same_phase = patrol_behavior.is_running() && patrol_state == (NPCPatrolState)snapshot.patrol_state;
+		GFFN_Character::restore_snapshot(snapshot);
+		archetype = snapshot.archetype;
+		state = (NPCState)snapshot.npc_state;
+		patrol_state = (NPCPatrolState)snapshot.patrol_state;
+		if (snapshot.timer_ms_left == GFFN_ObjectSnapshot::NO_TIMER_MS) {
+			patrol_behavior.reset();
+		}
+		else if (same_phase) {
+			patrol_timer = timer_wheel.schedule(snapshot.timer_ms_left, &GFFN_NPC::resume_patrol, patrol_behavior.get_address());
+		}
+		else {
+			start_patrol(patrol_state, snapshot.timer_ms_left / 1000.0);
+		}
+		timer_wheel.set_sequence(patrol_timer, snapshot.timer_sequence);
+	}
 };
 
 class GFFN_StraightProjectile : public GFFN_GridObject {
-	double life_time_seconds;
-	double time_alive = 0;
 	physics::Vector3D propulsion_force;
-	WorldCoordinate dest_coords;
+	timer_id_t life_timer = NO_TIMER; // explodes (if explosive) and removes it when it runs out
+	// Explosive projectiles push an ExplosionEvent where they hit or run out of time. A radius of 0 isn't explosive.
+	int explosion_power = 0;
+	int explosion_min_damage = 0;
+	int explosion_blast_radius = 0;
+
+	void explode(WorldCoordinate coords) {
+		if (explosion_blast_radius <= 0) {
+			return;
+		}
+		events::ExplosionEvent explosion_event{ coords, explosion_power, explosion_blast_radius, explosion_min_damage, {} };
+		events::event_bus.push(explosion_event);
+	}
+	static void expire(void* data) {
+		GFFN_StraightProjectile* projectile = static_cast<GFFN_StraightProjectile*>(data);
+		projectile->life_timer = NO_TIMER;
+		if (projectile->to_remove()) {
+			return;
+		}
+		projectile->explode(projectile->get_floor_coords());
+		projectile->remove();
+	}
 public:
 	static constexpr int SIZE_LENGTH_OF_OBJECT = 100;
 	GFFN_StraightProjectile(WorldCoordinate start_coords, physics::NormalizedVector3D direction_vector, double propulsion_force_magnitude,
 		double life_time_seconds, SDL_Texture* texture, SDL_Texture* shadow_texture) :
-		GFFN_GridObject(GFFN_ObjectType::GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE, SIZE_LENGTH_OF_OBJECT, SIZE_LENGTH_OF_OBJECT, start_coords, shadow_texture), life_time_seconds(life_time_seconds) {
+		GFFN_GridObject(GFFN_ObjectType::GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE, SIZE_LENGTH_OF_OBJECT, SIZE_LENGTH_OF_OBJECT, start_coords, shadow_texture) {
 		physics::Vector3D initial_velocity(direction_vector.x * propulsion_force_magnitude * 0.3, direction_vector.y * propulsion_force_magnitude * 0.3, -propulsion_force_magnitude);
 		physics_controller.set_velocity(initial_velocity);
 		propulsion_force = physics::Vector3D(direction_vector.x * propulsion_force_magnitude, direction_vector.y * propulsion_force_magnitude, 0.0);
 		set_ground_coef_friction(0.5);
 		physics_controller.set_mass(10);
 		set_texture(texture);
+		life_timer = timer_wheel.schedule_seconds(life_time_seconds, &GFFN_StraightProjectile::expire, this);
+	}
+	~GFFN_StraightProjectile() {
+		timer_wheel.cancel(life_timer);
 	}
 	void tick(double delta_time_seconds) {
 		WorldCoordinate floor_coords = get_floor_coords();
@@ -437,44 +690,73 @@ public:
 		physics_controller.add_force(propulsion_force);
 
 		GFFN_GridObject::tick(delta_time_seconds);
-		time_alive += delta_time_seconds;
-		if (time_alive > life_time_seconds) {
-			remove();
-		}
-		else {
-			for (auto it = world_grid[grid_location.first][grid_location.second].begin(); it != world_grid[grid_location.first][grid_location.second].end(); it++) {
-				if ((*it)->get_object_type() == GFFN_OBJECT_TYPE_NPC) {
-					GFFN_Character* character = static_cast<GFFN_Character*>(*it);
-					WorldCoordinate character_coords = character->get_floor_coords();
-					character_coords.z += (double)character->get_render_rect()->h / 2;
-					double distance = floor_coords.distance_from(character_coords);
-					if (distance < 50) {
-						events::ProjectileHitEvent projectile_hit_event(this, character);
-						events::event_queue.push(projectile_hit_event);
-						remove_from_curr_grid_location();
-						character->change_hp(get_damage() * -1);
-						character->get_physics_controller().transfer_momentum((this->get_physics_controller()));
-						remove();
-						break;
-					}
+		for (auto it = world_grid[grid_location.first][grid_location.second].begin(); it != world_grid[grid_location.first][grid_location.second].end(); it++) {
+			if ((*it)->get_object_type() == GFFN_OBJECT_TYPE_NPC) {
+				GFFN_Character* character = static_cast<GFFN_Character*>(*it);
+				WorldCoordinate character_coords = character->get_floor_coords();
+				character_coords.z += (double)character->get_render_rect()->h / 2;
+				double distance = floor_coords.distance_from(character_coords);
+				if (distance < 50) {
+					// The damage is applied by the world when the hits get handled, all hits on one target at once.
+					events::ProjectileHitEvent projectile_hit_event{ get_object_id(), character->get_object_id(),
+						character->get_object_type(), get_damage(), 1, get_velocity_direction() };
+					events::event_bus.push(projectile_hit_event);
+					explode(floor_coords);
+					timer_wheel.cancel(life_timer);
+					remove_from_curr_grid_location();
+					character->get_physics_controller().transfer_momentum((this->get_physics_controller()));
+					remove();
+					break;
 				}
 			}
 		}
 	}
+	void set_explosive(int power, int blast_radius, int min_damage) {
+		explosion_power = power;
+		explosion_blast_radius = blast_radius;
+		explosion_min_damage = min_damage;
+	}
+	bool is_explosive() const { return explosion_blast_radius > 0; }
 	int get_damage() {
 		return 34; // temp
 	}
+
+	void save_snapshot(GFFN_ObjectSnapshot& snapshot) const {
+		GFFN_GridObject::save_snapshot(snapshot);
+		snapshot.propulsion_force = propulsion_force;
+		snapshot.explosion_power = explosion_power;
+		snapshot.explosion_min_damage = explosion_min_damage;
+		snapshot.explosion_blast_radius = explosion_blast_radius;
+		if (timer_wheel.is_pending(life_timer)) {
+			snapshot.timer_ms_left = (std::uint32_t)timer_wheel.get_ms_left(life_timer);
+			snapshot.timer_sequence = timer_wheel.get_sequence(life_timer);
+		}
+	}
+	// The timer wheel has to be reset to the snapshot's time before this.
+	void restore_snapshot(GFFN_ObjectSnapshot const& snapshot) {
+		GFFN_GridObject::restore_snapshot(snapshot);
+		propulsion_force = snapshot.propulsion_force;
+		explosion_power = snapshot.explosion_power;
+		explosion_min_damage = snapshot.explosion_min_damage;
+		explosion_blast_radius = snapshot.explosion_blast_radius;
+		timer_wheel.cancel(life_timer);
+		life_timer = NO_TIMER;
+		if (snapshot.timer_ms_left != GFFN_ObjectSnapshot::NO_TIMER_MS) {
+			life_timer = timer_wheel.schedule(snapshot.timer_ms_left, &GFFN_StraightProjectile::expire, this);
+			timer_wheel.set_sequence(life_timer, snapshot.timer_sequence);
+		}
+	}
 };
 
 class GFFN_UIObject : public GFFN_GameObject {
 	static constexpr int SIZE_LENGTH_OF_OBJECT = 100;
 public:
 	GFFN_UIObject(SDL_Renderer* renderer, SDL_Texture* texture, WorldCoordinate top_left_coords) :
-	GFFN_GameObject(GFFN_ObjectType::GFFN_OBJECT_TYPE_UI_OBJECT, top_left_coords, SIZE_LENGTH_OF_OBJECT, SIZE_LENGTH_OF_OBJECT) {
+	GFFN_GameObject(GFFN_ObjectType::GFFN_OBJECT_TYPE_UI_OBJECT, WorldCoordinateInt2D(top_left_coords), SIZE_LENGTH_OF_OBJECT, SIZE_LENGTH_OF_OBJECT) {
 		set_texture(texture);
 	}
 	~GFFN_UIObject() {}
-	SDL_Texture* get_texture() { return texture; }
+	SDL_Texture* get_texture() { return visuals->texture; }
 	void tick(double delta_time_seconds) {}
 };
 
@@ -515,4 +797,24 @@ public:
 
 typedef std::vector<std::pair<int, std::unique_ptr<GFFN_GameObject>>> VectorOfObjectsByY;
 
+// Game objects are owned through these. Objects made with make_pooled_object come out of a per-type pool and go back
+// to it when the pointer dies, so spawning and despawning doesn't touch the general heap once the pools are warm.
+typedef GFFN_PoolDeleter<GFFN_GameObject> GFFN_ObjectDeleter;
+typedef std::unique_ptr<GFFN_GameObject, GFFN_ObjectDeleter> GFFN_ObjectPtr;
+template <class T>
+using GFFN_PooledPtr = std::unique_ptr<T, GFFN_ObjectDeleter>;
+
+template <class T, class... Args>
+GFFN_PooledPtr<T> make_pooled_object(Args&&... args) {
+	return make_pooled<T, GFFN_GameObject>(std::forward<Args>(args)...);
+}
+
+// Size budget for the objects that get spawned by the thousands, so a 100k NPC world stays around 25MB of objects.
+// Textures and archetype data go in the shared flyweights above, not in here. get_pool<T>() makes its blocks
+// sizeof(T), so this is also the pool block size. GFFN_NPC is 224 bytes, 32 under budget.
+static constexpr std::size_t NPC_SIZE_BUDGET_BYTES = 256;
+static constexpr std::size_t PROJECTILE_SIZE_BUDGET_BYTES = 256;
+static_assert(sizeof(GFFN_NPC) <= NPC_SIZE_BUDGET_BYTES, "GFFN_NPC is over its 256 byte pool block budget");
+static_assert(sizeof(GFFN_StraightProjectile) <= PROJECTILE_SIZE_BUDGET_BYTES, "GFFN_StraightProjectile is over its size budget");
+
 } // end namespace gffn
\ No newline at end of file
@@ -8,19 +8,61 @@
 #include <gffn_utils.h>
 #include <gffn_renderer.h>
 #include <gffn_events.h>
+#include <gffn_frame_arena.h>
 #include <gffn_game_world_objects.h>
+#include <gffn_memory.h>
+#include <gffn_particles.h>
+#include <gffn_explosions.h>
+#include <gffn_crowd.h>
+#include <gffn_flow_field.h>
+#include <gffn_simulation_lod.h>
+#include <gffn_timer_wheel.h>
+#include <gffn_profiler.h>
+#include <gffn_overlay.h>
+#include <gffn_render_stats.h>
+#include <gffn_frame_stats.h>
+#include <gffn_level.h>
+#include <gffn_snapshot.h>
 
 #include <string>
 
 #include <vector>
 #include <map>
 #include <queue>
-#include <random>
 #include <array>
 #include <algorithm>
+#include <chrono>
+#include <span>
 
 namespace gffn {
 
+// Where a tick's time goes, for GFFN_GameWorld's phase timing.
+typedef enum : std::uint8_t {
+	GFFN_TICK_PHASE_AI,          // timers and behaviors, the flow field, crowd separation, NPC ticks
+	GFFN_TICK_PHASE_PHYSICS,     // the camera, the player, projectiles and body parts
+	GFFN_TICK_PHASE_GRID,        // moving objects between world_grid cells, measured inside their ticks
+	GFFN_TICK_PHASE_EVENTS,      // dispatching events, which is where hits, explosions and dismemberment happen
+	GFFN_TICK_PHASE_PARTICLES,
+	GFFN_TICK_PHASE_RENDER_PREP, // culling, sorting and submitting what's in the viewport, baking decals
+	GFFN_TICK_PHASE_CLEANUP,     // removing dead objects, resetting the frame arena, memory stats
+	GFFN_TICK_PHASE_PRESENT,     // the performance overlay and presenting the frame
+	GFFN_TICK_PHASE_END
+} GFFN_TickPhase;
+
+inline const char* get_tick_phase_name(GFFN_TickPhase phase) {
+	switch (phase) {
+	case GFFN_TICK_PHASE_AI: return "ai";
+	case GFFN_TICK_PHASE_PHYSICS: return "physics";
+	case GFFN_TICK_PHASE_GRID: return "grid";
+	case GFFN_TICK_PHASE_EVENTS: return "events";
+	case GFFN_TICK_PHASE_PARTICLES: return "particles";
+	case GFFN_TICK_PHASE_RENDER_PREP: return "render_prep";
+	case GFFN_TICK_PHASE_CLEANUP: return "cleanup";
+	case GFFN_TICK_PHASE_PRESENT: return "present";
+	default: return "unknown";
+	}
+}
+
 class GFFN_GameWorld {
 public:
 	int num_characters = 0;
@@ -29,16 +71,74 @@ public:
 	int num_dismembered_body_parts = 0;
 	int num_environmental_objects = 0;
 	int num_straight_projectiles = 0;
-
+	// Everything with physics, counted at the start of the last tick.
+	int num_awake_objects = 0;
+	int num_asleep_objects = 0;
 
 	GFFN_Renderer& renderer;
 	GFFN_Camera camera;
 	GameWorldObjects game_world_objects;
+	particles::ParticleSystem particle_system;
+	GFFN_ExplosionSystem explosion_system;
+	GFFN_CrowdSeparation crowd_separation;
+	GFFN_SimulationLOD simulation_lod;
+	// Every NPC in CHASE follows this one field towards chase_target_id.
+	GFFN_FlowField chase_field;
+	long unsigned int chase_target_id = 0;
+	bool has_chase_target = false;
+	SDL_Texture* particle_texture;
+
+	events::handler_id_t projectile_hit_handler_id;
+	events::handler_id_t explosion_handler_id;
+
+	// Off by default, it reads the clock once per object. The benchmarks turn it on, and so does the overlay.
+	bool phase_timing = false;
+	std::array<double, GFFN_TICK_PHASE_END> last_tick_phase_ms{};
+	double previous_present_ms = 0; // the overlay is drawn before this tick's present, it shows the one before
+	std::chrono::steady_clock::time_point phase_start;
+
+	GFFN_DebugOverlay performance_overlay;
+	bool show_performance_overlay = false;
+
+	bool is_timing_phases() const { return phase_timing || show_performance_overlay; }
+	void begin_phase_timing() {
+		GFFN_GridObject::timing_grid_updates = is_timing_phases();
+		GFFN_GridObject::grid_update_ms = 0;
+		if (is_timing_phases()) {
+			previous_present_ms = last_tick_phase_ms[GFFN_TICK_PHASE_PRESENT];
+			last_tick_phase_ms.fill(0);
+			phase_start = std::chrono::steady_clock::now();
+		}
+	}
+	// Everything since the last call goes to phase, except for grid updates, which go to their own phase.
+	void end_phase(GFFN_TickPhase phase) {
+		if (is_timing_phases()) {
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			double grid_ms = GFFN_GridObject::grid_update_ms;
+			GFFN_GridObject::grid_update_ms = 0;
+			last_tick_phase_ms[phase] += std::chrono::duration<double, std::milli>(now - phase_start).count() - grid_ms;
+			last_tick_phase_ms[GFFN_TICK_PHASE_GRID] += grid_ms;
+			phase_start = now;
+		}
+	}
 
-	GFFN_GameWorld(GFFN_Renderer &renderer) : renderer(renderer), camera(GFFN_Camera(renderer.get_sdl_renderer())) {}
-	~GFFN_GameWorld() {}
+	GFFN_GameWorld(GFFN_Renderer &renderer) : renderer(renderer), camera(GFFN_Camera(renderer.get_sdl_renderer(), renderer.is_headless())),
+	particle_texture(renderer.get_texture("textures/explosion_particle.png")), performance_overlay(renderer.get_sdl_renderer()) {
+		events::event_bus.get_channel<events::ProjectileHitEvent>().set_coalescing(true);
+		projectile_hit_handler_id = events::event_bus.subscribe<events::ProjectileHitEvent>(
+			[this](std::span<const events::ProjectileHitEvent> hits) { handle_projectile_hits(hits); });
+		explosion_handler_id = events::event_bus.subscribe<events::ExplosionEvent>(
+			[this](std::span<events::ExplosionEvent> explosions) { handle_explosions(explosions); });
+	}
+	~GFFN_GameWorld() {
+		events::event_bus.unsubscribe<events::ProjectileHitEvent>(projectile_hit_handler_id);
+		events::event_bus.unsubscribe<events::ExplosionEvent>(explosion_handler_id);
+	}
+	// The handlers hold on to this.
+	GFFN_GameWorld(const GFFN_GameWorld&) = delete;
+	GFFN_GameWorld& operator=(const GFFN_GameWorld&) = delete;
 
-	long unsigned int add_object(std::unique_ptr<GFFN_GameObject> &object) {
+	long unsigned int add_object(GFFN_ObjectPtr &object) {
 		if (object->get_object_type() == GFFN_OBJECT_TYPE_CHARACTER) {
 			num_characters++;
 		}
@@ -53,6 +153,7 @@ public:
 		}
 		else if (object->get_object_type() == GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT) {
 			num_environmental_objects++;
+			chase_field.add_blocker(static_cast<GFFN_Movable*>(object.get())->get_floor_coords());
 		}
 		else if (object->get_object_type() == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
 			num_straight_projectiles++;
@@ -61,41 +162,355 @@ public:
 			throw GFFN_Exception(std::string("Unknown object type passed into add_object for GFFN_GameWorld"));
 		}
 
+		// On the grid right away instead of on their first tick. Far NPCs and body parts only tick every few frames under
+		// the simulation LOD, and until they're on the grid explosions and projectiles can't hit them and they don't get
+		// drawn. Environmental objects put themselves on the grid when they're built.
+		GFFN_ObjectType object_type = object->get_object_type();
+		if (object_type == GFFN_OBJECT_TYPE_CHARACTER || object_type == GFFN_OBJECT_TYPE_NPC
+			|| object_type == GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART || object_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
+			static_cast<GFFN_GridObject*>(object.get())->add_to_grid();
+		}
+
 		long unsigned int object_id = object->get_object_id();
 		game_world_objects.add_object(std::move(object));
+		frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_SPAWNED);
 		return object_id;
 	}
 
 	void remove_object(long unsigned int object_id) {
-		if (!game_world_objects.object_exists(object_id)) {
+		GFFN_GameObject* const object = game_world_objects.find_object(object_id);
+		if (object == nullptr) {
 			return;
 		}
-		GFFN_GameObject* const object = game_world_objects.get_object(object_id);
-		if (object->get_object_id() == object_id) {
-			GFFN_ObjectType object_type = object->get_object_type();
-			if (object_type == GFFN_OBJECT_TYPE_CHARACTER) {
-				num_characters--;
+		count_removal(object);
+		game_world_objects.remove_object(object_id);
+		frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_REMOVED);
+	}
+
+	// Drops everything flagged with remove() in one pass over the tick order. Runs once a tick after the events, so
+	// whatever died or expired this tick is gone before anything gets drawn, however many there were.
+	void remove_flagged_objects() {
+		GFFN_PROFILE_SCOPE("remove_flagged_objects");
+		std::size_t num_removed = game_world_objects.remove_objects_if([this](GFFN_GameObject* object) {
+			if (!object->to_remove()) {
+				return false;
+			}
+			count_removal(object);
+			return true;
+		});
+		frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_REMOVED, (std::uint32_t)num_removed);
+	}
+
+	// The counts and the chase field's blockers for an object that's about to go.
+	void count_removal(GFFN_GameObject* const object) {
+		GFFN_ObjectType object_type = object->get_object_type();
+		if (object_type == GFFN_OBJECT_TYPE_CHARACTER) {
+			num_characters--;
+		}
+		else if (object_type == GFFN_OBJECT_TYPE_NPC) {
+			num_npcs--;
+		}
+		else if (object_type == GFFN_OBJECT_TYPE_UI_OBJECT) {
+			num_ui_objects--;
+		}
+		else if (object_type == GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART) {
+			num_dismembered_body_parts--;
+		}
+		else if (object_type == GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT) {
+			num_environmental_objects--;
+			chase_field.remove_blocker(static_cast<GFFN_Movable*>(object)->get_floor_coords());
+		}
+		else if (object_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
+			num_straight_projectiles--;
+		}
+		else {
+			throw GFFN_Exception(std::string("Unknown object type passed into remove_object for GFFN_GameWorld"));
+		}
+	}
+
+	// Adds everything in level to the world. Records come sorted by cell, so each world_grid cell grows once and is
+	// filled in one run, and each texture is looked up once for the whole level instead of once per object.
+	// Returns the number of objects added.
+	std::size_t load_level(GFFN_Level const& level) {
+		GFFN_PROFILE_SCOPE("load_level");
+		std::vector<SDL_Texture*> textures(level.get_num_textures());
+		for (std::size_t i = 0; i < textures.size(); i++) {
+			textures[i] = renderer.get_texture(std::string(level.get_texture_path((std::uint16_t)i)));
+		}
+		auto get_level_texture = [&textures](std::uint16_t texture) -> SDL_Texture* {
+			return texture == LEVEL_NO_TEXTURE ? nullptr : textures[texture];
+		};
+
+		std::vector<GFFN_GroundTile> ground_tiles;
+		ground_tiles.reserve(level.get_ground_tiles().size());
+		for (GFFN_LevelGroundTile const& tile : level.get_ground_tiles()) {
+			ground_tiles.push_back(GFFN_GroundTile{ textures[tile.texture], tile.cell_x, tile.cell_y });
+		}
+		renderer.paint_ground_tiles(ground_tiles);
+
+		std::span<const GFFN_LevelStaticObject> static_objects = level.get_static_objects();
+		std::span<const GFFN_LevelNPC> npcs = level.get_npcs();
+		std::span<const GFFN_LevelCell> cells = level.get_cells();
+		game_world_objects.reserve(level.get_num_objects());
+		for (std::size_t cell_index = 0; cell_index < cells.size(); cell_index++) {
+			GFFN_LevelCell const& cell = cells[cell_index];
+			if (cell.num_static_objects == 0 && cell.num_npcs == 0) {
+				continue;
+			}
+			// Environmental objects put themselves on the grid, NPCs are put there right after, so the cell only grows once.
+			std::vector<GFFN_GameObject*>& grid_cell = world_grid[cell_index / WORLD_GRID_HEIGHT][cell_index % WORLD_GRID_HEIGHT];
+			grid_cell.reserve(grid_cell.size() + cell.num_static_objects + cell.num_npcs);
+			for (GFFN_LevelStaticObject const& record : static_objects.subspan(cell.first_static_object, cell.num_static_objects)) {
+				WorldCoordinate floor_coords(record.x, record.y, 0);
+				game_world_objects.add_object(make_pooled_object<GFFN_EnvironmentalObject>(floor_coords,
+					textures[record.texture], get_level_texture(record.shadow_texture)));
+				chase_field.add_blocker(floor_coords);
 			}
-			else if (object_type == GFFN_OBJECT_TYPE_NPC) {
-				num_npcs--;
+			for (GFFN_LevelNPC const& record : npcs.subspan(cell.first_npc, cell.num_npcs)) {
+				NPC_info npc_info;
+				npc_info.character_type = (GFFN_CharacterType)record.character_type;
+				npc_info.floor_coords = WorldCoordinate(record.x, record.y, 0);
+				npc_info.animation_texture = textures[record.animation_texture];
+				npc_info.shadow_texture = get_level_texture(record.shadow_texture);
+				npc_info.animation_fps = record.animation_fps;
+				npc_info.animation_width = record.animation_width;
+				npc_info.animation_height = record.animation_height;
+				GFFN_PooledPtr<GFFN_NPC> npc = make_pooled_object<GFFN_NPC>(npc_info);
+				npc->add_to_grid();
+				game_world_objects.add_object(std::move(npc));
 			}
-			else if (object_type == GFFN_OBJECT_TYPE_UI_OBJECT) {
-				num_ui_objects--;
+		}
+		num_environmental_objects += (int)static_objects.size();
+		num_npcs += (int)npcs.size();
+		frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_SPAWNED, (std::uint32_t)level.get_num_objects());
+		return level.get_num_objects();
+	}
+
+	// Spawns an NPC made from npc_info at each of positions, npc_info.floor_coords is ignored. Storage is sized once for
+	// the whole batch: the NPCs are built back to back in one run of pool blocks in world_grid cell order, and every cell
+	// they land in grows once and gets them all in one go, instead of each NPC joining the grid on its first tick.
+	// ids, if given, gets the new object ids appended in the same order as positions.
+	std::size_t spawn_npcs(NPC_info const& npc_info, std::span<const WorldCoordinate> positions, std::vector<long unsigned int>* ids = nullptr) {
+		GFFN_PROFILE_SCOPE("spawn_npcs");
+		static constexpr std::size_t NUM_CELLS = (std::size_t)WORLD_GRID_WIDTH * WORLD_GRID_HEIGHT;
+		if (positions.empty()) {
+			return 0;
+		}
+
+		// Counting sort by cell, with one more bucket at the end for anything off the grid. Same rounding as
+		// GFFN_GridObject::get_grid_cell.
+		frame_vector<std::uint32_t> cell_starts(NUM_CELLS + 2, 0);
+		frame_vector<std::uint32_t> cells(positions.size());
+		for (std::size_t i = 0; i < positions.size(); i++) {
+			int cell_x = (int)(positions[i].x / 100.0);
+			int cell_y = (int)(positions[i].y / 100.0);
+			bool on_grid = cell_x >= 0 && cell_y >= 0 && cell_x < WORLD_GRID_WIDTH && cell_y < WORLD_GRID_HEIGHT;
+			cells[i] = on_grid ? (std::uint32_t)(cell_x * WORLD_GRID_HEIGHT + cell_y) : (std::uint32_t)NUM_CELLS;
+			cell_starts[cells[i] + 1]++;
+		}
+		for (std::size_t cell = 0; cell < NUM_CELLS; cell++) {
+			std::uint32_t num_in_cell = cell_starts[cell + 1];
+			if (num_in_cell > 0) {
+				std::vector<GFFN_GameObject*>& grid_cell = world_grid[cell / WORLD_GRID_HEIGHT][cell % WORLD_GRID_HEIGHT];
+				grid_cell.reserve(grid_cell.size() + num_in_cell);
 			}
-			else if (object_type == GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART) {
-				num_dismembered_body_parts--;
+			cell_starts[cell + 1] += cell_starts[cell];
+		}
+		frame_vector<std::uint32_t> order(positions.size());
+		for (std::size_t i = 0; i < positions.size(); i++) {
+			order[cell_starts[cells[i]]++] = (std::uint32_t)i;
+		}
+
+		GFFN_FixedPool& pool = get_pool<GFFN_NPC>();
+		char* blocks = pool.allocate_contiguous(positions.size());
+		game_world_objects.reserve(positions.size());
+		timer_wheel.reserve(positions.size());
+		std::size_t first_id = 0;
+		if (ids != nullptr) {
+			first_id = ids->size();
+			ids->resize(first_id + positions.size());
+		}
+		// A block belongs to its GFFN_ObjectPtr as soon as the NPC in it is built, and that gives it back to the pool if
+		// the NPC doesn't make it into the world. Only the blocks from num_built on are still the batch's to give back.
+		std::size_t num_built = 0;
+		std::size_t num_added = 0;
+		try {
+			for (; num_added < positions.size(); num_added++) {
+				std::uint32_t i = order[num_added];
+				NPC_info info = npc_info;
+				info.floor_coords = positions[i];
+				GFFN_NPC* npc = new (blocks + num_added * pool.get_block_size()) GFFN_NPC(info);
+				GFFN_ObjectPtr object(npc, GFFN_ObjectDeleter(&destroy_pooled<GFFN_NPC, GFFN_GameObject>));
+				num_built++;
+				if (num_built == 1) {
+					// The first patrol shows how big the rest of the frames are.
+					reserve_behavior_frames(npc->get_patrol_frame_size(), positions.size() - 1);
+				}
+				npc->add_to_grid();
+				if (ids != nullptr) {
+					(*ids)[first_id + i] = npc->get_object_id();
+				}
+				game_world_objects.add_object(std::move(object));
 			}
-			else if (object_type == GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT) {
-				num_environmental_objects--;
+		}
+		catch (...) {
+			// The NPCs already added stay in the world.
+			for (std::size_t j = num_built; j < positions.size(); j++) {
+				pool.deallocate(blocks + j * pool.get_block_size());
 			}
-			else if (object_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
-				num_straight_projectiles--;
+			num_npcs += (int)num_added;
+			frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_SPAWNED, (std::uint32_t)num_added);
+			throw;
+		}
+		num_npcs += (int)positions.size();
+		frame_stats::count(GFFN_FRAME_COUNTER_OBJECTS_SPAWNED, (std::uint32_t)positions.size());
+		return positions.size();
+	}
+
+	// NPCs close enough (by path) to this object start chasing it.
+	void set_chase_target(long unsigned int object_id) {
+		chase_target_id = object_id;
+		has_chase_target = true;
+	}
+
+	// Writes the whole sim into snapshot, see GFFN_WorldSnapshot for what that covers. Call it between ticks.
+	void capture_snapshot(GFFN_WorldSnapshot& snapshot) {
+		GFFN_PROFILE_SCOPE("capture_snapshot");
+		snapshot.objects.resize(game_world_objects.size());
+		GFFN_ObjectSnapshot* record = snapshot.objects.data();
+		for (GFFN_GameObject* object : game_world_objects) {
+			object->save_snapshot(*record++);
+		}
+		snapshot.timer_elapsed_seconds = timer_wheel.get_elapsed_seconds();
+		snapshot.timer_next_sequence = timer_wheel.get_next_sequence();
+		snapshot.rng = random::get_thread_rng();
+		snapshot.next_object_id = GFFN_IDable::get_next_object_id();
+		snapshot.chase_target_id = chase_target_id;
+		snapshot.has_chase_target = has_chase_target;
+		snapshot.chase_field = chase_field;
+		snapshot.simulation_lod = simulation_lod;
+		snapshot.num_characters = num_characters;
+		snapshot.num_npcs = num_npcs;
+		snapshot.num_ui_objects = num_ui_objects;
+		snapshot.num_dismembered_body_parts = num_dismembered_body_parts;
+		snapshot.num_environmental_objects = num_environmental_objects;
+		snapshot.num_straight_projectiles = num_straight_projectiles;
+	}
+
+	// Puts the sim back the way it was when snapshot was captured. Objects that are still around are patched in place,
+	// ones that died since are rebuilt with their old ids and ones spawned since are destroyed. Pointers to objects that
+	// were rebuilt or destroyed are dead afterwards, look them up again by id. Call it between ticks.
+	void restore_snapshot(GFFN_WorldSnapshot const& snapshot) {
+		GFFN_PROFILE_SCOPE("restore_snapshot");
+		// Objects keep their order in the world until they're removed and new ones go on the end, so walking the tick
+		// order alongside the records finds nearly everything without a map lookup. Only objects that died since (or
+		// anything out of order) get looked up. The same id with another type is a different object from another branch.
+		frame_vector<GFFN_GameObject*> objects(snapshot.objects.size());
+		std::size_t num_still_around = 0;
+		auto next_in_order = game_world_objects.begin();
+		for (std::size_t i = 0; i < snapshot.objects.size(); i++) {
+			GFFN_ObjectSnapshot const& record = snapshot.objects[i];
+			GFFN_GameObject* object;
+			if (next_in_order != game_world_objects.end() && (*next_in_order)->get_object_id() == record.object_id) {
+				object = *next_in_order++;
 			}
 			else {
-				throw GFFN_Exception(std::string("Unknown object type passed into add_object for GFFN_GameWorld"));
+				object = game_world_objects.find_object(record.object_id);
+			}
+			if (object != nullptr && object->get_object_type() == record.object_type) {
+				objects[i] = object;
+				num_still_around++;
 			}
 		}
-		game_world_objects.remove_object(object_id);
+		// Everything spawned since has to go before ids and timers are wound back.
+		if (num_still_around != game_world_objects.size()) {
+			frame_vector<GFFN_GameObject*> still_around;
+			still_around.reserve(num_still_around);
+			for (GFFN_GameObject* object : objects) {
+				if (object != nullptr) {
+					still_around.push_back(object);
+				}
+			}
+			std::sort(still_around.begin(), still_around.end());
+			frame_vector<long unsigned int> spawned_since;
+			for (GFFN_GameObject* object : game_world_objects) {
+				if (!std::binary_search(still_around.begin(), still_around.end(), object)) {
+					spawned_since.push_back(object->get_object_id());
+				}
+			}
+			for (long unsigned int object_id : spawned_since) {
+				game_world_objects.erase_object(object_id);
+			}
+		}
+
+		timer_wheel.reset(snapshot.timer_elapsed_seconds, snapshot.timer_next_sequence);
+		for (std::size_t i = 0; i < snapshot.objects.size(); i++) {
+			GFFN_ObjectSnapshot const& record = snapshot.objects[i];
+			if (objects[i] != nullptr) {
+				objects[i]->restore_snapshot(record);
+				continue;
+			}
+			GFFN_ObjectPtr object = rebuild_object(record);
+			object->restore_snapshot(record);
+			objects[i] = object.get();
+			game_world_objects.add_object(std::move(object));
+		}
+		game_world_objects.set_order(objects);
+
+		// Last, rebuilding objects draws random numbers and ids.
+		random::get_thread_rng() = snapshot.rng;
+		GFFN_IDable::set_next_object_id(snapshot.next_object_id);
+		chase_target_id = snapshot.chase_target_id;
+		has_chase_target = snapshot.has_chase_target;
+		chase_field = snapshot.chase_field;
+		simulation_lod = snapshot.simulation_lod;
+		num_characters = snapshot.num_characters;
+		num_npcs = snapshot.num_npcs;
+		num_ui_objects = snapshot.num_ui_objects;
+		num_dismembered_body_parts = snapshot.num_dismembered_body_parts;
+		num_environmental_objects = snapshot.num_environmental_objects;
+		num_straight_projectiles = snapshot.num_straight_projectiles;
+	}
+
+	// A stand-in of the record's type for restore_snapshot to fill in. Where it starts and how it's moving don't matter,
+	// restoring overwrites all of that.
+	GFFN_ObjectPtr rebuild_object(GFFN_ObjectSnapshot const& record) {
+		WorldCoordinate floor_coords = record.physics.get_floor_coords();
+		switch (record.object_type) {
+		case GFFN_OBJECT_TYPE_CHARACTER: {
+			return make_pooled_object<GFFN_Character>(GFFN_OBJECT_TYPE_CHARACTER, record.animation_sheet->animation_texture,
+				record.visuals->shadow_texture, record.animation_fps, floor_coords, record.animation_sheet->frame_width,
+				record.animation_sheet->frame_height);
+		}
+		case GFFN_OBJECT_TYPE_NPC: {
+			NPC_info npc_info;
+			npc_info.character_type = record.archetype->character_type;
+			npc_info.floor_coords = floor_coords;
+			npc_info.animation_texture = record.archetype->animation_texture;
+			npc_info.shadow_texture = record.archetype->shadow_texture;
+			npc_info.animation_fps = record.archetype->animation_fps;
+			npc_info.animation_width = record.archetype->animation_width;
+			npc_info.animation_height = record.archetype->animation_height;
+			return make_pooled_object<GFFN_NPC>(npc_info);
+		}
+		case GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE: {
+			return make_pooled_object<GFFN_StraightProjectile>(floor_coords, physics::NormalizedVector3D(), 0.0, 0.0,
+				record.visuals->texture, record.visuals->shadow_texture);
+		}
+		case GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART: {
+			SDL_Rect source_rect = record.source_rect;
+			return make_pooled_object<GFFN_DismemberedBodyPart>(floor_coords, record.visuals->texture, record.visuals->shadow_texture, &source_rect);
+		}
+		case GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT: {
+			return make_pooled_object<GFFN_EnvironmentalObject>(floor_coords, record.visuals->texture, record.visuals->shadow_texture);
+		}
+		case GFFN_OBJECT_TYPE_UI_OBJECT: {
+			return make_pooled_object<GFFN_UIObject>(renderer.get_sdl_renderer(), record.visuals->texture,
+				WorldCoordinate(record.render_rect.x, record.render_rect.y, 0));
+		}
+		default:
+			throw GFFN_Exception(std::string("Unknown object type in a world snapshot"));
+		}
 	}
 
 	WorldCoordinate get_mouse_position_as_coordinate(GFFN_Renderer& renderer) {
@@ -104,77 +519,130 @@ public:
 
 	template <class T>
 	void dismember_character(T* const object, physics::NormalizedVector3D throw_vector, double throw_velocity_magnitude) {
-		static std::random_device rd;
-		static std::mt19937 gen(rd());
-		static std::uniform_real_distribution<> dist(0.3, 1);
+		// Static so this doesn't build a string every time something dies.
+		static const std::string texture_filename("C:\\Users\\guzzo\\Documents\\workspaces\\unnamed_game\\unnamed_game\\textures\\small_shadow.png");
+		SDL_Texture* const part_shadow_texture = renderer.get_texture(texture_filename);
 		for (int i = 0; i < 6; i++) {
 			std::pair<SDL_Texture*, SDL_Rect*> part_image_info = renderer.character_dismemberment_images->get_image(i);
 			SDL_Texture* part_texture = part_image_info.first;
 			SDL_Rect* part_source_rect = part_image_info.second;
-			std::string texture_filename = std::string("C:\\Users\\guzzo\\Documents\\workspaces\\unnamed_game\\unnamed_game\\textures\\small_shadow.png");
-			std::unique_ptr<GFFN_DismemberedBodyPart> part =
-				std::make_unique<GFFN_DismemberedBodyPart>(object->get_floor_coords(), part_texture, renderer.get_texture(texture_filename), part_source_rect);
+			GFFN_PooledPtr<GFFN_DismemberedBodyPart> part =
+				make_pooled_object<GFFN_DismemberedBodyPart>(object->get_floor_coords(), part_texture, part_shadow_texture, part_source_rect);
 			gffn::physics::NormalizedVector3D part_throw_vector = throw_vector;
-			double rotation = (dist(gen) * 90) - 45;
+			double rotation = random::range(-45.0, 45.0);
 			part_throw_vector.rotate_xy(rotation);
 			physics::ObjectPhysicsController &part_physics_controller = part->get_physics_controller();
 			part_physics_controller.set_height(30);
 			part_physics_controller.set_ground_coef_friction(20);
 			
-			physics::Vector3D part_velocity = physics::Vector3D(part_throw_vector.x * throw_velocity_magnitude * dist(gen), part_throw_vector.y * throw_velocity_magnitude * dist(gen), 0);
+			physics::Vector3D part_velocity = physics::Vector3D(part_throw_vector.x * throw_velocity_magnitude * random::range(0.3, 1.0), part_throw_vector.y * throw_velocity_magnitude * random::range(0.3, 1.0), 0);
 			//part_velocity.z = throw_velocity_magnitude * 0.2;
 			part_physics_controller.set_velocity(part_velocity);
 			
-			std::unique_ptr<gffn::GFFN_GameObject> part_ptr = std::move(part);
+			GFFN_ObjectPtr part_ptr = std::move(part);
 			add_object(part_ptr);
 		}
 	}
 
-	void event_handler() {
-		while (!events::event_queue.empty()) {
-			if (std::holds_alternative<events::ProjectileHitEvent>(events::event_queue.front())) {
-				events::ProjectileHitEvent projectile_hit_event = std::get<events::ProjectileHitEvent>(events::event_queue.front());
-				events::event_queue.pop();
-
-				GFFN_GridObject *object = projectile_hit_event.object;
-				GFFN_StraightProjectile* projectile = projectile_hit_event.projectile;
-				if (object == nullptr || projectile == nullptr) {
-					continue;
-				}
+	// Applies the summed damage of every target that got hit this tick. The channel coalesces by target, so this runs once
+	// per NPC no matter how many projectiles hit it.
+	void handle_projectile_hits(std::span<const events::ProjectileHitEvent> hits) {
+		for (events::ProjectileHitEvent const& hit : hits) {
+			if (!game_world_objects.object_exists(hit.target_id)) {
+				continue;
+			}
+			if (hit.target_type != GFFN_OBJECT_TYPE_CHARACTER && hit.target_type != GFFN_OBJECT_TYPE_NPC) {
+				// TODO: Handle projectile hitting environmental object??
+				continue;
+			}
+			GFFN_Character* character = static_cast<GFFN_Character*>(game_world_objects.get_object(hit.target_id));
+			if (character->to_remove()) {
+				continue; // already blown apart this tick
+			}
+			particle_system.burst(particles::HIT_SPARK_PARTICLES, character->get_floor_coords(), particle_texture);
+			character->change_hp(-hit.damage);
+			// Only NPCs get torn apart and removed, all of this tick's at once by remove_flagged_objects. A dead character
+			// (the player) stays in the world with dead set, the game holds on to it and decides what dying means.
+			if (character->is_dead() && hit.target_type == GFFN_OBJECT_TYPE_NPC) {
+				dismember_character<GFFN_Character>(character, hit.direction, 700);
+				character->remove();
+			}
+		}
+	}
 
-				GFFN_ObjectType object_type = object->get_object_type();
-				long unsigned int object_id = object->get_object_id();
-				GFFN_ObjectType projectile_type = projectile->get_object_type();
-				long unsigned int projectile_id = projectile->get_object_id();
-
-				if (object_type == GFFN_OBJECT_TYPE_CHARACTER && projectile_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
-					GFFN_Character* character = static_cast<GFFN_Character*>(object);
-					if (character->is_dead()) {
-						dismember_character<GFFN_Character>(character, projectile->get_velocity_direction(), 700);
-						remove_object(object_id);
-					}
-				}
-				else if (object_type == GFFN_OBJECT_TYPE_NPC && projectile_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
-					GFFN_NPC* npc = static_cast<GFFN_NPC*>(object);
-					if (npc->is_dead()) {
-						dismember_character<GFFN_NPC>(npc, projectile->get_velocity_direction(), 700);
-						remove_object(object_id);
-					}
+	void handle_explosions(std::span<events::ExplosionEvent> explosions) {
+		for (events::ExplosionEvent& explosion : explosions) {
+			explosion_system.process(explosion);
+			particle_system.burst(particles::EXPLOSION_PARTICLES, explosion.coordinates, particle_texture);
+			for (events::ExplosionHit const& hit : explosion.objects_hit) {
+				if (!hit.killed || !game_world_objects.object_exists(hit.object_id)) {
+					continue;
 				}
-				else if (object_type == GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT) {
-					// TODO: Handle projectile hitting environmental object??
+				GFFN_Character* character = static_cast<GFFN_Character*>(game_world_objects.get_object(hit.object_id));
+				// Same as projectile hits, a character that got killed stays in the world dead.
+				if (character->get_object_type() != GFFN_OBJECT_TYPE_NPC || character->to_remove()) {
+					continue;
 				}
-				else {
-					//throw GFFN_Exception("Unknown object type in event handler.");
+				WorldCoordinate character_coords = character->get_floor_coords();
+				physics::NormalizedVector3D throw_direction;
+				if (character_coords.distance_from(explosion.coordinates) > 0.001) {
+					throw_direction = physics::NormalizedVector3D(explosion.coordinates, character_coords);
 				}
+				dismember_character<GFFN_Character>(character, throw_direction, 900);
+				character->remove();
 			}
-			else if (std::holds_alternative<events::ExplosionEvent>(events::event_queue.front())) {
-				// TODO: Handle explosion event.
+		}
+	}
+
+	// Hands everything pushed since the last call to the handlers. Events pushed by the handlers themselves go out next tick.
+	void event_handler() {
+		GFFN_PROFILE_SCOPE("event_handler");
+		events::event_bus.publish();
+		frame_stats::count(GFFN_FRAME_COUNTER_EVENTS_DISPATCHED, (std::uint32_t)events::event_bus.get_num_published());
+		events::event_bus.dispatch();
+	}
+
+	// Re-measures the memory we can't track per allocation because std::vector owns the allocator.
+	void sample_memory_usage() {
+		std::size_t grid_bytes = 0;
+		for (auto const& column : world_grid) {
+			for (auto const& cell : column) {
+				grid_bytes += cell.capacity() * sizeof(GFFN_GameObject*);
 			}
 		}
+		memory::set_sampled_bytes(GFFN_MEMORY_TAG_WORLD_GRID, grid_bytes);
+		memory::set_sampled_bytes(GFFN_MEMORY_TAG_OBJECT_STORAGE, game_world_objects.get_storage_bytes());
+		memory::set_sampled_bytes(GFFN_MEMORY_TAG_EVENTS, events::event_bus.get_storage_bytes());
 	}
 
 	void tick(GFFN_Renderer &renderer, double delta_time_seconds) {
+		GFFN_PROFILE_SCOPE("GFFN_GameWorld::tick");
+		begin_phase_timing();
+		explosion_system.begin_frame();
+		camera.tick(delta_time_seconds);
+		end_phase(GFFN_TICK_PHASE_PHYSICS);
+
+		// Resumes the behaviors and fires the timers that are due, before anything ticks so they see this tick's state.
+		timer_wheel.advance(delta_time_seconds);
+
+		simulation_lod.begin_frame(delta_time_seconds, WorldCoordinate(camera.viewport.x + camera.viewport.w / 2.0,
+			camera.viewport.y + camera.viewport.h / 2.0, 0));
+		if (has_chase_target && game_world_objects.object_exists(chase_target_id)) {
+			WorldCoordinate target_coords = static_cast<GFFN_Movable*>(game_world_objects.get_object(chase_target_id))->get_floor_coords();
+			chase_field.set_goal(target_coords);
+			simulation_lod.set_player_coords(target_coords);
+		}
+		chase_field.tick();
+
+		crowd_separation.tick(game_world_objects.begin(), game_world_objects.end(), simulation_lod);
+		end_phase(GFFN_TICK_PHASE_AI);
+
+		{
+			GFFN_PROFILE_SCOPE("object ticks");
+			tick_objects(renderer, delta_time_seconds);
+		}
+
+		// Everything the objects pushed this tick gets handled in one batch per event type.
 		try {
 			event_handler();
 		}
@@ -182,43 +650,114 @@ public:
 			printf("Exception caught in event_handler %s\n", e.what());
 			throw;
 		}
+		end_phase(GFFN_TICK_PHASE_EVENTS);
 
-		camera.tick(delta_time_seconds);
+		remove_flagged_objects();
+		end_phase(GFFN_TICK_PHASE_CLEANUP);
+
+		particle_system.tick(delta_time_seconds);
+		end_phase(GFFN_TICK_PHASE_PARTICLES);
+
+		// Render
+		//game_world_objects.sort_objects_by_y();
+
+		try {
+			renderer.render_everything_in_viewport(game_world_objects.get_objects_by_y(), camera, particle_system);
+		}
+		catch (std::exception& e) {
+			printf("Exception caught in render_everything_in_viewport %s\n", e.what());
+			throw;
+		}
+		end_phase(GFFN_TICK_PHASE_RENDER_PREP);
+
+		// Everything allocated from the frame arena this tick is dead now.
+		frame_arena.reset();
+
+		{
+			GFFN_PROFILE_SCOPE("sample_memory_usage");
+			sample_memory_usage();
+		}
+		memory::end_frame();
+		end_phase(GFFN_TICK_PHASE_CLEANUP);
+
+		// Last, so it shows this tick's phases and draw counts.
+		if (show_performance_overlay) {
+			draw_performance_overlay();
+		}
+		renderer.present();
+		render_stats::end_frame();
+		end_phase(GFFN_TICK_PHASE_PRESENT);
+	}
+
+	// Frame time graph, where this tick went, what's in the world and what drawing it cost.
+	void draw_performance_overlay() {
+		GFFN_PROFILE_SCOPE("draw_performance_overlay");
+		constexpr double FRAME_BUDGET_MS = 1000.0 / 60.0;
+		GFFN_DebugOverlay& overlay = performance_overlay;
+		overlay.begin(20, 20);
+
+		double frame_ms = overlay.get_last_frame_ms();
+		overlay.textf(GFFN_DebugOverlay::WHITE, "frame {:.2f} ms  {:.0f} fps", frame_ms, frame_ms > 0 ? 1000.0 / frame_ms : 0.0);
+		overlay.frame_time_graph(FRAME_BUDGET_MS);
+		GFFN_TimingPercentiles frame_times = frame_stats::get_frame_window().get_percentiles();
+		overlay.textf(GFFN_DebugOverlay::GREY, "p50 {:.1f}  p95 {:.1f}  p99 {:.1f}  max {:.1f}  hitches {}", frame_times.p50_ms,
+			frame_times.p95_ms, frame_times.p99_ms, frame_times.max_ms, frame_stats::get_num_hitches());
+
+		std::array<double, GFFN_TICK_PHASE_END> phase_ms_shown = last_tick_phase_ms;
+		phase_ms_shown[GFFN_TICK_PHASE_PRESENT] = previous_present_ms;
+		double tick_ms = 0;
+		for (double phase_ms : phase_ms_shown) {
+			tick_ms += phase_ms;
+		}
+		overlay.textf(GFFN_DebugOverlay::GREY, "tick {:.2f} ms, present from the tick before", tick_ms);
+		for (int phase = 0; phase < GFFN_TICK_PHASE_END; phase++) {
+			double phase_ms = phase_ms_shown[phase];
+			// Bars are scaled to half a frame, one phase taking that much is already a problem.
+			SDL_Color color = phase_ms < FRAME_BUDGET_MS * 0.25 ? GFFN_DebugOverlay::GREEN
+				: (phase_ms < FRAME_BUDGET_MS * 0.5 ? GFFN_DebugOverlay::YELLOW : GFFN_DebugOverlay::RED);
+			overlay.bar(get_tick_phase_name((GFFN_TickPhase)phase), phase_ms, FRAME_BUDGET_MS * 0.5, "ms", color);
+		}
+
+		overlay.textf(GFFN_DebugOverlay::WHITE, "characters {}  npcs {}  projectiles {}", num_characters, num_npcs, num_straight_projectiles);
+		overlay.textf(GFFN_DebugOverlay::WHITE, "body parts {}  environmental {}  ui {}", num_dismembered_body_parts,
+			num_environmental_objects, num_ui_objects);
+		overlay.textf(GFFN_DebugOverlay::WHITE, "physics awake {}  asleep {}  particles {}", num_awake_objects, num_asleep_objects,
+			particle_system.get_num_live_particles());
+		render_stats::FrameCounts const& draws = render_stats::current_frame;
+		overlay.textf(GFFN_DebugOverlay::WHITE, "draw calls {}  texture binds {}  quads {}", draws.draw_calls, draws.texture_binds, draws.quads);
+		overlay.textf(GFFN_DebugOverlay::WHITE, "memory {} kb live  {} kb reserved", memory::get_total_live_bytes() / 1024,
+			memory::get_total_reserved_bytes() / 1024);
+		overlay.draw(renderer.get_sdl_renderer());
+	}
+
+	// Ticks every object, and flags the body parts that came to rest for removal once they're baked onto the floor.
+	void tick_objects(GFFN_Renderer &renderer, double delta_time_seconds) {
+		num_awake_objects = 0;
+		num_asleep_objects = 0;
 
 		//game_world_objects.clear_objects_by_y();
 
 		for (auto it = game_world_objects.begin(); it != game_world_objects.end();) {
 			GFFN_GameObject* const object = *it;
 
+			// Expired or dead, it goes with the rest in remove_flagged_objects.
 			if (object->to_remove()) {
-				if (object->get_object_type() == GFFN_OBJECT_TYPE_CHARACTER) {
-					num_characters--;
-					printf("character removed. %d left.\n", num_npcs);
-				}
-				else if (object->get_object_type() == GFFN_OBJECT_TYPE_NPC) {
-					num_npcs--;
-					printf("NPC removed. %d left.\n", num_npcs);
-				}
-				else if (object->get_object_type() == GFFN_OBJECT_TYPE_UI_OBJECT) {
-					num_ui_objects--;
-				}
-				else if (object->get_object_type() == GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART) {
-					num_dismembered_body_parts--;
-				}
-				else if (object->get_object_type() == GFFN_OBJECT_TYPE_ENVIRONMENTAL_OBJECT) {
-					num_environmental_objects--;
-				}
-				else if (object->get_object_type() == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
-					num_straight_projectiles--;
+				++it;
+				continue;
+			}
+
+			GFFN_ObjectType const object_type = object->get_object_type();
+			if (object_type == GFFN_OBJECT_TYPE_CHARACTER || object_type == GFFN_OBJECT_TYPE_NPC
+				|| object_type == GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART || object_type == GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE) {
+				if (static_cast<GFFN_Movable*>(object)->is_asleep()) {
+					num_asleep_objects++;
 				}
 				else {
-					throw GFFN_Exception(std::string("Unknown object type passed into add_object for GFFN_GameWorld"));
+					num_awake_objects++;
 				}
-				it = game_world_objects.remove_object(it);
-				continue;
 			}
 
-			switch (object->get_object_type()) {
+			switch (object_type) {
 			case GFFN_OBJECT_TYPE_CHARACTER: {
 				GFFN_Character* const character = static_cast<GFFN_Character*>(object);
 				try{
@@ -232,18 +771,28 @@ public:
 			}
 			case GFFN_OBJECT_TYPE_NPC: {
 				GFFN_NPC* const npc = static_cast<GFFN_NPC*>(object);
-				npc->tick(delta_time_seconds);
+				double npc_delta_time_seconds;
+				if (!simulation_lod.should_tick(npc->get_object_id(), npc->get_floor_coords(), npc_delta_time_seconds)) {
+					break;
+				}
+				bool on_screen = camera.object_in_viewport(npc->get_render_rect(), (int)npc->get_height_offset());
+				npc->tick(npc_delta_time_seconds, chase_field, on_screen);
 				break;
 			}
 			case GFFN_OBJECT_TYPE_DISMEMBERED_BODY_PART: {
 				GFFN_DismemberedBodyPart* const part = static_cast<GFFN_DismemberedBodyPart*>(object);
+				double part_delta_time_seconds;
+				if (!simulation_lod.should_tick(part->get_object_id(), part->get_floor_coords(), part_delta_time_seconds)) {
+					break;
+				}
 				if (part->get_physics_controller().get_velocity().is_zero()) {
 					renderer.bake_object_onto_floor<GFFN_DismemberedBodyPart>(part);
-					it = game_world_objects.remove_object(it);
-					num_dismembered_body_parts--;
+					part->remove();
+					end_phase(GFFN_TICK_PHASE_PHYSICS);
+					++it;
 					continue;
 				}
-				part->tick(delta_time_seconds);
+				part->tick(part_delta_time_seconds);
 				break; 
 			}
 			case GFFN_OBJECT_TYPE_STRAIGHT_PROJECTILE: {
@@ -269,19 +818,9 @@ public:
 			/*if (camera.object_in_viewport(object->get_render_rect(), object->get_height_offset())) {
 				game_world_objects.add_to_objects_by_y(object);
 			}*/
+			end_phase(object_type == GFFN_OBJECT_TYPE_NPC ? GFFN_TICK_PHASE_AI : GFFN_TICK_PHASE_PHYSICS);
 			++it;
 		}
-
-		// Render
-		//game_world_objects.sort_objects_by_y();
-
-		try {
-			renderer.render_everything_in_viewport(game_world_objects.get_objects_by_y(), camera);
-		}
-		catch (std::exception& e) {
-			printf("Exception caught in render_everything_in_viewport %s\n", e.what());
-			throw;
-		}
 	}
 };
 
@@ -3,10 +3,12 @@
 #include <vector>
 #include <map>
 #include <queue>
-#include <random>
 #include <array>
+#include <unordered_map>
+#include <span>
 
 #include <gffn_game_object.h>
+#include <gffn_pool.h>
 
 namespace gffn {
 
@@ -15,7 +17,10 @@ typedef long unsigned int object_id_t;
 
 // This class will hold all game objects that are to be rendered.
 class GameWorldObjects {
-	std::unordered_map<object_id_t, std::unique_ptr<GFFN_GameObject>> game_objects;
+	// Map nodes come out of a pool too, otherwise every spawn would still do one heap allocation here.
+	typedef std::pair<const object_id_t, GFFN_ObjectPtr> game_objects_value_t;
+	std::unordered_map<object_id_t, GFFN_ObjectPtr, std::hash<object_id_t>, std::equal_to<object_id_t>,
+		GFFN_PoolAllocator<game_objects_value_t>> game_objects;
 	std::vector<GFFN_GameObject*> game_objects_vec;
 
 	// this will be used for rendering, it has to be sorted after being filled.
@@ -28,12 +33,19 @@ public:
 		return game_objects.count(object_id) == 1;
 	}
 
-	void add_object(std::unique_ptr<GFFN_GameObject> object) {
+	void add_object(GFFN_ObjectPtr object) {
 		object_id_t object_id = object->get_object_id();
-		game_objects[object_id] = std::move(object);
-		game_objects_vec.push_back(game_objects[object_id].get());
+		auto it = game_objects.insert_or_assign(object_id, std::move(object)).first;
+		game_objects_vec.push_back(it->second.get());
 	}
 
+	// For bulk loads, so adding num_objects more doesn't rehash or regrow along the way.
+	void reserve(std::size_t num_objects) {
+		game_objects.reserve(game_objects.size() + num_objects);
+		game_objects_vec.reserve(game_objects_vec.size() + num_objects);
+	}
+	std::size_t size() const { return game_objects_vec.size(); }
+
 	void remove_object(object_id_t object_id) {
 		for (auto it = game_objects_vec.begin(); it != game_objects_vec.end(); ++it) {
 			if ((*it)->get_object_id() == object_id) {
@@ -44,9 +56,42 @@ public:
 		game_objects.erase(object_id);
 	}
 
+	// Destroys every object should_remove picks and closes the gaps in one pass, the rest keep their tick order. Removing a
+	// lot of objects at once costs the same as removing one with remove_object. Returns how many went.
+	template <class Predicate>
+	std::size_t remove_objects_if(Predicate should_remove) {
+		auto kept = game_objects_vec.begin();
+		for (auto it = game_objects_vec.begin(); it != game_objects_vec.end(); ++it) {
+			GFFN_GameObject* const object = *it;
+			if (should_remove(object)) {
+				game_objects.erase(object->get_object_id());
+			}
+			else {
+				*kept++ = object;
+			}
+		}
+		std::size_t num_removed = (std::size_t)(game_objects_vec.end() - kept);
+		game_objects_vec.erase(kept, game_objects_vec.end());
+		return num_removed;
+	}
+
 	GFFN_GameObject* const get_object(object_id_t object_id) const {
 		return game_objects.at(object_id).get();
 	}
+	// nullptr if there's no such object.
+	GFFN_GameObject* find_object(object_id_t object_id) const {
+		auto it = game_objects.find(object_id);
+		return it == game_objects.end() ? nullptr : it->second.get();
+	}
+
+	// For restoring snapshots, which rebuild the whole tick order at once: erase_object destroys the object but leaves
+	// it in the tick order, and set_order then replaces the tick order with exactly what's left.
+	void erase_object(object_id_t object_id) {
+		game_objects.erase(object_id);
+	}
+	void set_order(std::span<GFFN_GameObject* const> objects) {
+		game_objects_vec.assign(objects.begin(), objects.end());
+	}
 
 	std::vector<GFFN_GameObject*>::iterator remove_object(std::vector<GFFN_GameObject*>::iterator it) {
 		game_objects.erase((*it)->get_object_id());
@@ -62,6 +107,12 @@ public:
 	}
 	void sort_objects_by_y() { std::sort(objects_by_y.begin(), objects_by_y.end()); }
 	objects_by_y_t & get_objects_by_y() { return objects_by_y; }
+
+	// What the vectors and the bucket array hold right now. The map nodes are counted by their pool.
+	std::size_t get_storage_bytes() const {
+		return game_objects_vec.capacity() * sizeof(GFFN_GameObject*)
+			+ objects_by_y.capacity() * sizeof(std::pair<int, GFFN_GameObject*>);
+	}
 };
 
 } // end namespace gffn
\ No newline at end of file
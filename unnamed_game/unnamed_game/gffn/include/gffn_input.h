@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gffn_utils.h>
+
+namespace gffn {
+
+class GFFN_Renderer;
+class GFFN_Camera;
+
+namespace input {
+
+// The keys the game looks at. Anything else isn't recorded.
+typedef enum : std::uint8_t {
+	GFFN_INPUT_KEY_W,
+	GFFN_INPUT_KEY_A,
+	GFFN_INPUT_KEY_S,
+	GFFN_INPUT_KEY_D,
+	GFFN_INPUT_KEY_SPACE,
+	GFFN_INPUT_KEY_F,
+	GFFN_INPUT_KEY_R,
+	GFFN_INPUT_KEY_M,
+	GFFN_INPUT_KEY_ESCAPE,
+	GFFN_INPUT_KEY_T, // after ESCAPE so logs recorded before it still read the same
+	GFFN_INPUT_KEY_F3,
+	GFFN_INPUT_KEY_F9,
+	GFFN_INPUT_KEY_END
+} GFFN_InputKey;
+
+typedef enum : std::uint8_t {
+	GFFN_INPUT_MOUSE_LEFT,
+	GFFN_INPUT_MOUSE_MIDDLE,
+	GFFN_INPUT_MOUSE_RIGHT,
+	GFFN_INPUT_MOUSE_END
+} GFFN_InputMouseButton;
+
+// Everything the game reads from the player in one tick. The main loop only looks at this, never at SDL directly, so a
+// tick can be fed from a recording just as well as from the keyboard.
+typedef struct InputFrame {
+	double delta_time_seconds = 0;
+	WorldCoordinate mouse_coords; // already in world space, so a replay doesn't depend on window size or zoom
+	std::uint16_t held_keys = 0;    // bit per GFFN_InputKey
+	std::uint16_t pressed_keys = 0; // keys that went down this tick
+	std::uint8_t mouse_buttons = 0; // bit per GFFN_InputMouseButton
+	std::int8_t wheel = 0;          // summed over the tick, + is away from the player
+	bool quit = false;
+
+	bool is_held(GFFN_InputKey key) const { return (held_keys >> key) & 1; }
+	bool was_pressed(GFFN_InputKey key) const { return (pressed_keys >> key) & 1; }
+	bool is_mouse_down(GFFN_InputMouseButton button) const { return (mouse_buttons >> button) & 1; }
+} InputFrame;
+
+// Drains the SDL event queue and reads the keyboard and mouse. delta_time_seconds is left for the caller.
+InputFrame read_live_input(GFFN_Renderer& renderer, GFFN_Camera const& camera);
+
+// Input logs are a small header (magic, version, seed, fixed delta time) followed by 16 bytes per tick. Recording and
+// replaying both run the sim at the log's fixed delta time, so a replay goes through exactly the ticks the recording did
+// no matter how fast the machine is.
+static constexpr double DEFAULT_FIXED_DELTA_TIME_SECONDS = 1.0 / 60.0;
+
+class GFFN_InputRecorder {
+	std::ofstream file;
+	std::size_t num_frames = 0;
+public:
+	// Returns false if the file can't be written.
+	bool open(std::string const& filename, std::uint64_t seed, double fixed_delta_time_seconds);
+	void record(InputFrame const& frame);
+	void close() { file.close(); }
+	bool is_recording() const { return file.is_open(); }
+	std::size_t get_num_frames() const { return num_frames; }
+};
+
+class GFFN_InputReplay {
+	std::vector<InputFrame> frames;
+	std::size_t next = 0;
+	std::uint64_t seed = 0;
+	double fixed_delta_time_seconds = DEFAULT_FIXED_DELTA_TIME_SECONDS;
+public:
+	// Reads the whole log up front so replaying doesn't touch the disk. Throws GFFN_Exception if it isn't an input log.
+	// Returns false if the file can't be opened.
+	bool load(std::string const& filename);
+	// Fills frame with the next recorded tick, or returns false when the log is done.
+	bool next_frame(InputFrame& frame);
+
+	bool is_loaded() const { return !frames.empty(); }
+	std::uint64_t get_seed() const { return seed; }
+	double get_fixed_delta_time_seconds() const { return fixed_delta_time_seconds; }
+	std::size_t get_num_frames() const { return frames.size(); }
+	std::size_t get_num_frames_played() const { return next; }
+};
+
+}} // end namespace gffn::input
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <gffn_utils.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gffn {
+
+// Level files are memory mapped and read in place, no parsing. Layout, all little endian, every section 8 byte aligned:
+//   GFFN_LevelHeader
+//   num_textures x GFFN_LevelTexture           texture paths, records refer to them by index
+//   grid_width * grid_height x GFFN_LevelCell  which records sit in each world_grid cell, in world_grid[x][y] order
+//   num_static_objects x GFFN_LevelStaticObject sorted by cell
+//   num_npcs x GFFN_LevelNPC                   sorted by cell
+//   num_ground_tiles x GFFN_LevelGroundTile
+// Records being sorted by cell is what lets GFFN_GameWorld::load_level fill each world_grid cell in one go.
+static constexpr std::uint32_t LEVEL_VERSION = 1;
+static constexpr std::size_t LEVEL_TEXTURE_PATH_SIZE = 120;
+static constexpr std::uint16_t LEVEL_NO_TEXTURE = 0xFFFF; // shadows only
+
+typedef struct GFFN_LevelHeader {
+	char magic[8]; // GFFNLEVL
+	std::uint32_t version;
+	std::uint32_t grid_width;
+	std::uint32_t grid_height;
+	std::uint32_t num_textures;
+	std::uint32_t num_static_objects;
+	std::uint32_t num_npcs;
+	std::uint32_t num_ground_tiles;
+	std::uint32_t reserved;
+	std::uint64_t textures_offset;
+	std::uint64_t cells_offset;
+	std::uint64_t static_objects_offset;
+	std::uint64_t npcs_offset;
+	std::uint64_t ground_tiles_offset;
+} GFFN_LevelHeader;
+
+typedef struct GFFN_LevelTexture {
+	char path[LEVEL_TEXTURE_PATH_SIZE]; // nul terminated
+	std::uint64_t reserved;
+} GFFN_LevelTexture;
+
+typedef struct GFFN_LevelCell {
+	std::uint32_t first_static_object;
+	std::uint32_t num_static_objects;
+	std::uint32_t first_npc;
+	std::uint32_t num_npcs;
+} GFFN_LevelCell;
+
+// A GFFN_EnvironmentalObject.
+typedef struct GFFN_LevelStaticObject {
+	float x;
+	float y;
+	std::uint16_t texture;
+	std::uint16_t shadow_texture;
+	std::uint32_t reserved;
+} GFFN_LevelStaticObject;
+
+// A GFFN_NPC, with the same fields as NPC_info.
+typedef struct GFFN_LevelNPC {
+	float x;
+	float y;
+	std::uint16_t animation_texture;
+	std::uint16_t shadow_texture;
+	std::uint16_t animation_width;
+	std::uint16_t animation_height;
+	std::uint8_t character_type;
+	std::uint8_t animation_fps;
+	std::uint16_t reserved;
+} GFFN_LevelNPC;
+
+// One texture drawn over a whole 1m cell of the ground.
+typedef struct GFFN_LevelGroundTile {
+	std::uint16_t cell_x;
+	std::uint16_t cell_y;
+	std::uint16_t texture;
+	std::uint16_t reserved;
+} GFFN_LevelGroundTile;
+
+static_assert(sizeof(GFFN_LevelHeader) == 80);
+static_assert(sizeof(GFFN_LevelTexture) == 128);
+static_assert(sizeof(GFFN_LevelCell) == 16);
+static_assert(sizeof(GFFN_LevelStaticObject) == 16);
+static_assert(sizeof(GFFN_LevelNPC) == 20);
+static_assert(sizeof(GFFN_LevelGroundTile) == 8);
+
+// A read only view of a whole file. The pages are only read in when touched.
+class GFFN_MappedFile {
+	const unsigned char* data = nullptr;
+	std::size_t size = 0;
+#if defined(_WIN32)
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+public:
+	GFFN_MappedFile() {}
+	~GFFN_MappedFile() { close(); }
+	GFFN_MappedFile(const GFFN_MappedFile&) = delete;
+	GFFN_MappedFile& operator=(const GFFN_MappedFile&) = delete;
+
+	// Returns false if the file can't be opened or is empty.
+	bool open(std::string const& filename);
+	void close();
+	const unsigned char* get_data() const { return data; }
+	std::size_t get_size() const { return size; }
+};
+
+class GFFN_Level {
+	GFFN_MappedFile file;
+	const GFFN_LevelHeader* header = nullptr;
+
+	template <class T>
+	std::span<const T> get_section(std::uint64_t offset, std::size_t count) const {
+		return std::span<const T>(reinterpret_cast<const T*>(file.get_data() + offset), count);
+	}
+public:
+	// Maps the file and checks the header and that every section and cell range is inside it. Throws GFFN_Exception if
+	// it isn't a level this build can load. Returns false if the file can't be opened.
+	bool load(std::string const& filename);
+	bool is_loaded() const { return header != nullptr; }
+
+	std::size_t get_num_textures() const { return header->num_textures; }
+	std::string_view get_texture_path(std::uint16_t texture) const;
+	std::span<const GFFN_LevelCell> get_cells() const { return get_section<GFFN_LevelCell>(header->cells_offset, (std::size_t)header->grid_width * header->grid_height); }
+	std::span<const GFFN_LevelStaticObject> get_static_objects() const { return get_section<GFFN_LevelStaticObject>(header->static_objects_offset, header->num_static_objects); }
+	std::span<const GFFN_LevelNPC> get_npcs() const { return get_section<GFFN_LevelNPC>(header->npcs_offset, header->num_npcs); }
+	std::span<const GFFN_LevelGroundTile> get_ground_tiles() const { return get_section<GFFN_LevelGroundTile>(header->ground_tiles_offset, header->num_ground_tiles); }
+	std::size_t get_num_objects() const { return (std::size_t)header->num_static_objects + header->num_npcs; }
+	std::size_t get_file_size() const { return file.get_size(); }
+};
+
+// Builds a level in memory and writes it out sorted by cell. For tools and benchmarks, the game only reads levels.
+class GFFN_LevelWriter {
+	std::vector<GFFN_LevelTexture> textures;
+	std::vector<GFFN_LevelStaticObject> static_objects;
+	std::vector<GFFN_LevelNPC> npcs;
+	std::vector<GFFN_LevelGroundTile> ground_tiles;
+public:
+	// Returns the index records use for path, adding it if it's new. Throws GFFN_Exception if the path is too long.
+	std::uint16_t add_texture(std::string const& path);
+	// Coordinates are clamped to inside the world.
+	void add_static_object(WorldCoordinate floor_coords, std::uint16_t texture, std::uint16_t shadow_texture);
+	void add_npc(WorldCoordinate floor_coords, std::uint16_t animation_texture, std::uint16_t shadow_texture,
+		std::uint8_t character_type, std::uint8_t animation_fps = 5, std::uint16_t animation_width = 25, std::uint16_t animation_height = 25);
+	void add_ground_tile(int cell_x, int cell_y, std::uint16_t texture);
+	// Returns false if the file can't be written.
+	bool write(std::string const& filename);
+};
+
+// Which world_grid cell a level record belongs to, the same rounding GFFN_GridObject uses.
+inline std::size_t get_level_cell_index(float x, float y) {
+	int cell_x = std::clamp((int)(x / 100.0), 0, WORLD_GRID_WIDTH - 1);
+	int cell_y = std::clamp((int)(y / 100.0), 0, WORLD_GRID_HEIGHT - 1);
+	return (std::size_t)cell_x * WORLD_GRID_HEIGHT + cell_y;
+}
+
+} // end namespace gffn
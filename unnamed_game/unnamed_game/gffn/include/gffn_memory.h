@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct SDL_Texture;
+
+namespace gffn {
+
+// Which part of the engine some memory belongs to.
+typedef enum : int {
+	GFFN_MEMORY_TAG_OBJECTS = 0,        // game objects in their pools
+	GFFN_MEMORY_TAG_OBJECT_STORAGE,     // GameWorldObjects' map and vectors
+	GFFN_MEMORY_TAG_WORLD_GRID,         // the vectors in every world_grid cell
+	GFFN_MEMORY_TAG_EVENTS,             // the event bus channels
+	GFFN_MEMORY_TAG_FRAME_ARENA,        // per-frame scratch memory
+	GFFN_MEMORY_TAG_TEXTURES,           // estimated GPU memory for textures
+	GFFN_MEMORY_TAG_PARTICLES,          // particle buffers and their vertex arrays
+	GFFN_MEMORY_TAG_END
+} GFFN_MemoryTag;
+
+namespace memory {
+
+// Live bytes come from two places: tracked allocations (pools, the arena, textures) that report every alloc and free,
+// and sampled bytes that get re-measured once a frame for things we don't own the allocator of (std::vector capacities).
+typedef struct TagStats {
+	std::size_t live_bytes;
+	std::size_t sampled_bytes;
+	std::size_t peak_bytes;
+	std::size_t reserved_bytes; // held from the system but not necessarily in use, like free pool blocks
+	std::uint64_t num_allocations;
+	std::uint64_t num_frees;
+	std::uint32_t frame_allocations;
+	std::uint32_t frame_frees;
+	std::uint32_t last_frame_allocations;
+	std::uint32_t last_frame_frees;
+
+	std::size_t get_live_bytes() const { return live_bytes + sampled_bytes; }
+} TagStats;
+
+// Only the sim thread touches these, so they are plain counters.
+extern std::array<TagStats, GFFN_MEMORY_TAG_END> tag_stats;
+
+inline void update_peak(TagStats& stats) {
+	if (stats.get_live_bytes() > stats.peak_bytes) {
+		stats.peak_bytes = stats.get_live_bytes();
+	}
+}
+
+inline void track_alloc(GFFN_MemoryTag tag, std::size_t bytes) {
+	TagStats& stats = tag_stats[tag];
+	stats.live_bytes += bytes;
+	stats.num_allocations++;
+	stats.frame_allocations++;
+	update_peak(stats);
+}
+
+// count is for frees that release a whole batch of allocations at once, like resetting the frame arena.
+inline void track_free(GFFN_MemoryTag tag, std::size_t bytes, std::uint32_t count = 1) {
+	TagStats& stats = tag_stats[tag];
+	stats.live_bytes -= bytes;
+	stats.num_frees += count;
+	stats.frame_frees += count;
+}
+
+inline void set_sampled_bytes(GFFN_MemoryTag tag, std::size_t bytes) {
+	tag_stats[tag].sampled_bytes = bytes;
+	update_peak(tag_stats[tag]);
+}
+
+inline void add_reserved_bytes(GFFN_MemoryTag tag, std::ptrdiff_t bytes) {
+	tag_stats[tag].reserved_bytes += bytes;
+}
+
+inline TagStats const& get_stats(GFFN_MemoryTag tag) { return tag_stats[tag]; }
+
+// SDL doesn't say how much VRAM a texture takes, so this is w * h * bytes per pixel. Close enough to spot leaks.
+std::size_t get_texture_bytes(SDL_Texture* texture);
+void track_texture(SDL_Texture* texture);
+void untrack_texture(SDL_Texture* texture);
+
+const char* get_tag_name(GFFN_MemoryTag tag);
+std::size_t get_total_live_bytes();
+std::size_t get_total_reserved_bytes();
+
+// Moves this frame's allocation counts into last_frame_*. GFFN_GameWorld::tick calls this at the end of every tick.
+void end_frame();
+
+std::string to_json();
+bool dump_json(std::string const& filename);
+
+}} // end namespace gffn::memory
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string_view>
+#include <vector>
+
+namespace gffn {
+
+// Immediate mode debug panel drawn in screen space over everything else. Build it every frame with text/bar/graph calls
+// between begin() and draw(). Glyphs come from a built in 5x7 font baked into one small texture at construction, and
+// the whole panel (background, text, bars, graph) goes out as a single SDL_RenderGeometryRaw call on that texture.
+class GFFN_DebugOverlay {
+public:
+	static constexpr int GLYPH_WIDTH = 5;
+	static constexpr int GLYPH_HEIGHT = 7;
+	static constexpr int ATLAS_CELL_SIZE = 8;
+	static constexpr int ATLAS_COLUMNS = 16;
+	static constexpr int SCALE = 2; // screen pixels per font pixel
+	static constexpr int LINE_HEIGHT = (GLYPH_HEIGHT + 3) * SCALE;
+	static constexpr int PADDING = 10;
+	static constexpr std::size_t FRAME_HISTORY_SIZE = 240;
+
+	static constexpr SDL_Color WHITE = { 255, 255, 255, 255 };
+	static constexpr SDL_Color GREY = { 160, 160, 160, 255 };
+	static constexpr SDL_Color GREEN = { 90, 220, 90, 255 };
+	static constexpr SDL_Color YELLOW = { 240, 210, 60, 255 };
+	static constexpr SDL_Color RED = { 240, 70, 60, 255 };
+
+private:
+	SDL_Texture* atlas = nullptr;
+
+	// Kept between frames so building the panel doesn't allocate once they've grown.
+	std::vector<float> positions;
+	std::vector<SDL_Color> colors;
+	std::vector<float> uvs;
+	std::vector<int> indices;
+
+	int panel_x = 0;
+	int panel_y = 0;
+	int cursor_y = 0;
+	int panel_right = 0;
+
+	std::array<float, FRAME_HISTORY_SIZE> frame_times_ms{};
+	std::size_t next_frame_time = 0;
+	std::size_t num_frame_times = 0;
+	std::chrono::steady_clock::time_point last_begin;
+	bool has_last_begin = false;
+
+	void add_quad(float x, float y, float w, float h, float u0, float v0, float u1, float v1, SDL_Color color);
+	void add_solid_quad(float x, float y, float w, float h, SDL_Color color);
+	// Returns the x after the last glyph.
+	float add_text(float x, float y, std::string_view text, SDL_Color color);
+public:
+	explicit GFFN_DebugOverlay(SDL_Renderer* renderer);
+	~GFFN_DebugOverlay();
+	GFFN_DebugOverlay(const GFFN_DebugOverlay&) = delete;
+	GFFN_DebugOverlay& operator=(const GFFN_DebugOverlay&) = delete;
+
+	// Starts a panel with its top left corner at x, y (logical pixels). The time since the last begin() is recorded as
+	// a frame time for frame_time_graph().
+	void begin(int x, int y);
+	void text(std::string_view line, SDL_Color color = WHITE);
+	// Formats into a stack buffer, so this doesn't allocate either. Lines are cut at 128 characters.
+	template <class... Args>
+	void textf(SDL_Color color, std::format_string<Args...> format, Args&&... args) {
+		char buffer[128];
+		auto result = std::format_to_n(buffer, sizeof(buffer), format, std::forward<Args>(args)...);
+		text(std::string_view(buffer, std::min<std::size_t>((std::size_t)result.size, sizeof(buffer))), color);
+	}
+	// A label, a bar filled to value / max_value and the value itself.
+	void bar(std::string_view label, double value, double max_value, std::string_view unit, SDL_Color color);
+	// The last FRAME_HISTORY_SIZE frame times, with lines at budget_ms and twice that.
+	void frame_time_graph(double budget_ms, int height = 80);
+	// Draws the panel onto the current render target.
+	void draw(SDL_Renderer* renderer);
+
+	double get_last_frame_ms() const;
+	bool is_ready() const { return atlas != nullptr; }
+};
+
+} // end namespace gffn
@@ -1,42 +1,164 @@
 #pragma once
 
-#include <gffn_game_object.h>
+#include <SDL.h>
+#include <SDL_render.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <gffn_utils.h>
+#include <gffn_memory.h>
 
 namespace gffn { namespace particles {
 
+// What an emitter spits out. Times are in milliseconds, sizes in pixels, speeds in pixels per second, directions in
+// degrees (0 is +x, 90 is +y) and colors are 0xRRGGBBAA. Each *_variance is the +- range around its base value, the color
+// variance is applied to each channel on its own.
 struct particle_info {
-	int num_particles;
-	int num_particles_per_tick;
-	int num_particles_per_second;
-	int num_particles_per_second_variance;
-	int num_particles_per_tick_variance;
-	int particle_lifetime;
-	int particle_lifetime_variance;
-	int particle_size;
-	int particle_size_variance;
-	int particle_speed;
-	int particle_speed_variance;
-	int particle_direction;
-	int particle_direction_variance;
-	int particle_color;
-	int particle_color_variance;
+	int num_particles = 0;                     // burst when the emitter is created
+	int num_particles_per_tick = 0;
+	int num_particles_per_second = 0;
+	int num_particles_per_second_variance = 0;
+	int num_particles_per_tick_variance = 0;
+	int particle_lifetime = 1000;
+	int particle_lifetime_variance = 0;
+	int particle_size = 4;
+	int particle_size_variance = 0;
+	int particle_speed = 0;
+	int particle_speed_variance = 0;
+	int particle_direction = 0;
+	int particle_direction_variance = 180;
+	int particle_color = 0xFFFFFFFF;
+	int particle_color_variance = 0;
+	int particle_upward_speed = 0;             // initial height speed, so sparks can arc
+	int particle_gravity = 0;                  // pixels per second^2 pulling the height back down
+	int emitter_lifetime = 0;                  // how long the per tick/second emission keeps going, 0 is burst only
+};
+
+// Presets for the effects the game uses.
+inline const particle_info EXPLOSION_PARTICLES = {
+	.num_particles = 400,
+	.particle_lifetime = 700,
+	.particle_lifetime_variance = 300,
+	.particle_size = 12,
+	.particle_size_variance = 6,
+	.particle_speed = 220,
+	.particle_speed_variance = 180,
+	.particle_color = (int)0xFFB040FF,
+	.particle_color_variance = 40,
+	.particle_upward_speed = 120,
+	.particle_gravity = 300,
+};
+
+inline const particle_info HIT_SPARK_PARTICLES = {
+	.num_particles = 40,
+	.particle_lifetime = 250,
+	.particle_lifetime_variance = 100,
+	.particle_size = 4,
+	.particle_size_variance = 2,
+	.particle_speed = 300,
+	.particle_speed_variance = 150,
+	.particle_color = (int)0xFFF0A0FF,
+	.particle_color_variance = 30,
+	.particle_upward_speed = 80,
+	.particle_gravity = 600,
 };
 
-class Particle : public GFFN_GridObject {
+typedef int emitter_id_t;
+static constexpr emitter_id_t NO_EMITTER = -1;
+
+// Every live particle of one texture, one array per field so the update walks straight through memory and does 4
+// particles per instruction. Dead particles are swapped with the last one, so the first count are always live.
+class ParticleBuffer {
 public:
-	Particle(WorldCoordinate floor_coords, bool fade=false, bool shrink=false) : GFFN_GridObject(GFFN_OBJECT_TYPE_PARTICLE, 1, 1, floor_coords, nullptr) {}
-	void tick(long unsigned int delta_time) {
-		GFFN_GridObject::tick(delta_time);
-	}
+	std::vector<float> x, y, height;
+	std::vector<float> velocity_x, velocity_y, velocity_height;
+	std::vector<float> gravity;
+	std::vector<float> age, inverse_lifetime;
+	std::vector<float> base_size, size;          // size is base_size after shrinking
+	std::vector<float> shrink, fade;             // 0 or 1, per particle since emitters share a buffer
+	std::vector<float> alpha;                    // 0 to 1 after fading
+	std::vector<std::uint32_t> color;            // SDL_Color layout, without the fade
+	std::size_t count = 0;
+	std::size_t allocated = 0;
+	std::size_t max_particles;
+
+	ParticleBuffer(std::size_t max_particles) : max_particles(max_particles) {}
+
+	// Grows the arrays so n more particles fit, up to max_particles. Returns how many actually fit.
+	std::size_t make_room(std::size_t n);
+	void update(float delta_time_seconds);
+	void remove_dead();
+	std::size_t get_bytes() const;
 };
 
-template <int num_particles>
-class ParticleEmitter : public GFFN_GameObject {
+// All particles that share a texture, drawn with one SDL_RenderGeometryRaw call.
+class ParticleBatch {
+	SDL_Texture* texture;
+	ParticleBuffer buffer;
+	// Filled every frame for the particles in the viewport.
+	std::vector<float> vertex_positions;
+	std::vector<SDL_Color> vertex_colors;
+	// Same for every quad, so they only get extended when the batch grows.
+	std::vector<float> vertex_uvs;
+	std::vector<int> indices;
+	std::size_t tracked_bytes = 0;
 public:
-	ParticleEmitter(WorldCoordinate floor_coords, bool fade=false, bool shrink=false) : GFFN_GameObject(GFFN_OBJECT_TYPE_PARTICLE_EMITTER, floor_coords, nullptr) {}
-	void tick(long unsigned int delta_time) {
-		GFFN_GameObject::tick(delta_time);
-	}
+	ParticleBatch(SDL_Texture* texture, std::size_t max_particles) : texture(texture), buffer(max_particles) {}
+	~ParticleBatch() { memory::track_free(GFFN_MEMORY_TAG_PARTICLES, tracked_bytes); }
+	ParticleBatch(const ParticleBatch&) = delete;
+	ParticleBatch& operator=(const ParticleBatch&) = delete;
+
+	SDL_Texture* get_texture() const { return texture; }
+	ParticleBuffer& get_buffer() { return buffer; }
+	std::size_t get_num_particles() const { return buffer.count; }
+	// Call after anything that can grow the arrays.
+	void update_memory_tracking();
+	void render(SDL_Renderer* renderer, SDL_Rect const& viewport);
+};
+
+typedef struct ParticleEmitter {
+	particle_info info;
+	WorldCoordinatef coords; // particles are all float, so this is converted once when the emitter is placed
+	SDL_Texture* texture;
+	bool fade;
+	bool shrink;
+	bool active;
+	float age_ms;
+	float particles_owed; // fractions of particles from per second emission, carried over to the next tick
+} ParticleEmitter;
+
+class ParticleSystem {
+	std::vector<std::unique_ptr<ParticleBatch>> batches;
+	std::vector<ParticleEmitter> emitters;
+	std::vector<emitter_id_t> free_emitter_ids;
+	GFFN_Rng rng;
+	std::size_t max_particles_per_texture;
+
+	ParticleBatch& get_batch(SDL_Texture* texture);
+	void spawn(ParticleEmitter const& emitter, int num_particles);
+	int vary(int value, int variance);
+public:
+	static constexpr std::size_t DEFAULT_MAX_PARTICLES_PER_TEXTURE = 128 * 1024;
+
+	// Past the max, new particles of that texture are dropped.
+	ParticleSystem(std::size_t max_particles_per_texture = DEFAULT_MAX_PARTICLES_PER_TEXTURE) :
+	rng(random::make_stream(random::GFFN_RANDOM_STREAM_PARTICLES)), max_particles_per_texture(max_particles_per_texture) {}
+
+	// Emits info.num_particles right away, then keeps emitting for info.emitter_lifetime ms.
+	emitter_id_t add_emitter(particle_info const& info, WorldCoordinate coords, SDL_Texture* texture, bool fade = true, bool shrink = true);
+	// Just the burst, no emitter is kept around.
+	void burst(particle_info const& info, WorldCoordinate coords, SDL_Texture* texture, bool fade = true, bool shrink = true);
+	void move_emitter(emitter_id_t emitter_id, WorldCoordinate coords);
+	void stop_emitter(emitter_id_t emitter_id);
+
+	void tick(double delta_time_seconds);
+	// Draws into the current render target, relative to the viewport. One draw call per texture.
+	void render(SDL_Renderer* renderer, SDL_Rect const& viewport);
+
+	std::size_t get_num_live_particles() const;
+	std::size_t get_num_active_emitters() const { return emitters.size() - free_emitter_ids.size(); }
 };
 
-}} // end namespace gffn
\ No newline at end of file
+}} // end namespace gffn::particles
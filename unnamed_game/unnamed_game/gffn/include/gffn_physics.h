@@ -5,129 +5,173 @@
 
 namespace gffn { namespace physics {
 
-typedef struct Vector3D {
-    double x;
-    double y;
-    double z;
-    Vector3D(double x, double y, double z) : x(x), y(y), z(z) {}
-    Vector3D(WorldCoordinate start, WorldCoordinate end) : x(end.x - start.x), y(end.y - start.y), z(end.z - start.z) {}
-    Vector3D() : x(0), y(0), z(0) {}
+template <typename T>
+struct alignas(MATH_ALIGNMENT<T>) BasicVector3D {
+    T x;
+    T y;
+    T z;
+    BasicVector3D(T x, T y, T z) : x(x), y(y), z(z) {}
+    BasicVector3D(BasicWorldCoordinate<T> start, BasicWorldCoordinate<T> end) : x(end.x - start.x), y(end.y - start.y), z(end.z - start.z) {}
+    BasicVector3D() : x(0), y(0), z(0) {}
+    template <typename U>
+    explicit BasicVector3D(BasicVector3D<U> const& other) : x((T)other.x), y((T)other.y), z((T)other.z) {}
     bool is_zero() const {
-        if (x > 0.001 || x < -0.001 || y > 0.001 || y < -0.001 || z > 0.001 || z < -0.001) {
+        if (x > (T)0.001 || x < (T)-0.001 || y > (T)0.001 || y < (T)-0.001 || z > (T)0.001 || z < (T)-0.001) {
             return false;
         }
         return true;
     }
-    double magnitude() const {
-		return sqrt((x * x) + (y * y) + (z * z));
+    T magnitude() const {
+		return std::sqrt((x * x) + (y * y) + (z * z));
 	}
-    Vector3D operator+(const Vector3D& other) const {
-        return Vector3D(x + other.x, y + other.y, z + other.z);
+    BasicVector3D operator+(const BasicVector3D& other) const {
+        return BasicVector3D(x + other.x, y + other.y, z + other.z);
     }
-    Vector3D operator-(const Vector3D& other) const {
-        return Vector3D(x - other.x, y - other.y, z - other.z);
+    BasicVector3D operator-(const BasicVector3D& other) const {
+        return BasicVector3D(x - other.x, y - other.y, z - other.z);
     }
-    Vector3D operator*(const double& scalar) const {
-        return Vector3D(x * scalar, y * scalar, z * scalar);
+    BasicVector3D operator*(const T& scalar) const {
+        return BasicVector3D(x * scalar, y * scalar, z * scalar);
     }
-    Vector3D operator*(const Vector3D& other) const {
-        return Vector3D(x * other.x, y * other.y, z * other.z);
+    BasicVector3D operator*(const BasicVector3D& other) const {
+        return BasicVector3D(x * other.x, y * other.y, z * other.z);
     }
-    Vector3D operator/(const double& scalar) const {
-        return Vector3D(x / scalar, y / scalar, z / scalar);
+    BasicVector3D operator/(const T& scalar) const {
+        return BasicVector3D(x / scalar, y / scalar, z / scalar);
     }
-    Vector3D operator/(const Vector3D& other) const {
-        return Vector3D(x / other.x, y / other.y, z / other.z);
+    BasicVector3D operator/(const BasicVector3D& other) const {
+        return BasicVector3D(x / other.x, y / other.y, z / other.z);
     }
-} Vector3D;
+};
 
-typedef struct NormalizedVector3D : public Vector3D {
-    NormalizedVector3D() : Vector3D(1, 0, 0) {}
-    NormalizedVector3D(Vector3D vec) {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_real_distribution<> dis(0, 1);
+template <typename T>
+struct BasicNormalizedVector3D : public BasicVector3D<T> {
+    BasicNormalizedVector3D() : BasicVector3D<T>(1, 0, 0) {}
+    BasicNormalizedVector3D(BasicVector3D<T> vec) {
         verify_normalized_vector(vec.x, vec.y, vec.z); // this causes drift to the bottom right if the passed in vec is all zero.
-        double magnitude = sqrt((vec.x * vec.x) + (vec.y * vec.y) + (vec.z * vec.z));
+        T magnitude = std::sqrt((vec.x * vec.x) + (vec.y * vec.y) + (vec.z * vec.z));
         this->x = vec.x / magnitude;
         this->y = vec.y / magnitude;
         this->z = vec.z / magnitude;
     }
-    NormalizedVector3D(WorldCoordinate start, WorldCoordinate end) {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_real_distribution<> dis(0, 1);
-        double x = end.x - start.x;
-        double y = end.y - start.y;
-        double z = end.z - start.z;
+    BasicNormalizedVector3D(BasicWorldCoordinate<T> start, BasicWorldCoordinate<T> end) {
+        T x = end.x - start.x;
+        T y = end.y - start.y;
+        T z = end.z - start.z;
         verify_normalized_vector(x, y, z);
-        double magnitude = sqrt((x * x) + (y * y) + (z * z));
-        this->x = ((double)x) / magnitude;
-        this->y = ((double)y) / magnitude;
-        this->z = ((double)z) / magnitude;
+        T magnitude = std::sqrt((x * x) + (y * y) + (z * z));
+        this->x = x / magnitude;
+        this->y = y / magnitude;
+        this->z = z / magnitude;
     }
-    double get_xy_direction_in_degrees() {
+    // Already unit length, so going between scalars doesn't normalize again.
+    template <typename U>
+    explicit BasicNormalizedVector3D(BasicNormalizedVector3D<U> const& other) : BasicVector3D<T>(BasicVector3D<U>(other)) {}
+    T get_xy_direction_in_degrees() {
         double y = this->y * -1;
 
-        double radians = atan2(y, x);
+        double radians = std::atan2(y, (double)this->x);
 
         double degrees = (180 * radians) / M_PI;
 
-        return (double)((360 + (int)degrees) % 360);
+        return (T)((360 + (int)degrees) % 360);
     }
     void rotate_xy(double degrees) {
         double radians = (degrees * M_PI) / 180;
-        double new_x = (x * cos(radians)) - (y * sin(radians));
-        double new_y = (x * sin(radians)) + (y * cos(radians));
-        x = new_x;
-        y = new_y;
+        T new_x = (T)((this->x * std::cos(radians)) - (this->y * std::sin(radians)));
+        T new_y = (T)((this->x * std::sin(radians)) + (this->y * std::cos(radians)));
+        this->x = new_x;
+        this->y = new_y;
     }
-    Vector3D get_vector3d() {
-		return Vector3D(x, y, z);
+    BasicVector3D<T> get_vector3d() {
+		return BasicVector3D<T>(this->x, this->y, this->z);
 	}
-} NormalizedVector3D;
+};
+
+typedef BasicVector3D<double> Vector3D;
+typedef BasicVector3D<float> Vector3Df;
+typedef BasicNormalizedVector3D<double> NormalizedVector3D;
+typedef BasicNormalizedVector3D<float> NormalizedVector3Df;
+static_assert(sizeof(Vector3Df) == 16 && alignof(Vector3Df) == 16, "Vector3Df should be one float4");
 
 // This class will handle everything about positioning, movement, anything physics related.
+// The state is kept in the float4 types: position, velocity and force are one aligned 16 byte load each, and a controller
+// is 64 bytes instead of 96. Floats still place things to a thousandth of a pixel at the far edge of the map. Everything
+// outside goes through double, the float getters and add_force(Vector3Df) are for loops that stay in float.
 class ObjectPhysicsController {
-    WorldCoordinate floor_coords;
-    Vector3D velocity; // in pixels/s where 100 pixels = 1m
-    Vector3D net_force; // in kg * pixels/s^2
-    double mass; // in kg
-    double ground_coef_friction;
-    static constexpr double GRAVITY = 980; // in pixels/s^2
+    WorldCoordinatef floor_coords;
+    Vector3Df velocity; // in pixels/s where 100 pixels = 1m
+    Vector3Df net_force; // in kg * pixels/s^2
+    float mass; // in kg
+    float ground_coef_friction;
+    static constexpr float GRAVITY = 980; // in pixels/s^2
     bool gravity_enabled;
+    // Sleeping objects skip tick() until something pushes them. Fits in the padding after gravity_enabled.
+    bool asleep = false;
+    unsigned char num_still_ticks = 0;
+
+    void wake() {
+        asleep = false;
+        num_still_ticks = 0;
+    }
 
 public:
+    // An object falls asleep after SLEEP_TICKS ticks in a row on the ground, slower than SLEEP_VELOCITY and with less
+    // than SLEEP_ACCELERATION of outside force on it.
+    static constexpr float SLEEP_VELOCITY = 2.0f;          // in pixels/s
+    static constexpr float SLEEP_ACCELERATION = 5.0f;      // in pixels/s^2
+    static constexpr unsigned char SLEEP_TICKS = 30;
+
     ObjectPhysicsController(WorldCoordinate initial_floor_coords, double ground_coef_friction, bool gravity_enabled=true) : 
-    floor_coords(initial_floor_coords), velocity(Vector3D(0, 0, 0)), mass(100), ground_coef_friction(ground_coef_friction), gravity_enabled(gravity_enabled) {}
+    floor_coords(initial_floor_coords), velocity(Vector3Df(0, 0, 0)), mass(100), ground_coef_friction((float)ground_coef_friction), gravity_enabled(gravity_enabled) {}
 
     // I'm using the concept of momentum for the power of attacks.
-    void transfer_momentum(Vector3D momentum) {
+    void transfer_momentum(Vector3Df momentum) {
         velocity = (momentum + (velocity*mass)) / mass;
+        wake();
 	}
+    void transfer_momentum(Vector3D momentum) {
+        transfer_momentum(Vector3Df(momentum));
+    }
 
     void transfer_momentum(ObjectPhysicsController const& other) {
-        Vector3D momentum = other.velocity * other.mass;
+        Vector3Df momentum = other.velocity * other.mass;
         transfer_momentum(momentum);
     }
 
     bool grounded() const {
-        return floor_coords.z < 0.01;
+        return floor_coords.z < 0.01f;
     }
 
-    void add_force(Vector3D force) {
+    void add_force(Vector3Df force) {
 		net_force = (net_force + force);
+        if (asleep && !force.is_zero()) {
+            wake();
+        }
 	}
+    void add_force(Vector3D force) {
+        add_force(Vector3Df(force));
+    }
+
+    bool is_asleep() const {
+        return asleep;
+    }
 
     WorldCoordinate get_floor_coords() const {
-		return floor_coords;
+		return WorldCoordinate(floor_coords);
 	}
+    WorldCoordinatef get_floor_coordsf() const {
+        return floor_coords;
+    }
 
     Vector3D get_net_force() const {
-		return net_force;
+		return Vector3D(net_force);
 	}
 
     Vector3D get_velocity() const {
+        return Vector3D(velocity);
+    }
+    Vector3Df get_velocityf() const {
         return velocity;
     }
 
@@ -136,34 +180,48 @@ public:
 	}
 
     void set_ground_coef_friction(double ground_coef_friction) {
-		this->ground_coef_friction = ground_coef_friction;
+		this->ground_coef_friction = (float)ground_coef_friction;
 	}
 
     void set_height(double height) {
-		floor_coords.z = height;
-        velocity.z = 0.0;
+		floor_coords.z = (float)height;
+        velocity.z = 0.0f;
+        wake();
 	}
 
     void set_net_force(Vector3D net_force) {
-        this->net_force = net_force;
+        this->net_force = Vector3Df(net_force);
+        if (!this->net_force.is_zero()) {
+            wake();
+        }
     }
 
-    void set_mass(double mass) { this->mass = mass; }
+    void set_mass(double mass) { this->mass = (float)mass; }
 
-    void set_velocity(Vector3D velocity) { this->velocity = velocity; }
+    void set_velocity(Vector3D velocity) {
+        this->velocity = Vector3Df(velocity);
+        wake();
+    }
 
     void tick(double delta_time_seconds) {
-        Vector3D friction_force = velocity * -1 * ground_coef_friction * mass;
+        if (asleep) {
+            return;
+        }
+        const float delta_time = (float)delta_time_seconds;
+        // Only what was pushed on it from outside counts for falling asleep, not friction or gravity.
+        float outside_acceleration_squared = (net_force.x * net_force.x + net_force.y * net_force.y + net_force.z * net_force.z) / (mass * mass);
+
+        Vector3Df friction_force = velocity * -1.0f * ground_coef_friction * mass;
         if (grounded()) {
             add_force(friction_force);
 		}
         if (gravity_enabled) {
-            Vector3D gravity_force = Vector3D(0, 0, -1) * GRAVITY * mass;
+            Vector3Df gravity_force = Vector3Df(0, 0, -1) * GRAVITY * mass;
             add_force(gravity_force);
         }
         
-        Vector3D acceleration = (net_force) / mass;
-        acceleration = acceleration * delta_time_seconds;
+        Vector3Df acceleration = (net_force) / mass;
+        acceleration = acceleration * delta_time;
 		velocity = velocity + acceleration;
         
         if(floor_coords.x < 100) {
@@ -182,15 +240,27 @@ public:
 			floor_coords.y = (WORLD_GRID_HEIGHT * 99) - 1;
 			velocity.y = 0;
 		}
-        floor_coords.x += velocity.x * delta_time_seconds;
-        floor_coords.y += velocity.y * delta_time_seconds;
-        floor_coords.z += velocity.z * delta_time_seconds;
-        if (floor_coords.z < 0.0001) {
+        floor_coords.x += velocity.x * delta_time;
+        floor_coords.y += velocity.y * delta_time;
+        floor_coords.z += velocity.z * delta_time;
+        if (floor_coords.z < 0.0001f) {
             floor_coords.z = 0;
             velocity.z = 0;
         };
-        net_force = Vector3D(0, 0, 0);
+        net_force = Vector3Df(0, 0, 0);
+
+        float velocity_squared = velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z;
+        if (grounded() && velocity_squared < SLEEP_VELOCITY * SLEEP_VELOCITY && outside_acceleration_squared < SLEEP_ACCELERATION * SLEEP_ACCELERATION) {
+            if (++num_still_ticks >= SLEEP_TICKS) {
+                asleep = true;
+                velocity = Vector3Df(0, 0, 0);
+            }
+        }
+        else {
+            num_still_ticks = 0;
+        }
 	}
 };
+static_assert(sizeof(ObjectPhysicsController) == 64, "ObjectPhysicsController should stay three float4s and the scalars after them");
 
 }} // end namespace gffn::physics
\ No newline at end of file
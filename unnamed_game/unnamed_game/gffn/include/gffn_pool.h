@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <gffn_exception.h>
+#include <gffn_memory.h>
+
+namespace gffn {
+
+// Fixed-size block allocator. Blocks are carved out of big chunks and recycled through an intrusive free list, so once
+// a pool has grown to its working size allocate() and deallocate() never go to the general heap. A new chunk isn't
+// threaded onto the free list up front, its blocks are handed out in order from the tail the first time around.
+// Not thread safe, pools belong to the sim thread.
+class GFFN_FixedPool {
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	struct Chunk {
+		void* memory;
+		std::size_t size;
+		bool mapped; // came straight from the OS instead of operator new
+		bool huge_pages;
+	};
+
+	std::size_t block_size;
+	std::size_t block_align;
+	GFFN_MemoryTag tag;
+	std::size_t blocks_per_chunk;
+	bool use_huge_pages;
+	FreeBlock* free_list = nullptr;
+	char* tail = nullptr; // blocks at the end of the newest chunk that have never been handed out
+	std::size_t num_tail_blocks = 0;
+	std::vector<Chunk> chunks;
+	std::size_t num_live = 0;
+	std::size_t num_blocks = 0;
+
+	void grow();
+	// Adds a chunk of at least num_chunk_blocks blocks and returns its first block. num_new_blocks is how many it fits.
+	char* add_chunk(std::size_t num_chunk_blocks, bool huge_pages, std::size_t& num_new_blocks);
+	// Puts what's left of the tail on the free list, before the tail moves to a new chunk.
+	void release_tail();
+	// Big chunks go on huge pages even if the pool doesn't use them otherwise. Most of filling a big chunk for the first
+	// time is the kernel faulting in fresh 4 KB pages one at a time.
+	bool wants_huge_pages(std::size_t num_chunk_blocks) const;
+	char* take_from_tail(std::size_t num_taken) {
+		char* blocks = tail;
+		tail += num_taken * block_size;
+		num_tail_blocks -= num_taken;
+		return blocks;
+	}
+public:
+	static constexpr std::size_t DEFAULT_BLOCKS_PER_CHUNK = 1024;
+	// Only affects pools created after it is set, so set it before spawning anything.
+	static bool default_use_huge_pages;
+
+	GFFN_FixedPool(std::size_t block_size, std::size_t block_align, GFFN_MemoryTag tag = GFFN_MEMORY_TAG_OBJECTS,
+		std::size_t blocks_per_chunk = DEFAULT_BLOCKS_PER_CHUNK, bool use_huge_pages = default_use_huge_pages);
+	~GFFN_FixedPool();
+	GFFN_FixedPool(const GFFN_FixedPool&) = delete;
+	GFFN_FixedPool& operator=(const GFFN_FixedPool&) = delete;
+
+	void* allocate() {
+		if (free_list == nullptr) {
+			if (num_tail_blocks == 0) {
+				grow();
+			}
+			num_live++;
+			memory::track_alloc(tag, block_size);
+			return take_from_tail(1);
+		}
+		FreeBlock* block = free_list;
+		free_list = block->next;
+		num_live++;
+		memory::track_alloc(tag, block_size);
+		return block;
+	}
+	void deallocate(void* memory) {
+		FreeBlock* block = static_cast<FreeBlock*>(memory);
+		block->next = free_list;
+		free_list = block;
+		num_live--;
+		memory::track_free(tag, block_size);
+	}
+	// num_blocks blocks back to back, for batch spawns that want their objects contiguous and walk them in order. Batches
+	// up to a chunk come off the tail, starting a new chunk if the tail is too short, bigger ones get a chunk of their
+	// own. Every block is still given back one at a time with deallocate().
+	char* allocate_contiguous(std::size_t num_blocks);
+	// Grows the pool up front so the first num_blocks allocations don't have to, in one chunk big enough for all of them.
+	void reserve(std::size_t num_blocks);
+
+	std::size_t get_block_size() const { return block_size; }
+	std::size_t get_num_live() const { return num_live; }
+	std::size_t get_capacity() const { return num_blocks; }
+	std::size_t get_num_chunks() const { return chunks.size(); }
+	std::size_t get_num_huge_page_chunks() const {
+		std::size_t num = 0;
+		for (Chunk const& chunk : chunks) {
+			if (chunk.huge_pages) num++;
+		}
+		return num;
+	}
+};
+
+// One pool per type (and memory tag), made on first use.
+template <class T, GFFN_MemoryTag tag = GFFN_MEMORY_TAG_OBJECTS>
+GFFN_FixedPool& get_pool() {
+	static GFFN_FixedPool pool(sizeof(T), alignof(T), tag);
+	return pool;
+}
+
+template <class T, class Base>
+void destroy_pooled(Base* object) {
+	T* derived = static_cast<T*>(object);
+	derived->~T();
+	get_pool<T>().deallocate(derived);
+}
+
+// unique_ptr deleter that hands pooled objects back to the pool they came from. Anything that was made with
+// std::make_unique is converted with a null destroy function and just gets deleted, so Base needs a virtual destructor.
+template <class Base>
+struct GFFN_PoolDeleter {
+	void (*destroy)(Base*) = nullptr;
+
+	GFFN_PoolDeleter() = default;
+	explicit GFFN_PoolDeleter(void (*destroy)(Base*)) : destroy(destroy) {}
+	template <class U>
+	GFFN_PoolDeleter(std::default_delete<U> const&) {}
+
+	void operator()(Base* object) const {
+		if (destroy != nullptr) {
+			destroy(object);
+		}
+		else {
+			delete object;
+		}
+	}
+};
+
+template <class T, class Base, class... Args>
+std::unique_ptr<T, GFFN_PoolDeleter<Base>> make_pooled(Args&&... args) {
+	GFFN_FixedPool& pool = get_pool<T>();
+	void* memory = pool.allocate();
+	T* object;
+	try {
+		object = new (memory) T(std::forward<Args>(args)...);
+	}
+	catch (...) {
+		pool.deallocate(memory);
+		throw;
+	}
+	return std::unique_ptr<T, GFFN_PoolDeleter<Base>>(object, GFFN_PoolDeleter<Base>(&destroy_pooled<T, Base>));
+}
+
+// std allocator on top of the per-type pools, for node based containers. Single element allocations (map nodes) come
+// from the pool, anything bigger (bucket arrays) still goes through operator new but is still counted under the tag.
+template <class T, GFFN_MemoryTag tag = GFFN_MEMORY_TAG_OBJECT_STORAGE>
+class GFFN_PoolAllocator {
+public:
+	typedef T value_type;
+	template <class U>
+	struct rebind {
+		typedef GFFN_PoolAllocator<U, tag> other;
+	};
+
+	GFFN_PoolAllocator() noexcept {}
+	template <class U>
+	GFFN_PoolAllocator(const GFFN_PoolAllocator<U, tag>&) noexcept {}
+
+	T* allocate(std::size_t n) {
+		if (n == 1) {
+			return static_cast<T*>(get_pool<T, tag>().allocate());
+		}
+		memory::track_alloc(tag, n * sizeof(T));
+		return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+	}
+	void deallocate(T* memory, std::size_t n) noexcept {
+		if (n == 1) {
+			get_pool<T, tag>().deallocate(memory);
+			return;
+		}
+		memory::track_free(tag, n * sizeof(T));
+		::operator delete(memory, std::align_val_t(alignof(T)));
+	}
+
+	template <class U>
+	bool operator==(const GFFN_PoolAllocator<U, tag>&) const noexcept { return true; }
+	template <class U>
+	bool operator!=(const GFFN_PoolAllocator<U, tag>&) const noexcept { return false; }
+};
+
+} // end namespace gffn
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped profiling markers. GFFN_PROFILE_SCOPE("name") records how long the rest of the enclosing block took, and
+// GFFN_PROFILE_FRAME() marks the end of a frame. The last frames can then be written out as a Chrome trace (open it in
+// chrome://tracing or ui.perfetto.dev) to see where a slow frame went.
+// Everything compiles to nothing unless GFFN_PROFILER is defined, which the GFFN_PROFILER cmake option does.
+
+namespace gffn { namespace profiler {
+
+// Names have to outlive the profiler, so string literals only.
+typedef struct Zone {
+	const char* name;
+	std::uint64_t start_ns;
+	std::uint64_t end_ns;
+} Zone;
+
+static constexpr std::size_t THREAD_RING_SIZE = 1 << 16; // zones kept per thread, a power of two
+static constexpr std::size_t FRAME_HISTORY_SIZE = 1024;
+static constexpr std::size_t DEFAULT_DUMP_FRAMES = 120;
+
+// Every thread records into its own ring, so a zone costs two clock reads and a store, no lock. Only the owning thread
+// writes, and head only ever grows, so a reader knows which zones it might have raced with and drops those.
+class GFFN_ProfilerRing {
+	std::array<Zone, THREAD_RING_SIZE> zones;
+	std::atomic<std::uint64_t> head{ 0 }; // zones ever recorded, the next one goes at head % THREAD_RING_SIZE
+public:
+	std::uint32_t thread_index = 0;
+	const char* thread_name = nullptr;
+
+	void push(const char* name, std::uint64_t start_ns, std::uint64_t end_ns) {
+		std::uint64_t index = head.load(std::memory_order_relaxed);
+		zones[index & (THREAD_RING_SIZE - 1)] = Zone{ name, start_ns, end_ns };
+		head.store(index + 1, std::memory_order_release);
+	}
+	// Appends every zone that ended after since_ns to out. Safe to call from any thread.
+	void copy_since(std::uint64_t since_ns, std::vector<Zone>& out) const;
+};
+
+inline std::uint64_t now_ns() {
+	return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Creates the calling thread's ring the first time, which takes a lock. After that it's a thread_local read.
+GFFN_ProfilerRing& register_thread();
+inline GFFN_ProfilerRing& get_thread_ring() {
+	thread_local GFFN_ProfilerRing* ring = &register_thread();
+	return *ring;
+}
+// Shows up as the track name in the trace. name has to be a string literal too.
+inline void set_thread_name(const char* name) { get_thread_ring().thread_name = name; }
+
+class GFFN_ScopedZone {
+	const char* name;
+	std::uint64_t start_ns;
+public:
+	explicit GFFN_ScopedZone(const char* name) : name(name), start_ns(now_ns()) {}
+	~GFFN_ScopedZone() { get_thread_ring().push(name, start_ns, now_ns()); }
+	GFFN_ScopedZone(const GFFN_ScopedZone&) = delete;
+	GFFN_ScopedZone& operator=(const GFFN_ScopedZone&) = delete;
+};
+
+// Call once at the end of every frame, on the sim thread. It also records the frame itself as a zone, and writes a
+// trace on its own if spike dumps are on (see init_from_environment).
+void mark_frame();
+std::uint64_t get_num_frames();
+
+// Every zone from the last num_frames frames on every thread, as Chrome trace event JSON.
+std::string to_chrome_trace(std::size_t num_frames = DEFAULT_DUMP_FRAMES);
+bool dump_chrome_trace(std::string const& filename, std::size_t num_frames = DEFAULT_DUMP_FRAMES);
+
+// Reads the trace settings from the environment:
+// - GFFN_TRACE_FILE: where dumps go, gffn_trace.json by default
+// - GFFN_TRACE_FRAMES: how many frames a dump covers, DEFAULT_DUMP_FRAMES by default
+// - GFFN_TRACE_SPIKE_MS: if set, any frame longer than this gets dumped automatically (at most once per dump's worth
+//   of frames, so a string of slow frames gives one trace)
+void init_from_environment();
+std::string const& get_trace_filename();
+std::size_t get_dump_frames();
+
+}} // end namespace gffn::profiler
+
+#ifdef GFFN_PROFILER
+#define GFFN_PROFILE_CONCAT_INNER(a, b) a##b
+#define GFFN_PROFILE_CONCAT(a, b) GFFN_PROFILE_CONCAT_INNER(a, b)
+#define GFFN_PROFILE_SCOPE(name) ::gffn::profiler::GFFN_ScopedZone GFFN_PROFILE_CONCAT(gffn_profile_zone_, __LINE__)(name)
+#define GFFN_PROFILE_FRAME() ::gffn::profiler::mark_frame()
+#define GFFN_PROFILE_THREAD_NAME(name) ::gffn::profiler::set_thread_name(name)
+#else
+#define GFFN_PROFILE_SCOPE(name) ((void)0)
+#define GFFN_PROFILE_FRAME() ((void)0)
+#define GFFN_PROFILE_THREAD_NAME(name) ((void)0)
+#endif
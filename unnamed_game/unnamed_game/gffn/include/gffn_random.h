@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace gffn {
+
+// xoshiro256** generator. 32 bytes of state, a handful of shifts and multiplies per number, and the same sequence for the
+// same seed on every platform, which std::uniform_*_distribution doesn't promise.
+// Satisfies UniformRandomBitGenerator, so it can still be handed to a std distribution if one is really needed.
+class GFFN_Rng {
+	std::array<std::uint64_t, 4> state;
+
+	static constexpr std::uint64_t rotl(std::uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+public:
+	typedef std::uint64_t result_type;
+
+	// Any seed is fine, 0 included. It's spread over the state with splitmix64.
+	explicit GFFN_Rng(std::uint64_t seed = 0) { reseed(seed); }
+
+	void reseed(std::uint64_t seed);
+
+	std::uint64_t next_u64() {
+		std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+		std::uint64_t t = state[1] << 17;
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+		return result;
+	}
+	std::uint32_t next_u32() { return (std::uint32_t)(next_u64() >> 32); }
+	// [0, 1)
+	double next_double() { return (double)(next_u64() >> 11) * 0x1.0p-53; }
+	float next_float() { return (float)(next_u64() >> 40) * 0x1.0p-24f; }
+	// [min, max)
+	double range(double min, double max) { return min + (max - min) * next_double(); }
+	float range(float min, float max) { return min + (max - min) * next_float(); }
+	// [min, max], both ends included. Multiply and shift instead of a modulo, the bias is under 2^-32 for any range we use.
+	int range_int(int min, int max) {
+		std::uint64_t span = (std::uint64_t)((std::int64_t)max - (std::int64_t)min) + 1;
+		return min + (int)((next_u32() * span) >> 32);
+	}
+	bool chance(double probability) { return next_double() < probability; }
+
+	result_type operator()() { return next_u64(); }
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+};
+
+// Every random number in the sim comes from here, so a run can be repeated from its master seed.
+// - get_thread_rng() is the calling thread's generator. Threads get stream 0, 1, 2... in the order they first ask for
+//   one, so the sim thread (which always asks first) is deterministic.
+// - make_stream(id) is a generator of its own for something that has to be reproducible regardless of what else drew
+//   numbers before it, like a job on a worker thread or one system's effects.
+// Changing the master seed reseeds every thread's generator the next time that thread asks for it.
+namespace random {
+
+// Stream ids handed to make_stream. Thread streams use ids from THREAD_STREAM_BASE up.
+typedef enum : std::uint64_t {
+	GFFN_RANDOM_STREAM_PARTICLES = 1,
+	GFFN_RANDOM_STREAM_WORLD_GEN,
+	GFFN_RANDOM_STREAM_GAMEPLAY,
+	GFFN_RANDOM_STREAM_THREAD_BASE = 1ull << 32
+} GFFN_RandomStream;
+
+void set_master_seed(std::uint64_t seed);
+std::uint64_t get_master_seed();
+GFFN_Rng make_stream(std::uint64_t stream_id);
+GFFN_Rng& get_thread_rng();
+
+// Shorthands on the calling thread's generator.
+inline double range(double min, double max) { return get_thread_rng().range(min, max); }
+inline float range(float min, float max) { return get_thread_rng().range(min, max); }
+inline int range_int(int min, int max) { return get_thread_rng().range_int(min, max); }
+inline bool chance(double probability) { return get_thread_rng().chance(probability); }
+
+} // end namespace random
+
+} // end namespace gffn
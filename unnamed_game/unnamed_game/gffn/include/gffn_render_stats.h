@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+struct SDL_Texture;
+
+namespace gffn { namespace render_stats {
+
+typedef struct FrameCounts {
+	std::uint32_t draw_calls;
+	std::uint32_t texture_binds; // draws whose texture differs from the draw before, which is what breaks a batch
+	std::uint32_t quads;
+} FrameCounts;
+
+// Only the thread that renders touches these.
+extern FrameCounts current_frame;
+extern FrameCounts last_frame;
+extern SDL_Texture* last_texture;
+
+// Call next to every SDL draw.
+inline void count_draw(SDL_Texture* texture, std::uint32_t num_quads = 1) {
+	current_frame.draw_calls++;
+	current_frame.quads += num_quads;
+	if (texture != last_texture) {
+		current_frame.texture_binds++;
+		last_texture = texture;
+	}
+}
+
+// Moves this frame's counts into last_frame. GFFN_GameWorld::tick calls it after presenting.
+inline void end_frame() {
+	last_frame = current_frame;
+	current_frame = FrameCounts{};
+	last_texture = nullptr;
+}
+
+}} // end namespace gffn::render_stats
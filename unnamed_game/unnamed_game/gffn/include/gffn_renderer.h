@@ -3,7 +3,9 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
 #include <variant>
+#include <span>
 
 #include <SDL.h>
 #include <SDL_render.h>
@@ -16,20 +18,42 @@
 #include <gffn_camera.h>
 #include <gffn_utils.h>
 #include <gffn_game_world_objects.h>
+#include <gffn_frame_arena.h>
+#include <gffn_memory.h>
+#include <gffn_particles.h>
+#include <gffn_decals.h>
+#include <gffn_profiler.h>
+#include <gffn_frame_stats.h>
 class GFFN_GameObject;
 
 namespace gffn {
 
+typedef struct GFFN_GroundTile {
+	SDL_Texture* texture;
+	int cell_x;
+	int cell_y;
+} GFFN_GroundTile;
+
 class GFFN_Renderer {
-	GFFN_Window window;
+	std::unique_ptr<GFFN_Window> window; // nullptr when headless
+	SDL_Surface* headless_surface = nullptr;
 	SDL_Renderer* renderer;
+	bool headless;
 	const int renderer_logical_width = RENDERER_LOGICAL_WIDTH;
 	const int renderer_logical_height = RENDERER_LOGICAL_HEIGHT;
 	std::unordered_map<std::string, SDL_Texture*> textures; // This maps filenames to textures, and the filenames will be used to retrieve the textures.
+	GFFN_DecalQueue decal_queue;
 public:
 	SDL_Texture* get_texture(std::string const &filename) { 
 		if(textures.count(filename) == 0) {
-			textures[filename] = IMG_LoadTexture(renderer, filename.c_str());
+			SDL_Texture* texture = IMG_LoadTexture(renderer, filename.c_str());
+			if (texture == nullptr && headless) {
+				// Benchmarks don't ship the textures. Anything that slices the texture up (animations, limbs) divides evenly.
+				texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 150, 400);
+			}
+			textures[filename] = texture;
+			memory::track_texture(textures[filename]);
+			frame_stats::count(GFFN_FRAME_COUNTER_TEXTURES_LOADED);
 		}
 		return textures[filename]; 
 	}
@@ -38,13 +62,20 @@ public:
 
 	std::unique_ptr<GFFN_MultiImage> character_dismemberment_images;
 
-	GFFN_Renderer(std::string const &game_name);
+	// A headless renderer has no window. Everything goes through a software renderer with a tiny target, so a tick still
+	// does all of its render prep (culling, sorting, decals, particle vertices) but drawing costs next to nothing.
+	GFFN_Renderer(std::string const &game_name, bool headless = false);
 	~GFFN_Renderer();
 	SDL_Renderer* get_sdl_renderer() { return renderer; }
+	bool is_headless() const { return headless; }
 	template <class T> void render_character_objects(std::shared_ptr<T> character, GFFN_Camera camera);
 	//template <class T> void render_object_relative_to_camera(std::shared_ptr<T> object, GFFN_Camera camera, bool render_shadow = true);
 	void render_object_relative_to_camera(GFFN_GameObject* const object, GFFN_Camera camera);
-	void render_everything_in_viewport(objects_by_y_t& game_world_objects, GFFN_Camera camera);
+	// Draws the world into the back buffer. Anything drawn after this (debug overlays) goes on top, then present().
+	void render_everything_in_viewport(objects_by_y_t& game_world_objects, GFFN_Camera camera, particles::ParticleSystem& particle_system);
+	void present();
+	// Draws each tile's texture over its 1m cell of the ground texture. Headless there's no ground to draw on.
+	void paint_ground_tiles(std::span<const GFFN_GroundTile> tiles);
 	WorldCoordinate get_mouse_position_as_coordinate(GFFN_Camera camera);
 	int get_renderer_width() {
 		int width;
@@ -57,8 +88,11 @@ public:
 		return height;
 	}
 
+	// Baked into the ground texture at the start of the next render, together with everything else that came to rest.
+	// The object can be removed right after this.
 	template <class T>
 	void bake_object_onto_floor(T* const object) {
+		GFFN_PROFILE_SCOPE("bake_object_onto_floor");
 		SDL_Rect object_rect = *object->get_render_rect();
 		SDL_Rect ground_object_rect = *ground_object->get_render_rect();
 		SDL_Rect object_rect_relative_to_ground = SDL_Rect(
@@ -67,12 +101,10 @@ public:
 			object_rect.w,
 			object_rect.h
 		);
-
-
-		SDL_SetRenderTarget(renderer, ground_object->get_texture());
-
-		SDL_RenderCopy(renderer, object->get_texture(), object->get_source_rect(), &object_rect_relative_to_ground);
+		decal_queue.push(object->get_texture(), object->get_source_rect(), object_rect_relative_to_ground);
 	}
+
+	GFFN_DecalQueue& get_decal_queue() { return decal_queue; }
 };
 
 } // end namespace gffn
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <gffn_utils.h>
+
+namespace gffn {
+
+typedef enum : unsigned char {
+	GFFN_SIMULATION_LOD_FULL,    // every tick
+	GFFN_SIMULATION_LOD_HALF,    // every 2nd tick
+	GFFN_SIMULATION_LOD_QUARTER, // every 4th tick
+	GFFN_SIMULATION_LOD_EIGHTH,  // every 8th tick
+	GFFN_SIMULATION_LOD_END,
+} GFFN_SimulationLODLevel;
+
+// Decides how often an object gets simulated, from how far it is from the camera or the player (whichever is closer).
+// Far objects tick every 2nd/4th/8th frame with the delta scaled up to match. Which frame an object gets is picked from
+// its id, so the far ones are spread evenly over the frames instead of all ticking on the same one.
+class GFFN_SimulationLOD {
+	WorldCoordinate camera_center;
+	WorldCoordinate player_coords;
+	bool has_player = false;
+	std::uint32_t frame = 0;
+	double delta_time_seconds = 0;
+	std::array<std::uint32_t, GFFN_SIMULATION_LOD_END> num_objects;      // per level, this frame
+	std::array<std::uint32_t, GFFN_SIMULATION_LOD_END> num_objects_ticked;
+public:
+	// Ring edges in world units. Past the last one is GFFN_SIMULATION_LOD_EIGHTH.
+	static constexpr double FULL_RATE_DISTANCE = 2000;
+	static constexpr double HALF_RATE_DISTANCE = 3500;
+	static constexpr double QUARTER_RATE_DISTANCE = 5500;
+
+	GFFN_SimulationLOD() {
+		num_objects.fill(0);
+		num_objects_ticked.fill(0);
+	}
+
+	// Call once at the start of every tick, before anything asks should_tick.
+	void begin_frame(double delta_time_seconds, WorldCoordinate camera_center);
+	void set_player_coords(WorldCoordinate player_coords) {
+		this->player_coords = player_coords;
+		has_player = true;
+	}
+
+	GFFN_SimulationLODLevel get_level(WorldCoordinate coords) const;
+	static int get_tick_period(GFFN_SimulationLODLevel level) { return 1 << level; }
+
+	// Whether the object ticks this frame. Doesn't change anything, so more than one system can ask about the same object.
+	bool ticks_this_frame(long unsigned int object_id, WorldCoordinate coords) const {
+		int period = get_tick_period(get_level(coords));
+		return ((frame + object_id) & (period - 1)) == 0;
+	}
+	// Same as ticks_this_frame, but also counts the object for the stats and hands back the delta to tick it with.
+	bool should_tick(long unsigned int object_id, WorldCoordinate coords, double& scaled_delta_time_seconds);
+
+	std::uint32_t get_num_objects(GFFN_SimulationLODLevel level) const { return num_objects[level]; }
+	std::uint32_t get_num_objects_ticked(GFFN_SimulationLODLevel level) const { return num_objects_ticked[level]; }
+};
+
+} // end namespace gffn
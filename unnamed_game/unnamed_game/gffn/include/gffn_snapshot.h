@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <SDL_rect.h>
+
+#include <gffn_utils.h>
+#include <gffn_physics.h>
+#include <gffn_animation.h>
+#include <gffn_flow_field.h>
+#include <gffn_simulation_lod.h>
+#include <gffn_random.h>
+
+namespace gffn {
+
+struct GFFN_ObjectVisuals;
+struct GFFN_NPCArchetype;
+
+// Everything about one game object that the sim reads, as of the snapshot. One fixed size record for every type, each
+// class's save_snapshot fills in its own part and leaves the rest. Textures, sheets and archetypes are flyweights that
+// live as long as the process, so they're kept as pointers: a snapshot is for rewinding this run, not for saving to disk.
+typedef struct GFFN_ObjectSnapshot {
+	static constexpr std::uint32_t NO_TIMER_MS = std::numeric_limits<std::uint32_t>::max();
+
+	long unsigned int object_id = 0;
+	GFFN_ObjectType object_type = GFFN_OBJECT_TYPE_CHARACTER;
+	// GFFN_GameObject
+	SDL_Rect render_rect{};
+	SDL_Rect source_rect{};
+	std::pair<int, int> grid_location;
+	double height_offset = 0;
+	const GFFN_ObjectVisuals* visuals = nullptr;
+	bool to_remove = false;
+	bool hidden = false;
+	bool has_source_rect = false;
+	// GFFN_Movable
+	physics::ObjectPhysicsController physics{ WorldCoordinate(0, 0, 0), 0 };
+	// GFFN_Character
+	physics::NormalizedVector3D look_direction;
+	const GFFN_AnimationSheet* animation_sheet = nullptr;
+	short animation_fps = 0;
+	short animation_state = 0;
+	short animation_frame = 0;
+	bool dead = false;
+	int hp = 0;
+	// GFFN_NPC
+	const GFFN_NPCArchetype* archetype = nullptr;
+	unsigned char npc_state = 0;
+	unsigned char patrol_state = 0;
+	// The NPC's patrol wait or the projectile's life timer, NO_TIMER_MS if it has none running.
+	std::uint32_t timer_ms_left = NO_TIMER_MS;
+	std::uint64_t timer_sequence = 0; // its place among timers firing in the same tick
+	// GFFN_StraightProjectile
+	physics::Vector3D propulsion_force;
+	int explosion_power = 0;
+	int explosion_min_damage = 0;
+	int explosion_blast_radius = 0;
+} GFFN_ObjectSnapshot;
+
+// The whole sim at one point between two ticks, taken with GFFN_GameWorld::capture_snapshot and put back with
+// restore_snapshot. Objects are flat records in tick order, the rest is copied as is. The flow field is in here because
+// it's cheaper to copy (~100KB) than to search again, and the NPCs would chase differently while it caught up.
+// Not in here: particles and baked decals (looks only), the camera (input), and events still queued between ticks.
+// Capturing into a snapshot that was used before reuses its buffers, so it doesn't allocate unless the world grew.
+typedef struct GFFN_WorldSnapshot {
+	std::vector<GFFN_ObjectSnapshot> objects;
+	double timer_elapsed_seconds = 0;
+	std::uint64_t timer_next_sequence = 0;
+	GFFN_Rng rng;
+	long unsigned int next_object_id = 0;
+	long unsigned int chase_target_id = 0;
+	bool has_chase_target = false;
+	GFFN_FlowField chase_field;
+	GFFN_SimulationLOD simulation_lod;
+
+	int num_characters = 0;
+	int num_npcs = 0;
+	int num_ui_objects = 0;
+	int num_dismembered_body_parts = 0;
+	int num_environmental_objects = 0;
+	int num_straight_projectiles = 0;
+
+	bool is_empty() const { return objects.empty(); }
+	std::size_t get_storage_bytes() const { return objects.capacity() * sizeof(GFFN_ObjectSnapshot); }
+} GFFN_WorldSnapshot;
+
+// The last few snapshots for rolling back. Once it's full, every push overwrites the oldest one and reuses its buffers.
+class GFFN_SnapshotRing {
+	std::vector<GFFN_WorldSnapshot> snapshots;
+	std::size_t newest = 0;
+	std::size_t count = 0;
+public:
+	explicit GFFN_SnapshotRing(std::size_t capacity) : snapshots(capacity) {}
+
+	// The slot to capture the next snapshot into.
+	GFFN_WorldSnapshot& push() {
+		newest = (newest + 1) % snapshots.size();
+		count = std::min(count + 1, snapshots.size());
+		return snapshots[newest];
+	}
+	// 0 is the newest, nullptr if there aren't that many.
+	GFFN_WorldSnapshot* get(std::size_t num_back) {
+		if (num_back >= count) {
+			return nullptr;
+		}
+		return &snapshots[(newest + snapshots.size() - num_back) % snapshots.size()];
+	}
+	// Forgets the newest, so rolling back again goes further back.
+	void pop() {
+		if (count > 0) {
+			newest = (newest + snapshots.size() - 1) % snapshots.size();
+			count--;
+		}
+	}
+	void clear() { count = 0; }
+
+	std::size_t size() const { return count; }
+	std::size_t capacity() const { return snapshots.size(); }
+};
+
+} // end namespace gffn
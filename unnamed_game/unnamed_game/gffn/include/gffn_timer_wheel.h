@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace gffn {
+
+typedef std::uint64_t timer_id_t;
+static constexpr timer_id_t NO_TIMER = 0;
+
+// Hierarchical timer wheel in sim time. Level 0 has one slot per millisecond for the next 64 ms, every level up has
+// slots 64 times as wide, and when a lower level wraps around the matching slot of the level above is spread back down.
+// Scheduling and cancelling are O(1), and advancing only touches the slots that are passed plus the timers in them, so
+// 10k sleeping timers cost nothing until they fire.
+// Timers that expire in the same millisecond fire in the order they were scheduled, by a sequence number every timer gets
+// when it's scheduled. A snapshot saves those numbers and puts them back, so a restored world fires in the same order.
+// Not thread safe, the wheel belongs to the sim thread.
+class GFFN_TimerWheel {
+public:
+	typedef void (*callback_t)(void* data);
+
+	static constexpr int BITS_PER_LEVEL = 6;
+	static constexpr int SLOTS_PER_LEVEL = 1 << BITS_PER_LEVEL;
+	static constexpr int NUM_LEVELS = 4; // 64^4 ms, about 4.6 hours. Anything later goes in the last slot and waits.
+
+private:
+	static constexpr std::uint32_t NO_NODE = 0xFFFFFFFF;
+
+	typedef struct TimerNode {
+		std::uint64_t expire_tick;
+		std::uint64_t sequence; // order of scheduling, breaks ties between timers expiring in the same tick
+		callback_t callback;
+		void* data;
+		std::uint32_t previous;
+		std::uint32_t next;
+		std::uint32_t generation; // bumped on every reuse, so a stale id can't cancel someone else's timer
+		std::uint16_t slot;       // level * SLOTS_PER_LEVEL + index, only valid while linked
+		bool linked;
+	} TimerNode;
+
+	std::vector<TimerNode> nodes;
+	std::vector<std::uint32_t> free_nodes;
+	std::array<std::uint32_t, NUM_LEVELS * SLOTS_PER_LEVEL> slots;
+	std::vector<timer_id_t> firing; // kept around so advancing doesn't allocate
+	std::uint64_t current_tick = 0;
+	std::uint64_t next_sequence = 0;
+	double elapsed_seconds = 0;
+	std::size_t num_pending = 0;
+	std::size_t num_fired_last_advance = 0;
+
+	static timer_id_t make_id(std::uint32_t index, std::uint32_t generation) {
+		return ((timer_id_t)generation << 32) | (timer_id_t)(index + 1);
+	}
+	TimerNode* get_node(timer_id_t timer_id);
+	void link(std::uint32_t index);
+	void unlink(std::uint32_t index);
+	void release(std::uint32_t index);
+	void cascade(int level);
+public:
+	GFFN_TimerWheel() { slots.fill(NO_NODE); }
+	GFFN_TimerWheel(const GFFN_TimerWheel&) = delete;
+	GFFN_TimerWheel& operator=(const GFFN_TimerWheel&) = delete;
+
+	// Calls callback(data) once delay_ms of sim time has passed. A delay of 0 fires on the next advance.
+	timer_id_t schedule(std::uint64_t delay_ms, callback_t callback, void* data);
+	timer_id_t schedule_seconds(double delay_seconds, callback_t callback, void* data) {
+		return schedule(seconds_to_ms(delay_seconds), callback, data);
+	}
+	static std::uint64_t seconds_to_ms(double seconds) { return seconds <= 0 ? 0 : (std::uint64_t)(seconds * 1000.0 + 0.5); }
+	// Room for num_timers more pending timers without the node storage growing, for batch spawns.
+	void reserve(std::size_t num_timers) {
+		if (num_timers > free_nodes.size()) {
+			nodes.reserve(nodes.size() + num_timers - free_nodes.size());
+		}
+	}
+	// Where the timer is in the firing order and whoever restores it has to give that back with set_sequence, 0 if it
+	// isn't pending.
+	std::uint64_t get_sequence(timer_id_t timer_id);
+	void set_sequence(timer_id_t timer_id, std::uint64_t sequence);
+	// Returns false if it already fired or was cancelled.
+	bool cancel(timer_id_t timer_id);
+	bool is_pending(timer_id_t timer_id) { return get_node(timer_id) != nullptr; }
+	// How long until it fires, 0 if it isn't pending.
+	std::uint64_t get_ms_left(timer_id_t timer_id);
+
+	// Moves sim time forward and fires everything that expired, in expiry order and then scheduling order. Callbacks can schedule and cancel timers,
+	// including ones that were about to fire this advance.
+	void advance(double delta_time_seconds);
+
+	// Drops every pending timer without firing it and moves sim time to elapsed_seconds, backwards too. For restoring a
+	// world snapshot, whoever owned a timer schedules it again and sets its old sequence, and timers scheduled after that
+	// carry on from next_sequence. Ids from before are stale afterwards, cancelling one is a no-op.
+	void reset(double elapsed_seconds, std::uint64_t next_sequence);
+
+	std::uint64_t get_current_ms() const { return current_tick; }
+	double get_elapsed_seconds() const { return elapsed_seconds; }
+	std::uint64_t get_next_sequence() const { return next_sequence; }
+	std::size_t get_num_pending() const { return num_pending; }
+	std::size_t get_num_fired_last_advance() const { return num_fired_last_advance; }
+};
+
+// The sim thread's wheel. GFFN_GameWorld::tick advances it once per tick, before the objects tick.
+extern GFFN_TimerWheel timer_wheel;
+
+} // end namespace gffn
@@ -6,12 +6,14 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <random>
 #include <unordered_set>
 #include <SDL.h>
 #include <format>
+#include <cstddef>
+#include <type_traits>
 
 #include <gffn_exception.h>
+#include <gffn_random.h>
 
 namespace gffn {
 
@@ -49,11 +51,8 @@ typedef struct Range {
     double min;
     double max;
     Range(double min, double max) : min(min), max(max) {}
-    double get_rand_in_range() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> dis(min, max);
-        return dis(gen);
+    double get_rand_in_range() const {
+        return random::range(min, max);
     }
 } Range;
 
@@ -93,18 +92,26 @@ public:
     }
 };
 
+// The math types are templated on their scalar. The plain names (WorldCoordinate, physics::Vector3D, ...) are double,
+// which is what gameplay code and tools pass around. The *f ones are float padded out to 16 bytes, one aligned SSE load
+// per coordinate, for the physics state every object carries and the hot loops that go through a lot of them. Going
+// between the two is always explicit.
+template <typename T>
+inline constexpr std::size_t MATH_ALIGNMENT = std::is_same_v<T, float> ? 16 : alignof(T);
+
 // There's issue with things being very close to zero, so this function will make sure that doesn't happen.
-static void verify_normalized_vector(double &x, double &y, double &z) {
+template <typename T>
+static void verify_normalized_vector(T &x, T &y, T &z) {
     int num_zeros = 0;
-    if (FP_ZERO == fpclassify(x)) {
+    if (FP_ZERO == std::fpclassify(x)) {
         //x = 0.0000001;
         num_zeros++;
     }
-    if (FP_ZERO == fpclassify(y)) {
+    if (FP_ZERO == std::fpclassify(y)) {
         //y = 0.0000001;
         num_zeros++;
     }
-    if (FP_ZERO == fpclassify(z)) {
+    if (FP_ZERO == std::fpclassify(z)) {
         //z = 0.0000001;
         num_zeros++;
     }
@@ -113,42 +120,49 @@ static void verify_normalized_vector(double &x, double &y, double &z) {
 	}
 }
 
-typedef struct WorldCoordinate {
-    double x;
-    double y;
-    double z;
-
-    WorldCoordinate(double x, double y, double z) : x(x), y(y), z(z) {}
-    WorldCoordinate() : x(0), y(0), z(0) {}
-    WorldCoordinate(const WorldCoordinate& other) : x(other.x), y(other.y), z(other.z) {}
-    double distance_from(WorldCoordinate from) const {
-        double x_component = from.x - x;
-        double y_component = from.y - y;
-        double z_component = from.z - z;
+template <typename T>
+struct alignas(MATH_ALIGNMENT<T>) BasicWorldCoordinate {
+    T x;
+    T y;
+    T z;
+
+    BasicWorldCoordinate(T x, T y, T z) : x(x), y(y), z(z) {}
+    BasicWorldCoordinate() : x(0), y(0), z(0) {}
+    template <typename U>
+    explicit BasicWorldCoordinate(BasicWorldCoordinate<U> const& other) : x((T)other.x), y((T)other.y), z((T)other.z) {}
+    T distance_from(BasicWorldCoordinate from) const {
+        T x_component = from.x - x;
+        T y_component = from.y - y;
+        T z_component = from.z - z;
         //unzero_3D(x_component, y_component, z_component);
 
-        return sqrt((x_component * x_component) + (y_component * y_component) + (z_component * z_component));
+        return std::sqrt((x_component * x_component) + (y_component * y_component) + (z_component * z_component));
     }
 
-    double distance_from_squared_xy(WorldCoordinate from) const {
-        double x_component = from.x - x;
-		double y_component = from.y - y;
+    T distance_from_squared_xy(BasicWorldCoordinate from) const {
+        T x_component = from.x - x;
+		T y_component = from.y - y;
 		//unzero_2D(x_component, y_component);
 
 		return (x_component * x_component) + (y_component * y_component);
     }
 
-    WorldCoordinate get_coordinate_between(WorldCoordinate other) {
-        return WorldCoordinate((x + other.x) / 2.0, (y + other.y) / 2.0, (z + other.z) / 2.0);
+    BasicWorldCoordinate get_coordinate_between(BasicWorldCoordinate other) {
+        return BasicWorldCoordinate((x + other.x) / 2, (y + other.y) / 2, (z + other.z) / 2);
     }
-    WorldCoordinate get_coordinate_between_percent_from_source(WorldCoordinate other, double percent) const {
-        double x_component = other.x - x;
-        double y_component = other.y - y;
-        double z_component = other.z - z;
+    BasicWorldCoordinate get_coordinate_between_percent_from_source(BasicWorldCoordinate other, T percent) const {
+        T x_component = other.x - x;
+        T y_component = other.y - y;
+        T z_component = other.z - z;
         percent /= 100;
-        return WorldCoordinate(x + (x_component * percent), y + (y_component * percent), z + (z_component * percent));
+        return BasicWorldCoordinate(x + (x_component * percent), y + (y_component * percent), z + (z_component * percent));
     }
-} WorldCoordinate;
+};
+
+typedef BasicWorldCoordinate<double> WorldCoordinate;
+typedef BasicWorldCoordinate<float> WorldCoordinatef;
+static_assert(sizeof(WorldCoordinate) == 24, "WorldCoordinate should stay three doubles");
+static_assert(sizeof(WorldCoordinatef) == 16 && alignof(WorldCoordinatef) == 16, "WorldCoordinatef should be one float4");
 
 typedef struct WorldCoordinateInt2D {
 	int x;
@@ -156,13 +170,16 @@ typedef struct WorldCoordinateInt2D {
 	WorldCoordinateInt2D(int x, int y) : x(x), y(y) {}
 	WorldCoordinateInt2D() : x(0), y(0) {}
 	WorldCoordinateInt2D(const WorldCoordinateInt2D& other) : x(other.x), y(other.y) {}
-    WorldCoordinateInt2D(const WorldCoordinate& other) : x((int)other.x), y((int)other.y) {}
+    // Rounds down, so coordinates just left of or above 0 land on -1 instead of also on 0 like (int) would.
+    template <typename T>
+    explicit WorldCoordinateInt2D(BasicWorldCoordinate<T> const& other) : x((int)std::floor(other.x)), y((int)std::floor(other.y)) {}
 } WorldCoordinateInt2D;
 
 static constexpr int FLOOR_COORDS_Y_OFFSET = -20;
 
 static WorldCoordinateInt2D calculate_top_left_coords_from_floor_coords(WorldCoordinate floor_coords, int width, int height) {
-    WorldCoordinateInt2D top_left_coords((int)floor_coords.x - (width / 2), (int)floor_coords.y - height - FLOOR_COORDS_Y_OFFSET);
+    WorldCoordinateInt2D floor_pixel(floor_coords);
+    WorldCoordinateInt2D top_left_coords(floor_pixel.x - (width / 2), floor_pixel.y - height - FLOOR_COORDS_Y_OFFSET);
     return top_left_coords;
 }
 
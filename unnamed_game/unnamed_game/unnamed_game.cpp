@@ -17,6 +17,11 @@
 #include <gffn_utils.h>
 #include <gffn_window.h>
 #include <gffn_physics.h>
+#include <gffn_memory.h>
+#include <gffn_input.h>
+#include <gffn_profiler.h>
+#include <gffn_frame_stats.h>
+#include <gffn_level.h>
 
 #include <chrono>
 #include <csignal>
@@ -25,11 +30,67 @@
 #include <memory>
 #include <thread>
 #include <random>
+#include <span>
+#include <string>
+#include <algorithm>
 
 int main(int argc, char* argv[]) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<> world_coord_rand(100, gffn::WORLD_GRID_WIDTH*99);
+    // --record <file> saves every tick's input and the seed, --replay <file> plays a recording back. Both run the sim at
+    // a fixed timestep so the same session can be replayed against any build.
+    // --hitch-log <file> appends every hitch (a frame much slower than the ones before it) to file.
+    // --level <file> fills the world from a level file instead of scattering trees and goblins at random.
+    std::string record_filename;
+    std::string replay_filename;
+    std::string hitch_log_filename;
+    std::string level_filename;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--record") {
+            record_filename = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--replay") {
+            replay_filename = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--hitch-log") {
+            hitch_log_filename = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--level") {
+            level_filename = argv[++i];
+        }
+    }
+    const bool replaying = !replay_filename.empty();
+    // T writes the last frames as a Chrome trace. GFFN_TRACE_SPIKE_MS=<ms> does it on its own for any frame slower than that.
+    gffn::profiler::init_from_environment();
+    if (!hitch_log_filename.empty() && !gffn::frame_stats::open_hitch_log(hitch_log_filename)) {
+        std::cout << "Couldn't open " << hitch_log_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    GFFN_PROFILE_THREAD_NAME("sim");
+    gffn::input::GFFN_InputReplay replay;
+    if (replaying) {
+        try {
+            if (!replay.load(replay_filename)) {
+                std::cout << "Couldn't open " << replay_filename << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        catch (std::exception& e) {
+            std::cout << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        gffn::random::set_master_seed(replay.get_seed());
+    }
+    else {
+        // Fresh seed every run, printed so an interesting run can be repeated.
+        gffn::random::set_master_seed(((std::uint64_t)std::random_device{}() << 32) | std::random_device{}());
+    }
+    std::cout << "Seed: " << gffn::random::get_master_seed() << std::endl;
+    gffn::input::GFFN_InputRecorder recorder;
+    if (!record_filename.empty() && !recorder.open(record_filename, gffn::random::get_master_seed(), gffn::input::DEFAULT_FIXED_DELTA_TIME_SECONDS)) {
+        std::cout << "Couldn't write " << record_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+    const bool fixed_timestep = replaying || recorder.is_recording();
+    const double fixed_delta_time_seconds = replaying ? replay.get_fixed_delta_time_seconds() : gffn::input::DEFAULT_FIXED_DELTA_TIME_SECONDS;
 
     /*try {*/
         if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
@@ -51,22 +112,43 @@ int main(int argc, char* argv[]) {
 
         game_world.camera.zoom(1.5);
 
-        SDL_Texture* texture = IMG_LoadTexture(renderer.get_sdl_renderer(), "textures/alexs_pine_tree.png");
+        if (!level_filename.empty()) {
+            // Only mapped while loading, the objects don't point back into it.
+            gffn::GFFN_Level level;
+            try {
+                if (!level.load(level_filename)) {
+                    std::cout << "Couldn't open " << level_filename << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+            catch (std::exception& e) {
+                std::cout << e.what() << std::endl;
+                return EXIT_FAILURE;
+            }
+            auto level_start = std::chrono::high_resolution_clock::now();
+            std::size_t num_loaded = game_world.load_level(level);
+            std::cout << "Loaded " << num_loaded << " objects from " << level_filename << " in "
+                << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - level_start).count() << " ms" << std::endl;
+        }
+        else {
+            SDL_Texture* texture = IMG_LoadTexture(renderer.get_sdl_renderer(), "textures/alexs_pine_tree.png");
 
-        for (int i = 0; i < 1000; i++) {
-            double x = world_coord_rand(gen);
-            double y = world_coord_rand(gen);
+            for (int i = 0; i < 1000; i++) {
+                double x = gffn::random::range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
+                double y = gffn::random::range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
             
-            std::unique_ptr<gffn::GFFN_GameObject> env_obj = 
-                std::make_unique<gffn::GFFN_EnvironmentalObject>(gffn::WorldCoordinate(x, y, 0), texture, renderer.get_texture("textures/small_shadow.png"));
+                gffn::GFFN_ObjectPtr env_obj = 
+                    gffn::make_pooled_object<gffn::GFFN_EnvironmentalObject>(gffn::WorldCoordinate(x, y, 0), texture, renderer.get_texture("textures/small_shadow.png"));
 
-            game_world.add_object(env_obj);
+                game_world.add_object(env_obj);
+            }
         }
 
         gffn::GFFN_Character* player_character = nullptr;
+        long unsigned int player_character_id = 0;
 
         {
-            std::unique_ptr<gffn::GFFN_GameObject> object = std::make_unique<gffn::GFFN_Character>(
+            gffn::GFFN_ObjectPtr object = gffn::make_pooled_object<gffn::GFFN_Character>(
                 gffn::GFFN_ObjectType::GFFN_OBJECT_TYPE_CHARACTER,
                 renderer.get_texture("textures/wizard/generic.png"),
                 renderer.get_texture("textures/character_shadow.png"),
@@ -74,175 +156,217 @@ int main(int argc, char* argv[]) {
                 gffn::WorldCoordinate(gffn::WORLD_GRID_WIDTH * 50, gffn::WORLD_GRID_HEIGHT * 50, 0)
             );
             player_character = static_cast<gffn::GFFN_Character*>(object.get());
-            long unsigned int player_character_id = game_world.add_object(object);
+            player_character_id = game_world.add_object(object);
+            game_world.set_chase_target(player_character_id);
         }
 
-        for (int i = 0; i < 1000; i++) {
-            double x = world_coord_rand(gen);
-            double y = world_coord_rand(gen);
-
+        if (level_filename.empty()) {
             gffn::NPC_info npc_info;
-            npc_info.floor_coords = gffn::WorldCoordinate(x, y, 0);
             npc_info.animation_texture = renderer.get_texture("textures/goblin/goblin_1.png");
             npc_info.shadow_texture = renderer.get_texture("textures/character_shadow.png");
             //npc_info.hp = 5; TODO add this
             npc_info.animation_fps = 5;
             npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
 
-            std::unique_ptr<gffn::GFFN_GameObject> npc = std::make_unique<gffn::GFFN_NPC>(npc_info);
-            game_world.add_object(npc);
+            std::vector<gffn::WorldCoordinate> npc_positions;
+            for (int i = 0; i < 1000; i++) {
+                double x = gffn::random::range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
+                double y = gffn::random::range(100.0, gffn::WORLD_GRID_WIDTH * 99.0);
+                npc_positions.emplace_back(x, y, 0);
+            }
+            game_world.spawn_npcs(npc_info, npc_positions);
         }
 
+        // Looked up once here so the main loop doesn't build strings every time it spawns something.
+        SDL_Texture* const goblin_texture = renderer.get_texture("textures/goblin/goblin_1.png");
+        SDL_Texture* const character_shadow_texture = renderer.get_texture("textures/character_shadow.png");
+        SDL_Texture* const throwable_explosive_texture = renderer.get_texture("textures/throwable_explosive.png");
+        SDL_Texture* const small_shadow_texture = renderer.get_texture("textures/small_shadow.png");
+
+        // R puts the whole world back the way it started. F9 rolls back to the newest of the snapshots taken every
+        // SNAPSHOT_INTERVAL_TICKS, pressing it again goes further back. Counted in ticks so replays roll back the same.
+        constexpr int SNAPSHOT_INTERVAL_TICKS = 60;
+        gffn::GFFN_WorldSnapshot start_snapshot;
+        game_world.capture_snapshot(start_snapshot);
+        gffn::GFFN_SnapshotRing rollback_snapshots(10);
+        int ticks_since_snapshot = 0;
+
         bool close_window = false;
         auto previous_time = std::chrono::high_resolution_clock::now();
         auto second_timer_start = std::chrono::high_resolution_clock::now();
+        auto replay_start = std::chrono::high_resolution_clock::now();
         int frames = 0;
         while (close_window == false) {
+            // Frame time for the stats is this iteration start to end, present included. wall_delta_time_seconds is the
+            // gap since the previous iteration, which is the time the last frame took, not this one.
+            auto frame_start = std::chrono::high_resolution_clock::now();
             frames++;
             auto delta_time = std::chrono::high_resolution_clock::now() - previous_time;
             auto second_timer_end = std::chrono::high_resolution_clock::now();
             if (std::chrono::duration_cast<std::chrono::duration<double>>(second_timer_end - second_timer_start).count() > 1.0) {
                 std::cout << "----------- debug info -------------" << std::endl;
                 std::cout << "FPS: " << frames << std::endl;
+                gffn::GFFN_TimingPercentiles frame_times = gffn::frame_stats::get_frame_window().get_percentiles();
+                gffn::GFFN_TimingPercentiles tick_times = gffn::frame_stats::get_tick_window().get_percentiles();
+                std::cout << std::format("Frame ms p50 {:.2f}, p95 {:.2f}, p99 {:.2f}, max {:.2f}. Tick ms p50 {:.2f}, p99 {:.2f}. Hitches: {}",
+                    frame_times.p50_ms, frame_times.p95_ms, frame_times.p99_ms, frame_times.max_ms, tick_times.p50_ms, tick_times.p99_ms,
+                    gffn::frame_stats::get_num_hitches()) << std::endl;
                 std::cout << "Num characters: " << game_world.num_characters << std::endl;
                 std::cout << "Num NPCs: " << game_world.num_npcs << std::endl;
                 std::cout << "Num straight projectiles: " << game_world.num_straight_projectiles << std::endl;
                 std::cout << "Num dismembered body parts: " << game_world.num_dismembered_body_parts << std::endl;
+                std::cout << "Decals baked last frame: " << renderer.get_decal_queue().get_num_flushed_last_frame()
+                    << ", pending: " << renderer.get_decal_queue().get_num_pending() << std::endl;
                 std::cout << "Num environmental objects: " << game_world.num_environmental_objects << std::endl;
+                std::cout << "Timers pending: " << gffn::timer_wheel.get_num_pending() << ", fired last tick: " << gffn::timer_wheel.get_num_fired_last_advance() << std::endl;
+                std::cout << "Physics awake: " << game_world.num_awake_objects << ", asleep: " << game_world.num_asleep_objects << std::endl;
+                std::cout << "Simulation LOD (ticked/total) full: "
+                    << game_world.simulation_lod.get_num_objects_ticked(gffn::GFFN_SIMULATION_LOD_FULL) << "/" << game_world.simulation_lod.get_num_objects(gffn::GFFN_SIMULATION_LOD_FULL)
+                    << ", 1/2: " << game_world.simulation_lod.get_num_objects_ticked(gffn::GFFN_SIMULATION_LOD_HALF) << "/" << game_world.simulation_lod.get_num_objects(gffn::GFFN_SIMULATION_LOD_HALF)
+                    << ", 1/4: " << game_world.simulation_lod.get_num_objects_ticked(gffn::GFFN_SIMULATION_LOD_QUARTER) << "/" << game_world.simulation_lod.get_num_objects(gffn::GFFN_SIMULATION_LOD_QUARTER)
+                    << ", 1/8: " << game_world.simulation_lod.get_num_objects_ticked(gffn::GFFN_SIMULATION_LOD_EIGHTH) << "/" << game_world.simulation_lod.get_num_objects(gffn::GFFN_SIMULATION_LOD_EIGHTH) << std::endl;
+                std::cout << "Memory: " << gffn::memory::get_total_live_bytes() / 1024 << " KB live, "
+                    << gffn::memory::get_total_reserved_bytes() / 1024 << " KB reserved" << std::endl;
+                for (int i = 0; i < gffn::GFFN_MEMORY_TAG_END; i++) {
+                    gffn::memory::TagStats const& stats = gffn::memory::get_stats((gffn::GFFN_MemoryTag)i);
+                    std::cout << "  " << gffn::memory::get_tag_name((gffn::GFFN_MemoryTag)i) << ": " << stats.get_live_bytes() / 1024
+                        << " KB (peak " << stats.peak_bytes / 1024 << " KB), " << stats.last_frame_allocations << " allocs last frame" << std::endl;
+                }
                 frames = 0;
                 second_timer_start = std::chrono::high_resolution_clock::now();
             }
             previous_time = std::chrono::high_resolution_clock::now();
-            double delta_time_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(delta_time).count();
-            gffn::WorldCoordinate mouse_position_coord = game_world.get_mouse_position_as_coordinate(renderer);
+            double wall_delta_time_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(delta_time).count();
+            // Live input is still read while replaying so the window can be closed.
+            gffn::input::InputFrame input;
+            {
+                GFFN_PROFILE_SCOPE("read_live_input");
+                input = gffn::input::read_live_input(renderer, game_world.camera);
+            }
+            if (replaying) {
+                if (input.quit || input.was_pressed(gffn::input::GFFN_INPUT_KEY_ESCAPE)) {
+                    close_window = true;
+                }
+                if (!replay.next_frame(input)) {
+                    double replay_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - replay_start).count();
+                    std::cout << "Replayed " << replay.get_num_frames_played() << " ticks in " << replay_seconds << " s, "
+                        << replay_seconds * 1000.0 / std::max<std::size_t>(replay.get_num_frames_played(), 1) << " ms per tick" << std::endl;
+                    break;
+                }
+            }
+            else {
+                input.delta_time_seconds = fixed_timestep ? fixed_delta_time_seconds : wall_delta_time_seconds;
+            }
+            recorder.record(input);
+            double delta_time_seconds = input.delta_time_seconds;
+            gffn::WorldCoordinate mouse_position_coord = input.mouse_coords;
             gffn::WorldCoordinate player_pointer_coord = mouse_position_coord;
 
-            SDL_Event e;
-            if (SDL_PollEvent(&e) > 0) {
-                if (e.type == SDL_QUIT) {
-                    close_window = true;
+            if (input.quit || input.was_pressed(gffn::input::GFFN_INPUT_KEY_ESCAPE)) {
+                close_window = true;
+            }
+            if (input.was_pressed(gffn::input::GFFN_INPUT_KEY_R)) {
+                game_world.restore_snapshot(start_snapshot);
+                rollback_snapshots.clear();
+                ticks_since_snapshot = 0;
+            }
+            if (input.was_pressed(gffn::input::GFFN_INPUT_KEY_F9)) {
+                if (gffn::GFFN_WorldSnapshot* snapshot = rollback_snapshots.get(0)) {
+                    game_world.restore_snapshot(*snapshot);
+                    rollback_snapshots.pop();
+                    ticks_since_snapshot = 0;
                 }
-                if (e.type == SDL_KEYDOWN) {
-                    if (e.key.keysym.scancode == SDL_SCANCODE_ESCAPE) {
-                        close_window = true;
-                    }
-                    if (e.key.keysym.scancode == SDL_SCANCODE_SPACE) {
-                        //player_character->throw_to(mouse_position_coord, 500.0);
-                        //player_character->add_force(gffn::physics::Vector3D(0, 0, 20000.0));
-                    }
-                    //if (e.key.keysym.scancode == SDL_SCANCODE_F) {  // Place character :)
-                    //    std::shared_ptr<gffn::GFFN_NPC> npc = std::make_shared<gffn::GFFN_NPC>(
-                    //        gffn::GFFN_ObjectType::GFFN_OBJECT_TYPE_NPC,
-                    //        renderer.get_sdl_renderer(),
-                    //        renderer.animation_textures.at(gffn::GFFN_CharacterType::GFFN_GOBLIN_1),
-                    //        renderer.still_textures.at(gffn::GFFN_TextureEnum::GFFN_TEXTURE_CHARACTER_SHADOW),
-                    //        5,
-                    //        mouse_position_coord
-                    //    );
-                    //    game_world.add_object<gffn::GFFN_NPC>(npc);
-                    //}
-                    if (e.key.keysym.scancode == SDL_SCANCODE_R) {
-                        player_character->set_floor_coords(gffn::WorldCoordinate(gffn::WORLD_GRID_WIDTH*50,gffn::WORLD_GRID_HEIGHT*50, 0));
-                        player_character->change_hp(100);
-					}
+            }
+            if (input.was_pressed(gffn::input::GFFN_INPUT_KEY_M)) {
+                if (gffn::memory::dump_json("memory_stats.json")) {
+                    std::cout << "Wrote memory_stats.json" << std::endl;
                 }
-                if (e.type == SDL_MOUSEBUTTONDOWN) {
-                    /*if (e.button.button == SDL_BUTTON_LEFT) {
-                        if (!player_character->is_being_thrown()) {
-                            std::shared_ptr<gffn::GFFN_StraightProjectile> projectile = std::make_shared<gffn::GFFN_StraightProjectile>(
-                                player_character->get_floor_coords(),
-                                mouse_position_coord,
-                                1500.0,
-                                2.0,
-                                renderer.still_textures.at(gffn::GFFN_TextureEnum::GFFN_TEXTURE_THROWABLE_EXPLOSIVE),
-                                renderer.still_textures.at(gffn::GFFN_TextureEnum::GFFN_TEXTURE_SMALL_SHADOW)
-                            );
-                            game_world.add_object<gffn::GFFN_StraightProjectile>(projectile);
-                        }
-                    }*/
+            }
+            if (input.was_pressed(gffn::input::GFFN_INPUT_KEY_F3)) {
+                game_world.show_performance_overlay = !game_world.show_performance_overlay;
+            }
+            if (input.was_pressed(gffn::input::GFFN_INPUT_KEY_T)) {
+                if (gffn::profiler::dump_chrome_trace(gffn::profiler::get_trace_filename(), gffn::profiler::get_dump_frames())) {
+                    std::cout << "Wrote the last " << gffn::profiler::get_dump_frames() << " frames to " << gffn::profiler::get_trace_filename() << std::endl;
                 }
-                if (e.type == SDL_MOUSEWHEEL) {
-                    static double zoom_factor = 1.5;
-                	if (e.wheel.y > 0) {
-                        zoom_factor -= 0.1;
-					}
-					else if (e.wheel.y < 0) {
-                        zoom_factor += 0.1;
-					}
-
-                    if (zoom_factor > 5.0) {
-                        zoom_factor = 5.0;
-					}
-                    else if (zoom_factor < 0.2) {
-						zoom_factor = 0.2;
-                    }
-                    game_world.camera.zoom(zoom_factor);
+            }
+            if (input.wheel != 0) {
+                static double zoom_factor = 1.5;
+                zoom_factor -= 0.1 * input.wheel;
+                if (zoom_factor > 5.0) {
+                    zoom_factor = 5.0;
+                }
+                else if (zoom_factor < 0.2) {
+                    zoom_factor = 0.2;
                 }
+                game_world.camera.zoom(zoom_factor);
             }
 
-
-
-            const Uint8* keystate = SDL_GetKeyboardState(nullptr);
+            // Looked up every frame rather than kept from setup, so nothing that replaces the object (restoring a snapshot)
+            // can leave this dangling. The world never removes the player, when it dies it stays dead until R.
+            player_character = static_cast<gffn::GFFN_Character*>(game_world.game_world_objects.get_object(player_character_id));
+            const bool player_alive = !player_character->is_dead();
+            static bool player_death_reported = false;
+            if (!player_alive && !player_death_reported) {
+                std::cout << "You died, press R to start over" << std::endl;
+            }
+            player_death_reported = !player_alive;
 
             // Player movement
             gffn::physics::Vector3D player_move_vector; // will be normalized later
             bool player_move_key_pressed = false;
-            if (keystate[SDL_SCANCODE_A]) {
+            if (input.is_held(gffn::input::GFFN_INPUT_KEY_A)) {
                 player_move_vector.x -= 1;
                 player_move_key_pressed = true;
                 //player_character->add_force(gffn::physics::Vector3D(-100.0, 0, 0));
             }
-            if (keystate[SDL_SCANCODE_D]) {
+            if (input.is_held(gffn::input::GFFN_INPUT_KEY_D)) {
                 player_move_vector.x += 1;
                 player_move_key_pressed = true;
                 //player_character->add_force(gffn::physics::Vector3D(100.0, 0, 0));
             }
-            if (keystate[SDL_SCANCODE_W]) {
+            if (input.is_held(gffn::input::GFFN_INPUT_KEY_W)) {
                 player_move_vector.y -= 1;
                 player_move_key_pressed = true;
                 //player_character->add_force(gffn::physics::Vector3D(0, -100.0, 0));
             }
-            if (keystate[SDL_SCANCODE_S]) {
+            if (input.is_held(gffn::input::GFFN_INPUT_KEY_S)) {
                 player_move_vector.y += 1;
                 player_move_key_pressed = true;
                 //player_character->add_force(gffn::physics::Vector3D(0, 100.0, 0));
             }
-            if (keystate[SDL_SCANCODE_SPACE]) {
+            if (player_alive && input.is_held(gffn::input::GFFN_INPUT_KEY_SPACE)) {
                 player_character->add_force(gffn::physics::Vector3D(0, 0, 500000.0));
             }
-            if (keystate[SDL_SCANCODE_F]) {
+            if (input.is_held(gffn::input::GFFN_INPUT_KEY_F)) {
                 gffn::NPC_info npc_info;
-                npc_info.floor_coords = mouse_position_coord;
-                npc_info.animation_texture = renderer.get_texture("textures/goblin/goblin_1.png");
-                npc_info.shadow_texture = renderer.get_texture("textures/character_shadow.png");
+                npc_info.animation_texture = goblin_texture;
+                npc_info.shadow_texture = character_shadow_texture;
                 //npc_info.hp = 5; TODO add this
                 npc_info.animation_fps = 5;
                 npc_info.character_type = gffn::GFFN_CharacterType::GFFN_GOBLIN_1;
 
-                std::unique_ptr<gffn::GFFN_GameObject> npc = std::make_unique<gffn::GFFN_NPC>(npc_info);
-                game_world.add_object(npc);
+                // Through the batch path too, so the new NPC is on the grid (and can be hit) this tick.
+                game_world.spawn_npcs(npc_info, std::span<const gffn::WorldCoordinate>(&mouse_position_coord, 1));
 			}
 
-            if (!player_move_vector.is_zero()) {
+            if (player_alive && !player_move_vector.is_zero()) {
                 gffn::physics::NormalizedVector3D player_move_vector_normalized(player_move_vector);
                 gffn::physics::Vector3D player_move_force(player_move_vector_normalized.x*300000.0, player_move_vector_normalized.y* 300000.0, 0);
                 player_character->add_force(player_move_force);
             }
             // Handle camera positioning
             game_world.camera.move_to_position(player_character->get_center_coords());
-            const Uint32 mouse_state = SDL_GetMouseState(nullptr, nullptr);
-            if (mouse_state & SDL_BUTTON(SDL_BUTTON_MIDDLE)) {
-				gffn::WorldCoordinate mouse_coordinates = game_world.get_mouse_position_as_coordinate(renderer);
+            if (input.is_mouse_down(gffn::input::GFFN_INPUT_MOUSE_MIDDLE)) {
                 gffn::WorldCoordinate player_coordinates = player_character->get_floor_coords();
-                gffn::WorldCoordinate center_coordinates = player_coordinates.get_coordinate_between_percent_from_source(mouse_coordinates, 99);
+                gffn::WorldCoordinate center_coordinates = player_coordinates.get_coordinate_between_percent_from_source(mouse_position_coord, 99);
                 game_world.camera.move_to_position(center_coordinates);
 			}
-            if (mouse_state & SDL_BUTTON(SDL_BUTTON_LEFT)) {
-                static std::uniform_real_distribution<> shooting_random(-14.0, 14.0);
+            if (player_alive && input.is_mouse_down(gffn::input::GFFN_INPUT_MOUSE_LEFT)) {
                 static double time_since_last_throw = 100.0;
                 time_since_last_throw += delta_time_seconds;
                 gffn::physics::NormalizedVector3D player_to_mouse_vector(player_character->get_floor_coords(), mouse_position_coord);
-                player_to_mouse_vector.rotate_xy(shooting_random(gen));
+                player_to_mouse_vector.rotate_xy(gffn::random::range(-14.0, 14.0));
                 gffn::physics::Vector3D vec = player_to_mouse_vector.get_vector3d();
                 vec = vec * 50;
                 gffn::WorldCoordinate projectile_start_coords = player_character->get_floor_coords();
@@ -250,23 +374,45 @@ int main(int argc, char* argv[]) {
                 projectile_start_coords.y += vec.y;
                 if (time_since_last_throw > 0.01) {
                     time_since_last_throw = 0;
-                    std::unique_ptr<gffn::GFFN_StraightProjectile> projectile = std::make_unique<gffn::GFFN_StraightProjectile>(
+                    gffn::GFFN_PooledPtr<gffn::GFFN_StraightProjectile> projectile = gffn::make_pooled_object<gffn::GFFN_StraightProjectile>(
                         projectile_start_coords,
                         player_to_mouse_vector,
                         5000,
                         2.0,
-                        renderer.get_texture("textures/throwable_explosive.png"),
-                        renderer.get_texture("textures/small_shadow.png")
+                        throwable_explosive_texture,
+                        small_shadow_texture
                     );
                     double character_height = player_character->get_physics_controller().get_floor_coords().z;
                     projectile->get_physics_controller().set_height(character_height+100);
 
-                    std::unique_ptr<gffn::GFFN_GameObject> projectile_ptr = std::move(projectile);
+                    gffn::GFFN_ObjectPtr projectile_ptr = std::move(projectile);
                     game_world.add_object(projectile_ptr);
                 }
             }
 
-            gffn::WorldCoordinate mouse_coordinates = game_world.get_mouse_position_as_coordinate(renderer);
+            if (player_alive && input.is_mouse_down(gffn::input::GFFN_INPUT_MOUSE_RIGHT)) {
+                static double time_since_last_explosive = 100.0;
+                time_since_last_explosive += delta_time_seconds;
+                if (time_since_last_explosive > 0.3) {
+                    time_since_last_explosive = 0;
+                    gffn::physics::NormalizedVector3D player_to_mouse_vector(player_character->get_floor_coords(), mouse_position_coord);
+                    gffn::GFFN_PooledPtr<gffn::GFFN_StraightProjectile> explosive = gffn::make_pooled_object<gffn::GFFN_StraightProjectile>(
+                        player_character->get_floor_coords(),
+                        player_to_mouse_vector,
+                        3000,
+                        0.6,
+                        throwable_explosive_texture,
+                        small_shadow_texture
+                    );
+                    explosive->set_explosive(120, 250, 20);
+                    explosive->get_physics_controller().set_height(player_character->get_physics_controller().get_floor_coords().z + 100);
+
+                    gffn::GFFN_ObjectPtr explosive_ptr = std::move(explosive);
+                    game_world.add_object(explosive_ptr);
+                }
+            }
+
+            gffn::WorldCoordinate mouse_coordinates = mouse_position_coord;
             player_character->look_at(mouse_coordinates);
             gffn::WorldCoordinate player_coordinates = player_character->get_floor_coords();
             gffn::physics::NormalizedVector3D player_direction(player_coordinates, mouse_coordinates);
@@ -325,6 +471,7 @@ int main(int argc, char* argv[]) {
                     player_character->set_animation_state(gffn::GFFN_CharacterAnimationState::GFFN_ANIMATION_WALK_TOP_RIGHT);
                 }
             }
+            auto tick_start = std::chrono::high_resolution_clock::now();
             try {
                 game_world.tick(renderer, delta_time_seconds);
             }
@@ -332,6 +479,18 @@ int main(int argc, char* argv[]) {
 				std::cout << e.what() << std::endl;
 				return EXIT_FAILURE;
 			}
+            double tick_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tick_start).count();
+            if (++ticks_since_snapshot >= SNAPSHOT_INTERVAL_TICKS) {
+                game_world.capture_snapshot(rollback_snapshots.push());
+                ticks_since_snapshot = 0;
+            }
+            double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - frame_start).count();
+            gffn::frame_stats::end_frame(frame_ms, tick_ms);
+            GFFN_PROFILE_FRAME();
+        }
+        if (recorder.is_recording()) {
+            recorder.close();
+            std::cout << "Recorded " << recorder.get_num_frames() << " ticks to " << record_filename << std::endl;
         }
         SDL_Quit();
     /*}